@@ -12,7 +12,7 @@ image::image(image_metadata info, image_flags flags, void* data) :
 image::~image()
 { 
     if( m_data && owns_data() )
-        delete[] m_data;
+        delete[] static_cast<u8*>(m_data);
 }
 
 image::image(const image& other) :
@@ -31,7 +31,7 @@ image::image(const image& other) :
 image& image::operator=(const image& other)
 {
     if( m_data && (m_flags & image_flag_bits::owns_data) )
-        delete[] m_data;
+        delete[] static_cast<u8*>(m_data);
 
     m_metadata = other.m_metadata;
     m_flags = other.m_flags;
@@ -11,6 +11,9 @@ class image_loader
 public:
     static std::unique_ptr<image> from_file_png(sys::path path);
     static std::unique_ptr<image> from_memory_png(void* pData, u64 size);
+
+    // 8 bits per channel only, false if the format isn't or the file can't be written.
+    static bool to_file_png(const sys::path& path, image& image);
 public:
     image_loader() = delete;
     ~image_loader() = delete;
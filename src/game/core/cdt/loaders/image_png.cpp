@@ -1,5 +1,3 @@
-#pragma once
-
 #include "image_loaders.h"
 #include "system/device.h"
 
@@ -50,4 +48,15 @@ std::unique_ptr<image> image_loader::from_file_png(sys::path path)
     return retval;
 }
 
+bool image_loader::to_file_png(const sys::path& path, image& image)
+{
+    const image_metadata& metadata = image.get_metadata();
+    u32 channels = get_channel_count(metadata.format);
+    if( get_bits_per_pixel(metadata.format) != channels * 8 )
+        return false;
+
+    i32 stride = i32_cast(metadata.width * channels);
+    return stbi_write_png(path.c_str(), i32_cast(metadata.width), i32_cast(metadata.height), i32_cast(channels), image.data(), stride) != 0;
+}
+
 } // cdt
\ No newline at end of file
@@ -111,7 +111,7 @@ public:
     glm::vec3 max;
 };
 
-inline static aabb3 aabb3_empty
+inline aabb3 aabb3_empty
 {
     { f32_max, f32_max, f32_max },
     { f32_min, f32_min, f32_min }
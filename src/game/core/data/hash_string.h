@@ -86,6 +86,7 @@ public:
     #ifndef CFG_FINAL
         stream << std::format(" ({})", output.m_debugCopy);
     #endif
+        return stream;
     }
 
     inline size_t get_hash() const
@@ -7,7 +7,7 @@ namespace dt
 {
 
 SYSDECLARE_CHANNEL(hash_string);
-#define HASHSTR_ASSERT(cond, fmt, ...) SYSASSERT(cond, SYSMSG_CHANNEL_FATAL(hash_string, fmt, __VA_ARGS__))
+#define HASHSTR_ASSERT(cond, fmt, ...) SYSASSERT(cond, SYSMSG_CHANNEL_FATAL(hash_string, fmt, ##__VA_ARGS__))
 
 enum hash_string_type
 {
@@ -52,4 +52,4 @@
 
 #define DELETE_MOVE(classname) \
     classname(classname&&) = delete;\
-    classname& operator=(classname&&) = delete
\ No newline at end of file
+    classname& operator=(classname&&) = delete
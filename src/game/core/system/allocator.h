@@ -1,9 +1,30 @@
 #pragma once
 #include "system_channel.h"
+#include <cstdlib>
 
 namespace sys
 {
 
+// _aligned_malloc is MSVC only and its memory can't be released with free, so everything goes through these.
+inline void* aligned_malloc(u64 size, u64 align)
+{
+#ifdef _MSC_VER
+    return _aligned_malloc(size, align);
+#else
+    // aligned_alloc wants the size to be a multiple of the alignment.
+    return std::aligned_alloc(align, (size + align - 1) & ~(align - 1));
+#endif // _MSC_VER
+}
+
+inline void aligned_free(void* ptr)
+{
+#ifdef _MSC_VER
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif // _MSC_VER
+}
+
 class allocator
 {
 public:
@@ -1,5 +1,6 @@
 #include "assert.h"
 
+#ifdef PLATFORM_WINDOWS
 #ifndef NOMINMAX
     #define NOMINMAX
 #endif // NOMINMAX
@@ -9,6 +10,10 @@
 // https://stackoverflow.com/questions/4845198/fatal-error-no-target-architecture-in-visual-studio
 #include "Windows.h"
 #include "debugapi.h"
+#endif // PLATFORM_WINDOWS
+
+#include <cassert>
+#include <cstdlib>
 
 #include <iostream>
 #include <sstream>
@@ -85,6 +90,8 @@ static quit_message_generator g_quitMessageGenerator = default_message_generator
 void quit(const channel& channel)
 {
     g_quitHandler(channel, g_quitMessageGenerator(channel));
+    // quit is noreturn, so a handler that comes back still has to end the process.
+    std::abort();
 }
 
 void fast_quit()
@@ -104,7 +111,11 @@ void set_quit_message_generator(quit_message_generator func)
 
 bool is_debugger_present()
 {
+#ifdef PLATFORM_WINDOWS
     return IsDebuggerPresent();
+#else
+    return false;
+#endif // PLATFORM_WINDOWS
 }
 
 static void default_message_callback(const channel& channel, severity level, std::string formatted_message)
@@ -11,13 +11,13 @@ basic_allocator*  basic_allocator::get()
 
 void* basic_allocator::do_allocate(u64 size, u64 align)
 {
-    return _aligned_malloc(size, align);
+    return aligned_malloc(size, align);
 }
 
 void basic_allocator::do_free(void* ptr, u64 size)
 {
     (void)size;
-    _aligned_free(ptr);
+    aligned_free(ptr);
 }
 
 } // sys
\ No newline at end of file
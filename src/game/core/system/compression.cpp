@@ -0,0 +1,31 @@
+#include "compression.h"
+#include "stb_image.h"
+
+#include <cstdlib>
+
+// Defined by the stb_image_write implementation in image_png.cpp but only declared in its implementation section.
+extern "C" unsigned char* stbi_zlib_compress(unsigned char* data, int data_len, int* out_len, int quality);
+
+namespace sys
+{
+
+std::vector<u8> zlib_compress(std::span<const u8> data, i32 level)
+{
+    i32 compressed_size = 0;
+    u8* compressed = stbi_zlib_compress(const_cast<u8*>(data.data()), i32_cast(data.size()), &compressed_size, level);
+    if( !compressed )
+        return { };
+
+    std::vector<u8> result(compressed, compressed + compressed_size);
+    free(compressed);
+    return result;
+}
+
+bool zlib_decompress(std::span<const u8> data, std::span<u8> destination)
+{
+    i32 decompressed_size = stbi_zlib_decode_buffer(reinterpret_cast<char*>(destination.data()), i32_cast(destination.size()),
+        reinterpret_cast<const char*>(data.data()), i32_cast(data.size()));
+    return decompressed_size >= 0 && u64_cast(decompressed_size) == destination.size();
+}
+
+} // sys
\ No newline at end of file
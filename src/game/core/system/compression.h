@@ -0,0 +1,16 @@
+#pragma once
+#include <span>
+#include <vector>
+
+namespace sys
+{
+
+// zlib streams, through the stb deflate and inflate that core already builds for png.
+// Level is the deflate quality, higher is smaller and slower, 5 is stb's default for png.
+std::vector<u8> zlib_compress(std::span<const u8> data, i32 level = 5);
+
+// Inflates into destination, which must be exactly the size of the original data. False if the stream is corrupt
+// or doesn't decompress to that size.
+bool zlib_decompress(std::span<const u8> data, std::span<u8> destination);
+
+} // sys
\ No newline at end of file
@@ -1,6 +1,7 @@
 ﻿#include "log_console.h"
 
 #include <iostream>
+#include <cstring>
 #include "helpers/string_manip.h"
 
 namespace sys
@@ -10,6 +11,13 @@ namespace log
 namespace details
 {
 
+static u32 thread_id_to_u32(std::thread::id id)
+{
+    u32 value = 0;
+    memcpy(&value, &id, std::min(sizeof(value), sizeof(id)));
+    return value;
+}
+
 console_target::console_target() :
     m_levelToColor(u8_cast(level::count))
 {
@@ -31,7 +39,7 @@ void console_target::output(message* msg)
     for( std::string line : split_string(msg->text, "\n") )
     {
         std::cout << std::format("[tid:{:0>8}] [{}{: <5}{}] [{: ^10}] {}\n",
-            *(u32*)&msg->threadid,
+            thread_id_to_u32(msg->threadid),
             color_to_code(m_levelToColor[u8_cast(msg->lvl)]),
             level_to_string(msg->lvl),
             color_to_code(color::none),
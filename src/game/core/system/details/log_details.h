@@ -13,6 +13,8 @@ namespace details
 class target
 {
 public:
+    virtual ~target() = default;
+
     virtual void output(message* msg) = 0;
 };
 
@@ -39,6 +41,7 @@ class log_manager
 {
 public:
     log_manager(level verbosity);
+    virtual ~log_manager() = default;
 
     void add_message(message&& msg);
 
@@ -18,7 +18,7 @@ struct message
     channel chnl;
     level lvl;
     std::thread::id threadid = std::this_thread::get_id();
-    std::chrono::steady_clock::time_point timestamp = std::chrono::high_resolution_clock::now();
+    std::chrono::steady_clock::time_point timestamp = std::chrono::steady_clock::now();
 };
 
 } // details
@@ -110,7 +110,7 @@ void fi_device::seek(u64 byte_offset)
     else
         m_pos = m_size;
 
-    m_handle.seekg(byte_offset, std::ios_base::right);
+    m_handle.seekg(std::streamoff(byte_offset), std::ios_base::cur);
 }
 
 void fi_device::seek_back(u64 byte_offset)
@@ -122,7 +122,7 @@ void fi_device::seek_back(u64 byte_offset)
     else
         m_pos = m_size;
 
-    m_handle.seekg(byte_offset, std::ios_base::left);
+    m_handle.seekg(-std::streamoff(byte_offset), std::ios_base::cur);
 }
 
 bool fi_device::eof() const
@@ -11,48 +11,48 @@ namespace log
 
 details::log_manager* s_log = nullptr;
 
-int log::initialise(details::log_manager* log)
+int initialise(details::log_manager* log)
 {
     s_log = log;
     return 1;
 }
 
-void log::shutdown()
+void shutdown()
 {
     delete s_log;
 }
 
-void log::message(std::string message, channel chnl, level lvl)
+void message(std::string message, channel chnl, level lvl)
 {
     s_log->add_message({ message, chnl, lvl });
 }
 
-void log::profile(std::string message, channel chnl)
+void profile(std::string message, channel chnl)
 {
     log::message(message, chnl, level::profile);
 }
 
-void log::info(std::string message, channel chnl)
+void info(std::string message, channel chnl)
 {
     log::message(message, chnl, level::info);
 }
 
-void log::warn(std::string message, channel chnl)
+void warn(std::string message, channel chnl)
 {
     log::message(message, chnl, level::warn);
 }
 
-void log::error(std::string message, channel chnl)
+void error(std::string message, channel chnl)
 {
     log::message(message, chnl, level::error);
 }
 
-void log::fatal(std::string message, channel chnl)
+void fatal(std::string message, channel chnl)
 {
     log::message(message, chnl, level::fatal);
 }
 
-void log::force_flush()
+void force_flush()
 {
     s_log->flush();
 }
@@ -1,5 +1,6 @@
 ﻿#pragma once
 
+#include <cstring>
 #include <format>
 
 namespace sys
@@ -55,23 +56,23 @@ void messagef(channel chnl, level lvl, std::string format, A&&... args)
     message(std::vformat(format, std::make_format_args(args...)), chnl, lvl);
 }
 
-#define CHANNEL_LOG_MSG(chnl, fmt, ...) ::sys::log::messagef(chnl, ::sys::log::level::none, fmt, __VA_ARGS__)
-#define CHANNEL_LOG_VERBOSE(chnl, fmt, ...) ::sys::log::messagef(chnl, ::sys::log::level::verbose, fmt, __VA_ARGS__)
-#define CHANNEL_LOG_PROFILE(chnl, fmt, ...) ::sys::log::messagef(chnl, ::sys::log::level::profile, fmt, __VA_ARGS__)
-#define CHANNEL_LOG_DEBUG(chnl, fmt, ...) ::sys::log::messagef(chnl, ::sys::log::level::debug, fmt, __VA_ARGS__)
-#define CHANNEL_LOG_INFO(chnl, fmt, ...) ::sys::log::messagef(chnl, ::sys::log::level::info, fmt, __VA_ARGS__)
-#define CHANNEL_LOG_WARN(chnl, fmt, ...) ::sys::log::messagef(chnl, ::sys::log::level::warn, fmt, __VA_ARGS__)
-#define CHANNEL_LOG_ERROR(chnl, fmt, ...) ::sys::log::messagef(chnl, ::sys::log::level::error, fmt, __VA_ARGS__)
-#define CHANNEL_LOG_FATAL(chnl, fmt, ...) ::sys::log::messagef(chnl, ::sys::log::level::fatal, fmt, __VA_ARGS__)
-
-#define SYSLOG_MSG(fmt, ...) CHANNEL_LOG_MSG(::sys::log::channel::none, fmt, __VA_ARGS__)
-#define SYSLOG_VERBOSE(fmt, ...) CHANNEL_LOG_VERBOSE(::sys::log::channel::none, fmt, __VA_ARGS__)
-#define SYSLOG_PROFILE(fmt, ...) CHANNEL_LOG_PROFILE(::sys::log::channel::none, fmt, __VA_ARGS__)
-#define SYSLOG_DEBUG(fmt, ...) CHANNEL_LOG_DEBUG(::sys::log::channel::none, fmt, __VA_ARGS__)
-#define SYSLOG_INFO(fmt, ...) CHANNEL_LOG_INFO(::sys::log::channel::none, fmt, __VA_ARGS__)
-#define SYSLOG_WARN(fmt, ...) CHANNEL_LOG_WARN(::sys::log::channel::none, fmt, __VA_ARGS__)
-#define SYSLOG_ERROR(fmt, ...) CHANNEL_LOG_ERROR(::sys::log::channel::none, fmt, __VA_ARGS__)
-#define SYSLOG_FATAL(fmt, ...) CHANNEL_LOG_FATAL(::sys::log::channel::none, fmt, __VA_ARGS__)
+#define CHANNEL_LOG_MSG(chnl, fmt, ...) ::sys::log::messagef(chnl, ::sys::log::level::none, fmt, ##__VA_ARGS__)
+#define CHANNEL_LOG_VERBOSE(chnl, fmt, ...) ::sys::log::messagef(chnl, ::sys::log::level::verbose, fmt, ##__VA_ARGS__)
+#define CHANNEL_LOG_PROFILE(chnl, fmt, ...) ::sys::log::messagef(chnl, ::sys::log::level::profile, fmt, ##__VA_ARGS__)
+#define CHANNEL_LOG_DEBUG(chnl, fmt, ...) ::sys::log::messagef(chnl, ::sys::log::level::debug, fmt, ##__VA_ARGS__)
+#define CHANNEL_LOG_INFO(chnl, fmt, ...) ::sys::log::messagef(chnl, ::sys::log::level::info, fmt, ##__VA_ARGS__)
+#define CHANNEL_LOG_WARN(chnl, fmt, ...) ::sys::log::messagef(chnl, ::sys::log::level::warn, fmt, ##__VA_ARGS__)
+#define CHANNEL_LOG_ERROR(chnl, fmt, ...) ::sys::log::messagef(chnl, ::sys::log::level::error, fmt, ##__VA_ARGS__)
+#define CHANNEL_LOG_FATAL(chnl, fmt, ...) ::sys::log::messagef(chnl, ::sys::log::level::fatal, fmt, ##__VA_ARGS__)
+
+#define SYSLOG_MSG(fmt, ...) CHANNEL_LOG_MSG(::sys::log::channel::none, fmt, ##__VA_ARGS__)
+#define SYSLOG_VERBOSE(fmt, ...) CHANNEL_LOG_VERBOSE(::sys::log::channel::none, fmt, ##__VA_ARGS__)
+#define SYSLOG_PROFILE(fmt, ...) CHANNEL_LOG_PROFILE(::sys::log::channel::none, fmt, ##__VA_ARGS__)
+#define SYSLOG_DEBUG(fmt, ...) CHANNEL_LOG_DEBUG(::sys::log::channel::none, fmt, ##__VA_ARGS__)
+#define SYSLOG_INFO(fmt, ...) CHANNEL_LOG_INFO(::sys::log::channel::none, fmt, ##__VA_ARGS__)
+#define SYSLOG_WARN(fmt, ...) CHANNEL_LOG_WARN(::sys::log::channel::none, fmt, ##__VA_ARGS__)
+#define SYSLOG_ERROR(fmt, ...) CHANNEL_LOG_ERROR(::sys::log::channel::none, fmt, ##__VA_ARGS__)
+#define SYSLOG_FATAL(fmt, ...) CHANNEL_LOG_FATAL(::sys::log::channel::none, fmt, ##__VA_ARGS__)
 
 #define SYSLOG_FORCEFLUSH() ::sys::log::force_flush()
 
@@ -1,20 +1,30 @@
 #include "param.h"
 
+#include <cstring>
+#include <fstream>
+#include <list>
+
 namespace sys
 {
 
 namespace
 {
 std::vector<const char*> s_args{ };
+std::vector<std::string> s_includes{ };
+// Args read from included files, s_args points into these so they have to outlive it.
+std::list<std::string> s_includedArgs{ };
 } //
 
 const char* param::find_arg(const char* search_arg, u64 length)
 {
-    for( const char* arg : s_args )
+    // Search backwards so later args (e.g. the command line after an &include) override earlier ones.
+    for( auto it = s_args.rbegin(); it != s_args.rend(); ++it )
     {
-        if( !strncmp(arg, search_arg, length) )
+        // Whole names only, so e.g. -trajectory_level=1 isn't taken for -trajectory.
+        const char* arg = *it;
+        if( !strncmp(arg, search_arg, length) && (arg[length] == '\0' || arg[length] == '=') )
         {
-            return arg;
+            return *it;
         }
     }
 
@@ -125,16 +135,14 @@ i64 param::as_i64() const
 
 void param::init(const std::vector<const char*>& args)
 {
-    std::vector<const char*> includeList;
-
     for( const char* arg : args )
     {
         if( *arg == '&' )
         {
             bool already_included = false;
-            for( const char* include : includeList )
+            for( const std::string& include : s_includes )
             {
-                if( !strcmp(include, arg + 1) )
+                if( include == arg + 1 )
                 {
                     already_included = true;
                     break;
@@ -146,6 +154,7 @@ void param::init(const std::vector<const char*>& args)
                 continue;
             }
 
+            s_includes.push_back(arg + 1);
             include(arg + 1);
             continue;
         }
@@ -168,7 +177,25 @@ void param::init(const std::vector<const char*>& args)
 
 void param::include(const char* filename)
 {
-    // TODO
+    std::ifstream file(filename);
+    if( !file.is_open() )
+        return;
+
+    // Same format as the command line, whitespace separated args with # commenting out the rest of a line.
+    std::vector<const char*> args;
+    std::string line;
+    while( std::getline(file, line) )
+    {
+        std::istringstream tokens(line.substr(0, line.find('#')));
+        std::string token;
+        while( tokens >> token )
+        {
+            s_includedArgs.push_back(token);
+            args.push_back(s_includedArgs.back().c_str());
+        }
+    }
+
+    init(args);
 }
 
 const std::vector<const char*>& param::get_registered_args()
@@ -26,7 +26,7 @@ static constexpr long long minutes_in_hour = static_cast<long long>(60);
 
 [[nodiscard]] static moment now()
 {
-    return std::chrono::high_resolution_clock::now();
+    return std::chrono::steady_clock::now();
 }
 
 template<typename fidelity>   
@@ -4,6 +4,12 @@
     #define NOMINMAX
 #endif // NOMINMAX
 
+#ifndef _MSC_VER
+    #define __forceinline inline __attribute__((always_inline))
+    #define __debugbreak() __builtin_trap()
+#endif // _MSC_VER
+
+#include <cstdint>
 #include <type_traits>
 #include <limits>
 
@@ -53,42 +59,42 @@ using f64 = double;
 #define f64_min -f64_max
 #define f64_cast(v) static_cast<f64>(v)
 
-constexpr u64 operator "" _KiB(u64 in)
+constexpr u64 operator "" _KiB(unsigned long long in)
 {
     return in * 1024;
 }
 
-constexpr u64 operator "" _KB(u64 in)
+constexpr u64 operator "" _KB(unsigned long long in)
 {
     return in * 1000;
 }
 
-constexpr u64 operator "" _MiB(u64 in)
+constexpr u64 operator "" _MiB(unsigned long long in)
 {
     return operator""_KiB(in) * 1024;
 }
 
-constexpr u64 operator "" _MB(u64 in)
+constexpr u64 operator "" _MB(unsigned long long in)
 {
     return operator""_KB(in) * 1000;
 }
 
-constexpr u64 operator "" _GiB(u64 in)
+constexpr u64 operator "" _GiB(unsigned long long in)
 {
     return operator""_MiB(in) * 1024;
 }
 
-constexpr u64 operator "" _GB(u64 in)
+constexpr u64 operator "" _GB(unsigned long long in)
 {
     return operator""_MB(in) * 1000;
 }
 
-constexpr u64 operator "" _TiB(u64 in)
+constexpr u64 operator "" _TiB(unsigned long long in)
 {
     return operator""_GiB(in) * 1024;
 }
 
-constexpr u64 operator "" _TB(u64 in)
+constexpr u64 operator "" _TB(unsigned long long in)
 {
     return operator""_GB(in) * 1000;
 }
\ No newline at end of file
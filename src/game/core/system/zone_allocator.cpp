@@ -81,12 +81,12 @@ void memory_zone::track_free(u64 size)
 void* zone_allocator::do_allocate(u64 size, u64 align)
 {
     find_memory_zone(get_current_zone())->track_allocation(size);
-    return _aligned_malloc(size, align);
+    return aligned_malloc(size, align);
 }
 
 void zone_allocator::do_free(void* ptr, u64 size)
 {
-    _aligned_free(ptr);
+    aligned_free(ptr);
     find_memory_zone(get_current_zone())->track_free(size);
 }
 
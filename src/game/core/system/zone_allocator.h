@@ -85,12 +85,12 @@ private:
     public:
         static void* allocate(u64 size, u64 align)
         {
-            return _aligned_malloc(size, align);
+            return aligned_malloc(size, align);
         }
 
         static void free(void* ptr, u64 unused)
         {
-            return _aligned_free(ptr);
+            return aligned_free(ptr);
         }
     };
 
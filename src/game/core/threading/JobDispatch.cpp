@@ -103,10 +103,29 @@ JobDispatch& JobDispatch::instance()
 std::atomic<uint32_t>* JobDispatch::execute(const std::function<void()>& job)
 {
     std::atomic<uint32_t>* retval = request_atomic_counter(1u);
+    push_execute(retval, job);
+    return retval;
+}
+
+void JobDispatch::execute_and_wait(const std::function<void()>& job)
+{
+    // The counter lives on this stack rather than in m_counters, so waiting is safe from any thread
+    // and isn't affected by reset_counters.
+    std::atomic<uint32_t> counter{ 1u };
+    push_execute(&counter, job);
+    while( counter.load() != 0u )
+    {
+        poll();
+    }
+    instance().m_wakeCondition.notify_one();
+    return;
+}
 
-    std::function<void()> trackedJob = [retval, &job]{
+void JobDispatch::push_execute(std::atomic<uint32_t>* counter, const std::function<void()>& job)
+{
+    std::function<void()> trackedJob = [counter, &job]{
         job();
-        (*retval)--;
+        (*counter)--;
     };
 
     while( !instance().m_jobPool.push_back(trackedJob) )
@@ -114,14 +133,21 @@ std::atomic<uint32_t>* JobDispatch::execute(const std::function<void()>& job)
         poll();
     }
     instance().m_wakeCondition.notify_one();
+}
 
+std::atomic<uint32_t>* JobDispatch::dispatch(uint32_t jobCount, uint32_t groupSize, const std::function<void(DispatchState)>& job)
+{
+    std::atomic<uint32_t>* retval = request_atomic_counter(jobCount);
+    push_dispatch(retval, jobCount, groupSize, job);
     return retval;
 }
 
-void JobDispatch::execute_and_wait(const std::function<void()>& job)
+void JobDispatch::dispatch_and_wait(uint32_t jobCount, uint32_t groupSize, const std::function<void(DispatchState)>& job)
 {
-    std::atomic<uint32_t>* counter = execute(job);
-    while( counter->load() != 0u )
+    // Same as execute_and_wait, a stack counter keeps this usable from threads other than the main one.
+    std::atomic<uint32_t> counter{ jobCount };
+    push_dispatch(&counter, jobCount, groupSize, job);
+    while( counter.load() != 0u )
     {
         poll();
     }
@@ -129,14 +155,12 @@ void JobDispatch::execute_and_wait(const std::function<void()>& job)
     return;
 }
 
-std::atomic<uint32_t>* JobDispatch::dispatch(uint32_t jobCount, uint32_t groupSize, const std::function<void(DispatchState)>& job)
+void JobDispatch::push_dispatch(std::atomic<uint32_t>* counter, uint32_t jobCount, uint32_t groupSize, const std::function<void(DispatchState)>& job)
 {
-    std::atomic<uint32_t>* retval = request_atomic_counter(jobCount);
-
     if( jobCount == 0 || groupSize == 0 )
     {
-        retval->store(0u);
-        return retval;
+        counter->store(0u);
+        return;
     }
 
     uint32_t groupCount = (jobCount + groupSize - 1) / groupSize;
@@ -156,7 +180,7 @@ std::atomic<uint32_t>* JobDispatch::dispatch(uint32_t jobCount, uint32_t groupSi
                 state.jobIndex = groupStartIndex + jobGroupIndex;
 
                 job(state);
-                (*retval)--;
+                (*counter)--;
             }
 
         };
@@ -168,17 +192,4 @@ std::atomic<uint32_t>* JobDispatch::dispatch(uint32_t jobCount, uint32_t groupSi
 
         instance().m_wakeCondition.notify_one();
     }
-
-    return retval;
 }
-
-void JobDispatch::dispatch_and_wait(uint32_t jobCount, uint32_t groupSize, const std::function<void(DispatchState)>& job)
-{
-    std::atomic<uint32_t>* counter = dispatch(jobCount, groupSize, job);
-    while( counter->load() != 0u )
-    {
-        poll();
-    }
-    instance().m_wakeCondition.notify_one();
-    return;
-}
\ No newline at end of file
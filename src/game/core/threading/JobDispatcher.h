@@ -2,6 +2,8 @@
 
 #include <functional>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include "Queue.h"
 #include "threading.h"
 
@@ -45,6 +47,8 @@ public:
     static void poll();
 private:
     static std::atomic<uint32_t>* request_atomic_counter(uint32_t initialValue);
+    static void push_execute(std::atomic<uint32_t>* counter, const std::function<void()>& job);
+    static void push_dispatch(std::atomic<uint32_t>* counter, uint32_t jobCount, uint32_t groupSize, const std::function<void(DispatchState)>& job);
 private:
     static JobDispatch& instance();
     static JobDispatch* m_instance;
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <mutex>
+#include <thread>
+#include <functional>
 
 std::string get_thread_name(std::thread::id id = std::this_thread::get_id());
 
@@ -0,0 +1,79 @@
+#include "bench_modes.h"
+#include "bench_common.h"
+#include "bench_channels.h"
+#include "fluidsim/FluidSim3D.h"
+#include "threading/JobDispatcher.h"
+
+#include <cmath>
+
+MAKEPARAM(depth);
+
+int run_simulation_3d()
+{
+    // Everything but the depth is read from the same params as the 2D options.
+    FluidSimOptions2D options_2d = make_options();
+    FluidSimOptions3D options{ };
+    options.domain = { { 0.f, 0.f, 0.f }, { options_2d.extent.x, options_2d.extent.y, get_f32(p_depth, 60.f) } };
+    options.grid_extent = options_2d.smoothing_radius;
+    options.should_bounce = options_2d.should_bounce;
+    options.dampening_factor = options_2d.dampening_factor;
+    options.smoothing_radius = options_2d.smoothing_radius;
+    options.target_density = options_2d.target_density;
+    options.pressure_multiplier = options_2d.pressure_multiplier;
+    options.multithreaded = options_2d.multithreaded;
+    options.neighbour_lists = options_2d.neighbour_lists;
+    options.neighbour_skin = options_2d.neighbour_skin;
+    options.reorder_interval = options_2d.reorder_interval;
+
+    FluidSimDistribution2D distribution = make_distribution();
+    u32 side_length = u32_cast(std::ceil(std::cbrt(f64_cast(distribution.node_count))));
+    glm::f32vec3 origin = options.domain.centre() - glm::f32vec3(f32_cast(side_length) * distribution.grid_spacing / 2.f);
+    std::vector<FluidNodeInfo3D> nodes(distribution.node_count, { .velocity = { 0.f, 0.f, 0.f }, .node_radius = distribution.node_radius, .density = 0.f, .mass = 1.f, .color = distribution.node_color });
+    std::vector<glm::f32vec3> positions(distribution.node_count);
+    for( u32 node_idx = 0; node_idx < distribution.node_count; node_idx++ )
+    {
+        glm::f32vec3 grid_position{ node_idx % side_length, (node_idx / side_length) % side_length, node_idx / (side_length * side_length) };
+        positions[node_idx] = origin + grid_position * distribution.grid_spacing;
+    }
+
+    FluidSim3D simulation(options);
+    simulation.InsertNodes(nodes, positions);
+    if( !simulation.GetNodeCount() )
+    {
+        FLUIDBENCH_ERROR("No nodes to simulate.");
+        return -1;
+    }
+
+    bench_run run = make_run();
+    std::vector<FluidSimExternalForce3D> forces
+    {
+        { .type = FluidSimExternalForceType3D::GravityForce, .asGravityForce = { .acceleration = run.gravity } },
+    };
+
+    for( u32 step = 0; step < run.warmup_steps; step++ )
+    {
+        simulation.Simulate(run.delta_time, forces);
+        JobDispatch::reset_counters();
+    }
+
+    phase_totals totals{ };
+    sys::moment start = sys::now();
+    for( u32 step = 0; step < run.steps; step++ )
+    {
+        simulation.Simulate(run.delta_time, forces);
+        JobDispatch::reset_counters();
+
+        const FluidSimStats3D& stats = simulation.GetStats();
+        totals.search += stats.neighbour_search_time;
+        totals.density += stats.density_pass_time;
+        totals.pressure += stats.pressure_pass_time;
+        totals.step += stats.step_time;
+        totals.neighbours += stats.neighbour_count;
+        totals.list_rebuilds += stats.neighbour_lists_rebuilt ? 1 : 0;
+    }
+    f64 wall_time = seconds_since(start);
+
+    report_phases("3D ", simulation.GetNodeCount(), run, wall_time, totals);
+    FLUIDBENCH_INFO("checksum {:016x}", simulation.CalculateChecksum());
+    return 0;
+}
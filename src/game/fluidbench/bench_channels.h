@@ -0,0 +1,14 @@
+#pragma once
+#include "system/assert.h"
+
+SYSDECLARE_CHANNEL(fluidbench);
+
+#define FLUIDBENCH_VERBOSE(fmt, ...) SYSMSG_CHANNEL_VERBOSE(fluidbench, fmt, ##__VA_ARGS__)
+#define FLUIDBENCH_PROFILE(fmt, ...) SYSMSG_CHANNEL_PROFILE(fluidbench, fmt, ##__VA_ARGS__)
+#define FLUIDBENCH_DEBUG(fmt, ...) SYSMSG_CHANNEL_DEBUG(fluidbench, fmt, ##__VA_ARGS__)
+#define FLUIDBENCH_INFO(fmt, ...) SYSMSG_CHANNEL_INFO(fluidbench, fmt, ##__VA_ARGS__)
+#define FLUIDBENCH_WARN(fmt, ...) SYSMSG_CHANNEL_WARN(fluidbench, fmt, ##__VA_ARGS__)
+#define FLUIDBENCH_ERROR(fmt, ...) SYSMSG_CHANNEL_ERROR(fluidbench, fmt, ##__VA_ARGS__)
+#define FLUIDBENCH_FATAL(fmt, ...) SYSMSG_CHANNEL_FATAL(fluidbench, fmt, ##__VA_ARGS__)
+
+#define FLUIDBENCH_ASSERT(val, fmt, ...) SYSASSERT(val, SYSMSG_CHANNEL_ASSERT(fluidbench, fmt, ##__VA_ARGS__))
@@ -0,0 +1,173 @@
+#include "bench_common.h"
+#include "bench_channels.h"
+#include "threading/JobDispatcher.h"
+
+#include <cstring>
+
+MAKEPARAM(steps);
+MAKEPARAM(warmup_steps);
+MAKEPARAM(delta_time);
+MAKEPARAM(gravity);
+
+MAKEPARAM(width);
+MAKEPARAM(height);
+MAKEPARAM(smoothing_radius);
+MAKEPARAM(grid_mode);
+MAKEPARAM(wrap_edges);
+MAKEPARAM(dampening);
+MAKEPARAM(target_density);
+MAKEPARAM(pressure_multiplier);
+MAKEPARAM(kernel);
+MAKEPARAM(double_precision);
+MAKEPARAM(solver);
+MAKEPARAM(pbf_iterations);
+MAKEPARAM(pbf_relaxation);
+MAKEPARAM(flip_ratio);
+MAKEPARAM(flip_pressure_iterations);
+MAKEPARAM(flip_pressure_tolerance);
+MAKEPARAM(single_threaded);
+MAKEPARAM(scalar_kernels);
+MAKEPARAM(neighbour_lists);
+MAKEPARAM(neighbour_skin);
+MAKEPARAM(reorder_interval);
+MAKEPARAM(asymmetric_pressure);
+MAKEPARAM(adaptive_time_step);
+MAKEPARAM(cfl_factor);
+MAKEPARAM(max_substeps);
+MAKEPARAM(sleeping);
+MAKEPARAM(sleep_energy);
+MAKEPARAM(sleep_steps);
+
+MAKEPARAM(distribution);
+MAKEPARAM(node_count);
+MAKEPARAM(node_radius);
+MAKEPARAM(grid_spacing);
+MAKEPARAM(circular_radius);
+MAKEPARAM(velocity_scale);
+MAKEPARAM(seed);
+
+f32 get_f32(const sys::param& param, f32 fallback)
+{
+    return param.as_value() ? param.as_f32() : fallback;
+}
+
+u32 get_u32(const sys::param& param, u32 fallback)
+{
+    return param.as_value() ? param.as_u32() : fallback;
+}
+
+bool matches(const sys::param& param, const char* value)
+{
+    return param.as_value() && !strcmp(param.as_value(), value);
+}
+
+f64 seconds_between(sys::moment start, sys::moment end)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e9;
+}
+
+f64 seconds_since(sys::moment start)
+{
+    return seconds_between(start, sys::now());
+}
+
+FluidSimOptions2D make_options()
+{
+    f32 smoothing_radius = get_f32(p_smoothing_radius, 0.6f);
+
+    FluidSimOptions2D options{ };
+    options.extent = { get_f32(p_width, 60.f), get_f32(p_height, 60.f) };
+    options.grid_extent = { smoothing_radius, smoothing_radius };
+    options.grid_mode = FluidSimGridMode2D::Dense;
+    if( matches(p_grid_mode, "hashed") )
+        options.grid_mode = FluidSimGridMode2D::Hashed;
+    else if( matches(p_grid_mode, "tiled") )
+        options.grid_mode = FluidSimGridMode2D::Tiled;
+    options.should_bounce = !p_wrap_edges.get();
+    options.dampening_factor = get_f32(p_dampening, 0.8f);
+    options.smoothing_radius = smoothing_radius;
+    options.target_density = get_f32(p_target_density, 8.f);
+    options.pressure_multiplier = get_f32(p_pressure_multiplier, 5.f);
+    options.kernel = FluidSimKernel2D::Spiky;
+    if( matches(p_kernel, "poly6") )
+        options.kernel = FluidSimKernel2D::Poly6;
+    else if( matches(p_kernel, "cubic") )
+        options.kernel = FluidSimKernel2D::CubicSpline;
+    else if( matches(p_kernel, "wendland") )
+        options.kernel = FluidSimKernel2D::Wendland;
+    options.precision = p_double_precision.get() ? FluidSimPrecision2D::F64 : FluidSimPrecision2D::F32;
+    options.solver = FluidSimSolver2D::Sph;
+    if( matches(p_solver, "pbf") )
+        options.solver = FluidSimSolver2D::PositionBased;
+    else if( matches(p_solver, "flip") )
+        options.solver = FluidSimSolver2D::Flip;
+    options.pbf_iterations = get_u32(p_pbf_iterations, 4);
+    options.pbf_relaxation = get_f32(p_pbf_relaxation, 1.f);
+    options.flip_ratio = get_f32(p_flip_ratio, 0.95f);
+    options.flip_pressure_iterations = get_u32(p_flip_pressure_iterations, 200);
+    options.flip_pressure_tolerance = get_f32(p_flip_pressure_tolerance, 1e-3f);
+    options.multithreaded = !p_single_threaded.get();
+    options.simd_kernels = !p_scalar_kernels.get();
+    options.neighbour_lists = p_neighbour_lists.get();
+    options.neighbour_skin = get_f32(p_neighbour_skin, 0.f);
+    options.reorder_interval = get_u32(p_reorder_interval, 8);
+    options.symmetric_pressure = !p_asymmetric_pressure.get();
+    options.adaptive_time_step = p_adaptive_time_step.get();
+    options.cfl_factor = get_f32(p_cfl_factor, 0.4f);
+    options.max_substeps = get_u32(p_max_substeps, 8);
+    options.sleeping = p_sleeping.get();
+    options.sleep_energy = get_f32(p_sleep_energy, 0.01f);
+    options.sleep_steps = get_u32(p_sleep_steps, 30);
+    return options;
+}
+
+FluidSimDistribution2D make_distribution()
+{
+    FluidSimDistributionTechnique2D technique = FluidSimDistributionTechnique2D::Grid;
+    if( matches(p_distribution, "circular") )
+        technique = FluidSimDistributionTechnique2D::Circular;
+    else if( matches(p_distribution, "point") )
+        technique = FluidSimDistributionTechnique2D::Point;
+    else if( matches(p_distribution, "random") )
+        technique = FluidSimDistributionTechnique2D::Random;
+
+    return
+    {
+        .technique = technique,
+        .node_count = get_u32(p_node_count, 20000),
+        .node_radius = get_f32(p_node_radius, 0.1f),
+        .node_color = { 1.f, 1.f, 1.f },
+        .grid_spacing = get_f32(p_grid_spacing, 0.3f),
+        .circular_radius = get_f32(p_circular_radius, 1.f),
+        .circular_velocity_scale = get_f32(p_velocity_scale, 5.f),
+        .point_velocity_scale = get_f32(p_velocity_scale, 5.f),
+        .seed = get_u32(p_seed, 1),
+    };
+}
+
+bench_run make_run()
+{
+    return
+    {
+        .steps = get_u32(p_steps, 600),
+        .warmup_steps = get_u32(p_warmup_steps, 0),
+        .delta_time = p_delta_time.as_value() ? p_delta_time.as_f64() : 1.0 / 60.0,
+        .gravity = get_f32(p_gravity, 9.8f),
+    };
+}
+
+void report_phases(const char* prefix, u32 node_count, const bench_run& run, f64 wall_time, const phase_totals& totals)
+{
+    u32 steps = std::max(run.steps, 1u);
+    f64 per_step = 1e3 / steps;
+    FLUIDBENCH_INFO("{}nodes {} steps {} (+{} warmup) workers {}", prefix, node_count, run.steps, run.warmup_steps, JobDispatch::get_worker_count());
+    FLUIDBENCH_INFO("wall {:.3f}s, {:.1f} steps/s, {:.2f} ns/node/step",
+        wall_time, run.steps / wall_time, wall_time * 1e9 / (f64_cast(node_count) * steps));
+    FLUIDBENCH_INFO("per step: search {:.3f}ms, density {:.3f}ms, pressure {:.3f}ms, other {:.3f}ms",
+        totals.search * per_step, totals.density * per_step, totals.pressure * per_step,
+        (totals.step - totals.search - totals.density - totals.pressure) * per_step);
+    // Each neighbour is visited once by the density pass and once by the pressure pass, like the app's cost per neighbour.
+    f64 neighbour_visits = f64_cast(std::max(totals.neighbours, u64(1)) * 2);
+    FLUIDBENCH_INFO("neighbours/step {}, {:.2f} ns/neighbour, neighbour list rebuilds {}",
+        totals.neighbours / steps, (totals.density + totals.pressure) * 1e9 / neighbour_visits, totals.list_rebuilds);
+}
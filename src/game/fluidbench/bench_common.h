@@ -0,0 +1,47 @@
+#pragma once
+#include "fluidsim/FluidSim2D.h"
+#include "fluidsim/FluidSimDistribution2D.h"
+#include "system/param.h"
+#include "system/timer.h"
+
+// Helpers shared by the fluidbench modes. Options and distributions are read from the same params in every mode,
+// the params that only one mode reads are made in that mode's file.
+
+f32 get_f32(const sys::param& param, f32 fallback);
+u32 get_u32(const sys::param& param, u32 fallback);
+bool matches(const sys::param& param, const char* value);
+
+f64 seconds_between(sys::moment start, sys::moment end);
+f64 seconds_since(sys::moment start);
+
+FluidSimOptions2D make_options();
+FluidSimDistribution2D make_distribution();
+
+// How long and how far a run steps, and the gravity it steps under.
+struct bench_run
+{
+    u32 steps;
+    u32 warmup_steps;
+    f64 delta_time;
+    f32 gravity;
+};
+
+bench_run make_run();
+
+struct phase_totals
+{
+    f64 search;
+    f64 density;
+    f64 pressure;
+    f64 step;
+    u64 neighbours;
+    u32 list_rebuilds;
+    u32 substeps;
+    u64 awake_nodes;
+    u64 pressure_iterations;
+    f64 churn;
+    f64 upload;
+};
+
+// The throughput and per phase lines every timed run reports, prefix names the run.
+void report_phases(const char* prefix, u32 node_count, const bench_run& run, f64 wall_time, const phase_totals& totals);
@@ -0,0 +1,108 @@
+#include "bench_field.h"
+#include "bench_common.h"
+#include "bench_channels.h"
+#include "threading/JobDispatcher.h"
+#include "system/hash.h"
+#include "cdt/loaders/image_loaders.h"
+
+MAKEPARAM(field);
+MAKEPARAM(field_image);
+MAKEPARAM(field_resolution);
+MAKEPARAM(field_radius);
+MAKEPARAM(field_shading);
+MAKEPARAM(field_min);
+MAKEPARAM(field_max);
+MAKEPARAM(field_surface);
+
+namespace
+{
+
+// The field covers the whole domain with field_resolution texels along its longer side.
+FluidSimFieldOptions2D make_field_options(const FluidSimOptions2D& options)
+{
+    f32 resolution = f32_cast(get_u32(p_field_resolution, 512));
+    f32 longest = std::max(options.extent.x, options.extent.y);
+    return
+    {
+        .resolution = glm::max(glm::uvec2(options.extent / longest * resolution + 0.5f), glm::uvec2(1, 1)),
+        .origin = { 0.f, 0.f },
+        .extent = options.extent,
+        .splat_radius = get_f32(p_field_radius, options.smoothing_radius),
+        .multithreaded = options.multithreaded,
+    };
+}
+
+FluidSimFieldShadingOptions2D make_field_shading()
+{
+    FluidSimFieldShading2D shading = FluidSimFieldShading2D::Speed;
+    if( matches(p_field_shading, "density") )
+        shading = FluidSimFieldShading2D::Density;
+    else if( matches(p_field_shading, "color") )
+        shading = FluidSimFieldShading2D::NodeColor;
+
+    bool density = shading == FluidSimFieldShading2D::Density;
+    return
+    {
+        .shading = shading,
+        .min_value = get_f32(p_field_min, 0.f),
+        .max_value = get_f32(p_field_max, density ? 20.f : 10.f),
+        .min_color = { 0.f, 0.f, 1.f },
+        .max_color = { 1.f, 0.f, 0.f },
+        .background_color = { 0.f, 0.f, 0.f },
+        .surface_density = get_f32(p_field_surface, 4.f),
+    };
+}
+
+} //
+
+bench_field::bench_field(const FluidSimOptions2D& options) :
+    m_view(make_field_options(options)),
+    m_shading(make_field_shading()),
+    m_pixels(u64_cast(m_view.GetTexelCount()) * 4),
+    m_enabled(p_field.get()),
+    m_splatTime(0.0),
+    m_shadeTime(0.0)
+{ }
+
+bool bench_field::is_enabled() const
+{
+    return m_enabled;
+}
+
+void bench_field::update(std::span<const glm::f32vec4> positions, std::span<const FluidNodeInfo2D> infos)
+{
+    sys::moment splat_start = sys::now();
+    m_view.Splat(positions, infos);
+    sys::moment shade_start = sys::now();
+    m_view.Shade(m_shading, m_pixels);
+    m_splatTime += seconds_between(splat_start, shade_start);
+    m_shadeTime += seconds_since(shade_start);
+}
+
+void bench_field::report(u32 steps) const
+{
+    if( !m_enabled )
+        return;
+
+    f64 per_step = 1e3 / std::max(steps, 1u);
+    FLUIDBENCH_INFO("field {}x{}, splat {:.3f}ms/step, shade {:.3f}ms/step", m_view.GetOptions().resolution.x,
+        m_view.GetOptions().resolution.y, m_splatTime * per_step, m_shadeTime * per_step);
+}
+
+// The final state shaded as the app's field view would draw it, the checksum makes image diffs a string compare.
+void bench_field::write_image(const FluidSim2D& simulation)
+{
+    if( !p_field_image.as_value() )
+        return;
+
+    std::vector<FluidNodeInfo2D> infos(simulation.GetNodeCount());
+    simulation.WriteNodeInfos(infos.data());
+    m_view.Splat(simulation.GetNodePositions(), infos);
+    m_view.Shade(m_shading, m_pixels);
+    JobDispatch::reset_counters();
+
+    cdt::image image({ cdt::image_format::R8G8B8A8_UNORM, m_view.GetOptions().resolution.x, m_view.GetOptions().resolution.y, 1 }, 0, m_pixels.data());
+    if( !cdt::image_loader::to_file_png(p_field_image.as_value(), image) )
+        FLUIDBENCH_ERROR("Can't write field image {}.", p_field_image.as_value());
+    FLUIDBENCH_INFO("field image {}, checksum {:016x}", p_field_image.as_value(), sys::hash64(m_pixels.data(), m_pixels.size()));
+}
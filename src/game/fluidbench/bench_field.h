@@ -0,0 +1,26 @@
+#pragma once
+#include "fluidsim/FluidSimField2D.h"
+
+class FluidSim2D;
+
+// -field splats and shades the staged render state every step like the app's field view does every frame,
+// -field_image shades the final state and writes it out as a png.
+class bench_field
+{
+public:
+    bench_field(const FluidSimOptions2D& options);
+
+    // Whether update has to be called every step.
+    bool is_enabled() const;
+
+    void update(std::span<const glm::f32vec4> positions, std::span<const FluidNodeInfo2D> infos);
+    void report(u32 steps) const;
+    void write_image(const FluidSim2D& simulation);
+private:
+    FluidSimField2D m_view;
+    FluidSimFieldShadingOptions2D m_shading;
+    std::vector<u8> m_pixels;
+    bool m_enabled;
+    f64 m_splatTime;
+    f64 m_shadeTime;
+};
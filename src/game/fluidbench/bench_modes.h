@@ -0,0 +1,13 @@
+#pragma once
+
+// Modes that replace the regular 2D run, each lives in its own bench_*.cpp.
+
+// -replay runs every command of an input log from the snapshot it starts from, with the options it was recorded with,
+// checking the state against the logged checksums along the way.
+int replay_input(const char* filename);
+
+// -dimensions=3 runs FluidSim3D on a cube of node_count nodes grid_spacing apart, centred in a width * height * depth domain.
+int run_simulation_3d();
+
+// -compare_solvers steps the same scene for the same simulated time with every solver.
+int compare_solvers();
@@ -0,0 +1,51 @@
+#include "bench_obstacles.h"
+#include "bench_common.h"
+#include "bench_channels.h"
+
+#include <cmath>
+#include <numbers>
+
+MAKEPARAM(obstacles);
+MAKEPARAM(obstacle_segments);
+MAKEPARAM(obstacle_cell);
+
+std::unique_ptr<FluidSimObstacles2D> make_obstacles(const FluidSimOptions2D& options)
+{
+    if( !p_obstacles.get() )
+        return nullptr;
+
+    sys::moment build_start = sys::now();
+    f32 cell_size = get_f32(p_obstacle_cell, options.smoothing_radius * 0.25f);
+    auto obstacles = std::make_unique<FluidSimObstacles2D>(glm::f32vec2(0.f, 0.f), options.extent, cell_size);
+
+    u32 segment_count = std::max(get_u32(p_obstacle_segments, 64), 3u);
+    glm::f32vec2 center = options.extent * glm::f32vec2(0.5f, 0.3f);
+    f32 radius = std::min(options.extent.x, options.extent.y) * 0.15f;
+    std::vector<glm::f32vec2> circle;
+    for( u32 idx = 0; idx < segment_count; idx++ )
+    {
+        f32 angle = f32_cast(idx) / f32_cast(segment_count) * 2.f * std::numbers::pi_v<f32>;
+        circle.push_back(center + glm::f32vec2(std::cos(angle), std::sin(angle)) * radius);
+    }
+    obstacles->AddPolygon(circle);
+
+    glm::f32vec2 ramp[] = { options.extent * glm::f32vec2(0.05f, 0.7f), options.extent * glm::f32vec2(0.45f, 0.55f) };
+    obstacles->AddPolyline(ramp, options.smoothing_radius * 2.f);
+
+    obstacles->Build(options.multithreaded);
+    FLUIDBENCH_INFO("obstacles {} segments, field {}x{}, build {:.3f}ms", obstacles->GetSegmentCount(),
+        obstacles->GetSampleCount().x, obstacles->GetSampleCount().y, seconds_since(build_start) * 1e3);
+    return obstacles;
+}
+
+// Nodes end a move on the surface, which the bilinear field only approximates, so only deeper ones count.
+void report_obstacles(const FluidSimObstacles2D& obstacles, const FluidSim2D& simulation)
+{
+    u32 inside_count = 0;
+    for( const glm::f32vec4& position : simulation.GetNodePositions() )
+    {
+        if( obstacles.Sample(glm::f32vec2(position)) < -0.01f )
+            inside_count++;
+    }
+    FLUIDBENCH_INFO("nodes more than 0.01 inside obstacles {}", inside_count);
+}
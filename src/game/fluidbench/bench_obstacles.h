@@ -0,0 +1,10 @@
+#pragma once
+#include "fluidsim/FluidSimObstacles2D.h"
+
+class FluidSim2D;
+
+// -obstacles puts a round obstacle of obstacle_segments sides below the middle of the domain and a ramp across its
+// upper left, so the collision cost of a detailed outline can be compared with a coarse one. Returns nullptr without it.
+std::unique_ptr<FluidSimObstacles2D> make_obstacles(const FluidSimOptions2D& options);
+
+void report_obstacles(const FluidSimObstacles2D& obstacles, const FluidSim2D& simulation);
@@ -0,0 +1,56 @@
+#include "bench_modes.h"
+#include "bench_common.h"
+#include "bench_channels.h"
+#include "fluidsim/FluidSimInputLog2D.h"
+#include "fluidsim/FluidSimSnapshot2D.h"
+#include "threading/JobDispatcher.h"
+
+int replay_input(const char* filename)
+{
+    FluidSimInputLog2D input_log;
+    const FluidSimSnapshotHeader2D* header = input_log.Load(filename) ? ReadSnapshotHeader(input_log.GetSnapshot()) : nullptr;
+    if( !header )
+    {
+        FLUIDBENCH_ERROR("Can't load input log {}.", filename);
+        return -1;
+    }
+
+    FluidSim2D simulation(header->options);
+    if( !simulation.LoadSnapshot(input_log.GetSnapshot()) )
+        return -1;
+
+    if( simulation.CalculateChecksum() != input_log.GetInitialChecksum() )
+        FLUIDBENCH_WARN("Initial state doesn't match the recording.");
+
+    u32 steps = 0;
+    u32 checked_steps = 0;
+    u32 first_divergence = 0;
+    f64 step_time = 0.0;
+    sys::moment start = sys::now();
+    for( u32 command_idx = 0; command_idx < input_log.GetCommandCount(); command_idx++ )
+    {
+        const FluidSimInputCommand2D& command = input_log.GetCommand(command_idx);
+        bool matches = input_log.Replay(simulation, command_idx);
+        JobDispatch::reset_counters();
+
+        if( command.type != FluidSimInputCommandType2D::Simulate )
+            continue;
+
+        steps++;
+        step_time += simulation.GetStats().step_time;
+        checked_steps += command.checksum ? 1 : 0;
+        if( !matches && !first_divergence )
+            first_divergence = steps;
+    }
+    f64 wall_time = seconds_since(start);
+
+    FLUIDBENCH_INFO("replayed {} commands, {} steps of {} nodes, recorded with {} workers, replayed with {}",
+        input_log.GetCommandCount(), steps, simulation.GetNodeCount(), input_log.GetWorkerCount(), JobDispatch::get_worker_count());
+    FLUIDBENCH_INFO("wall {:.3f}s, simulate {:.3f}ms/step", wall_time, step_time * 1e3 / std::max(steps, 1u));
+    if( first_divergence )
+        FLUIDBENCH_ERROR("diverged from the recording at step {}", first_divergence);
+    else
+        FLUIDBENCH_INFO("matched the recording at all {} checked steps", checked_steps);
+    FLUIDBENCH_INFO("checksum {:016x}", simulation.CalculateChecksum());
+    return first_divergence ? 1 : 0;
+}
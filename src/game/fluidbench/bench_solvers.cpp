@@ -0,0 +1,117 @@
+#include "bench_modes.h"
+#include "bench_common.h"
+#include "bench_channels.h"
+#include "threading/JobDispatcher.h"
+
+#include <cmath>
+
+MAKEPARAM(sph_step_scale);
+MAKEPARAM(sph_pressure_multiplier);
+MAKEPARAM(pbf_step_scale);
+MAKEPARAM(flip_step_scale);
+
+// The SPH solver steps at delta_time / sph_step_scale, the position based solver at pbf_step_scale and the FLIP solver at
+// flip_step_scale times delta_time, each for as many steps as cover steps * delta_time and reporting simulated seconds per
+// wall second and how well it held its rest density. SPH only holds a settled column near its rest density when far stiffer
+// than pressure_multiplier usually is, so it runs at sph_pressure_multiplier, and that stiffness needs the shorter step to
+// stay stable. FLIP densities are the mass per area of its grid rather than kernel sums, so they are compared to their mean
+// after the first step instead of target_density. FLIP nodes move with their own velocity, so steps taking them past more
+// than a cell bunch them up against the walls.
+int compare_solvers()
+{
+    bench_run run = make_run();
+    u32 sph_step_scale = std::max(get_u32(p_sph_step_scale, 8), 1u);
+    u32 step_scale = std::max(get_u32(p_pbf_step_scale, 4), 1u);
+    u32 flip_step_scale = std::max(get_u32(p_flip_step_scale, 1), 1u);
+
+    std::vector<FluidSimExternalForce2D> forces
+    {
+        { .type = FluidSimExternalForceType2D::GravityForce, .asGravityForce = { .acceleration = run.gravity } },
+    };
+
+    // step_scale is the solver's step over delta_time, steps and warmup steps are divided by it.
+    auto run_solver = [&](const FluidSimOptions2D& options, const char* name, f64 step_scale)
+        {
+            FluidSim2D simulation(options);
+            DistributeNodes(simulation, make_distribution());
+            if( !simulation.GetNodeCount() )
+                return false;
+
+            f64 solver_time = run.delta_time * step_scale;
+            f32 rest_density = options.target_density;
+            if( options.solver == FluidSimSolver2D::Flip )
+            {
+                simulation.Simulate(solver_time, forces);
+                JobDispatch::reset_counters();
+
+                std::vector<FluidNodeInfo2D> first_infos(simulation.GetNodeCount());
+                simulation.WriteNodeInfos(first_infos.data());
+                f64 density_sum = 0.0;
+                for( const FluidNodeInfo2D& info : first_infos )
+                {
+                    density_sum += info.density;
+                }
+                rest_density = f32_cast(density_sum / first_infos.size());
+            }
+
+            u32 warmup_steps = u32_cast(run.warmup_steps / step_scale + 0.5);
+            for( u32 step = 0; step < warmup_steps; step++ )
+            {
+                simulation.Simulate(solver_time, forces);
+                JobDispatch::reset_counters();
+            }
+
+            u32 solver_steps = std::max(u32_cast(run.steps / step_scale + 0.5), 1u);
+            sys::moment start = sys::now();
+            for( u32 step = 0; step < solver_steps; step++ )
+            {
+                simulation.Simulate(solver_time, forces);
+                JobDispatch::reset_counters();
+            }
+            f64 wall_time = seconds_since(start);
+
+            // Densities are those the last step measured, before its nodes moved.
+            u32 node_count = simulation.GetNodeCount();
+            std::vector<FluidNodeInfo2D> infos(node_count);
+            simulation.WriteNodeInfos(infos.data());
+
+            f64 compression_sum = 0.0;
+            f32 max_compression = 0.f;
+            f32 max_speed = 0.f;
+            u32 lost_nodes = 0;
+            for( u32 node_idx = 0; node_idx < node_count; node_idx++ )
+            {
+                const glm::f32vec4& position = simulation.GetNodePositions()[node_idx];
+                if( !std::isfinite(position.x) || !std::isfinite(position.y) )
+                {
+                    lost_nodes++;
+                    continue;
+                }
+
+                f32 compression = std::max(infos[node_idx].density / rest_density - 1.f, 0.f);
+                compression_sum += compression;
+                max_compression = std::max(max_compression, compression);
+                max_speed = std::max(max_speed, glm::length(infos[node_idx].velocity));
+            }
+
+            f64 simulated_time = solver_time * solver_steps;
+            FLUIDBENCH_INFO("{}: dt {:.4f}s x {} steps, wall {:.3f}s, {:.2f} simulated s/wall s",
+                name, solver_time, solver_steps, wall_time, simulated_time / wall_time);
+            FLUIDBENCH_INFO("{}: compression mean {:.2f}% max {:.2f}%, max speed {:.2f}, lost nodes {}",
+                name, compression_sum * 100.0 / std::max(node_count - lost_nodes, 1u), max_compression * 100.f, max_speed, lost_nodes);
+            return true;
+        };
+
+    FluidSimOptions2D sph_options = make_options();
+    sph_options.solver = FluidSimSolver2D::Sph;
+    sph_options.pressure_multiplier = get_f32(p_sph_pressure_multiplier, 1000.f);
+    FluidSimOptions2D pbf_options = make_options();
+    pbf_options.solver = FluidSimSolver2D::PositionBased;
+    FluidSimOptions2D flip_options = make_options();
+    flip_options.solver = FluidSimSolver2D::Flip;
+
+    bool ran = run_solver(sph_options, "sph", 1.0 / sph_step_scale)
+        && run_solver(pbf_options, "pbf", step_scale)
+        && run_solver(flip_options, "flip", flip_step_scale);
+    return ran ? 0 : -1;
+}
@@ -0,0 +1,72 @@
+#include "bench_trajectory.h"
+#include "bench_common.h"
+#include "bench_channels.h"
+
+MAKEPARAM(trajectory);
+MAKEPARAM(trajectory_interval);
+MAKEPARAM(trajectory_buffers);
+MAKEPARAM(trajectory_level);
+
+bench_trajectory::bench_trajectory() :
+    m_writer({
+        .step_interval = get_u32(p_trajectory_interval, 10),
+        .buffer_count = get_u32(p_trajectory_buffers, 4),
+        .compression_level = i32_cast(get_u32(p_trajectory_level, 5)),
+    })
+{ }
+
+bool bench_trajectory::open(const FluidSim2D& simulation)
+{
+    if( !p_trajectory.as_value() || m_writer.Open(p_trajectory.as_value(), simulation) )
+        return true;
+
+    FLUIDBENCH_ERROR("Can't create trajectory {}.", p_trajectory.as_value());
+    return false;
+}
+
+void bench_trajectory::record(const FluidSim2D& simulation)
+{
+    m_writer.Record(simulation);
+}
+
+void bench_trajectory::report(const FluidSim2D& simulation, u32 steps)
+{
+    if( !p_trajectory.as_value() )
+        return;
+
+    m_writer.Close();
+    FluidSimTrajectoryStats2D stats = m_writer.GetStats();
+    FLUIDBENCH_INFO("trajectory {} frames ({} dropped), record {:.3f}ms/frame on the sim thread, write {:.3f}ms/frame",
+        stats.written_frames, stats.dropped_frames,
+        stats.record_time * 1e3 / std::max(stats.recorded_frames, 1u),
+        stats.write_time * 1e3 / std::max(stats.written_frames, 1u));
+    FLUIDBENCH_INFO("trajectory {:.2f}MB raw, {:.2f}MB written ({:.1f}x)",
+        stats.raw_bytes / 1e6, stats.written_bytes / 1e6,
+        f64_cast(stats.raw_bytes) / std::max(stats.written_bytes, u64(1)));
+
+    FluidSimTrajectoryReader2D reader;
+    FluidSimTrajectoryFrame2D frame{ };
+    u32 read_frames = 0;
+    sys::moment read_start = sys::now();
+    if( reader.Open(p_trajectory.as_value()) )
+    {
+        while( reader.ReadFrame(frame) )
+        {
+            read_frames++;
+        }
+    }
+    f64 read_time = seconds_since(read_start);
+    FLUIDBENCH_INFO("trajectory read back {} frames, {:.3f}ms/frame", read_frames, read_time * 1e3 / std::max(read_frames, 1u));
+
+    // The last frame is the final state when the step count is a multiple of the interval, so the quantisation error shows.
+    if( read_frames && frame.step == steps )
+    {
+        f32 max_error = 0.f;
+        for( u64 idx = 0; idx < frame.node_ids.size(); idx++ )
+        {
+            glm::f32vec2 position = simulation.GetNodePositions()[simulation.GetNodeIndex(frame.node_ids[idx])];
+            max_error = std::max(max_error, glm::length(frame.positions[idx] - position));
+        }
+        FLUIDBENCH_INFO("trajectory last frame max position error {:.6f}", max_error);
+    }
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "fluidsim/FluidSimTrajectory2D.h"
+
+// -trajectory writes every trajectory_interval timed steps to a compressed trajectory, then reads it back once the run is done.
+class bench_trajectory
+{
+public:
+    bench_trajectory();
+
+    // Only fails when -trajectory is set and the file can't be created.
+    bool open(const FluidSim2D& simulation);
+    void record(const FluidSim2D& simulation);
+
+    // Closes the trajectory before reporting on it.
+    void report(const FluidSim2D& simulation, u32 steps);
+private:
+    FluidSimTrajectoryWriter2D m_writer;
+};
@@ -0,0 +1,292 @@
+#include "bench_channels.h"
+#include "bench_common.h"
+#include "bench_field.h"
+#include "bench_modes.h"
+#include "bench_obstacles.h"
+#include "bench_trajectory.h"
+#include "fluidsim/FluidSimInputLog2D.h"
+#include "fluidsim/FluidSimRunner2D.h"
+#include "fluidsim/FluidSimSnapshot2D.h"
+#include "threading/JobDispatcher.h"
+#include "system/param.h"
+
+#include <random>
+
+// Runs FluidSim2D without a window or graphics and reports throughput.
+// Every option is a param, so a run can be described by a param file: fluidbench &file.params -steps=100
+// The params shared by every mode are read in bench_common.cpp, the rest next to the mode that reads them.
+
+MAKEPARAM(dimensions);
+MAKEPARAM(compare_solvers);
+MAKEPARAM(replay);
+MAKEPARAM(churn);
+MAKEPARAM(upload);
+MAKEPARAM(async);
+MAKEPARAM(save_snapshot);
+MAKEPARAM(load_snapshot);
+MAKEPARAM(record_input);
+MAKEPARAM(input_checksum_interval);
+
+namespace
+{
+
+// Drains the oldest nodes and emits the same number again each step, so the node count stays constant
+// while every node is eventually recycled. Handles are kept in a ring in insertion order.
+struct churn_state
+{
+    std::vector<FluidNodeHandle2D> ring;
+    u32 head;
+    std::vector<FluidNodeHandle2D> handles;
+    std::vector<FluidNodeInfo2D> nodes;
+    std::vector<glm::f32vec2> positions;
+    std::minstd_rand random;
+};
+
+void churn_nodes(FluidSim2D& simulation, churn_state& churn)
+{
+    u32 count = u32_cast(churn.handles.size());
+    for( u32 idx = 0; idx < count; idx++ )
+    {
+        churn.handles[idx] = churn.ring[(churn.head + idx) % churn.ring.size()];
+    }
+    simulation.RemoveNodes(churn.handles);
+
+    // Emitted anywhere in the extent so the density stays roughly even.
+    const FluidSimOptions2D& options = simulation.GetOptions();
+    for( u32 idx = 0; idx < count; idx++ )
+    {
+        std::uniform_real_distribution<f32> unit(0.f, 1.f);
+        churn.positions[idx] = glm::f32vec2{ unit(churn.random), unit(churn.random) } * options.extent;
+    }
+    simulation.InsertNodes(churn.nodes, churn.positions, churn.handles);
+
+    for( u32 idx = 0; idx < count; idx++ )
+    {
+        churn.ring[(churn.head + idx) % churn.ring.size()] = churn.handles[idx];
+    }
+    churn.head = u32_cast((churn.head + count) % churn.ring.size());
+}
+
+int run_simulation_2d()
+{
+    // A loaded snapshot replaces the distribution and decides the domain, the params still set everything else.
+    FluidSimOptions2D options = make_options();
+    std::vector<u8> snapshot;
+    sys::moment load_start = sys::now();
+    if( p_load_snapshot.as_value() )
+    {
+        snapshot = LoadSnapshotFile(p_load_snapshot.as_value());
+        const FluidSimSnapshotHeader2D* header = ReadSnapshotHeader(snapshot);
+        if( !header )
+        {
+            FLUIDBENCH_ERROR("Can't load snapshot {}.", p_load_snapshot.as_value());
+            return -1;
+        }
+
+        options.extent = header->options.extent;
+        options.grid_extent = header->options.grid_extent;
+        options.grid_mode = header->options.grid_mode;
+    }
+    f64 read_time = seconds_since(load_start);
+
+    FluidSim2D simulation(options);
+    FluidSimDistribution2D distribution = make_distribution();
+    if( snapshot.empty() )
+    {
+        DistributeNodes(simulation, distribution);
+    }
+    else
+    {
+        sys::moment adopt_start = sys::now();
+        if( !simulation.LoadSnapshot(snapshot) )
+            return -1;
+
+        FLUIDBENCH_INFO("loaded snapshot {} ({:.2f}MB), read {:.3f}ms, adopt {:.3f}ms",
+            p_load_snapshot.as_value(), snapshot.size() / 1e6, read_time * 1e3, seconds_since(adopt_start) * 1e3);
+    }
+
+    std::unique_ptr<FluidSimObstacles2D> obstacles = make_obstacles(options);
+    if( obstacles )
+        simulation.SetObstacles(obstacles.get());
+
+    if( !simulation.GetNodeCount() )
+    {
+        FLUIDBENCH_ERROR("No nodes to simulate.");
+        return -1;
+    }
+
+    bench_run run = make_run();
+    std::vector<FluidSimExternalForce2D> forces
+    {
+        { .type = FluidSimExternalForceType2D::GravityForce, .asGravityForce = { .acceleration = run.gravity } },
+    };
+
+    for( u32 step = 0; step < run.warmup_steps; step++ )
+    {
+        simulation.Simulate(run.delta_time, forces);
+        JobDispatch::reset_counters();
+    }
+
+    // Saved after the warmup, so a settled scene can be restarted with -load_snapshot.
+    if( p_save_snapshot.as_value() )
+    {
+        std::vector<u8> saved = simulation.SaveSnapshot();
+        if( !SaveSnapshotFile(p_save_snapshot.as_value(), saved) )
+        {
+            FLUIDBENCH_ERROR("Can't save snapshot {}.", p_save_snapshot.as_value());
+            return -1;
+        }
+        FLUIDBENCH_INFO("saved snapshot {} ({:.2f}MB)", p_save_snapshot.as_value(), saved.size() / 1e6);
+    }
+
+    churn_state churn{ };
+    u32 churn_count = std::min(get_u32(p_churn, 0), simulation.GetNodeCount());
+    churn.handles.resize(churn_count);
+    churn.nodes.assign(churn_count, { .velocity = { 0.f, 0.f }, .node_radius = distribution.node_radius, .density = 0.f, .mass = 1.f, .color = distribution.node_color });
+    churn.positions.resize(churn_count);
+    churn.random.seed(distribution.seed);
+    for( u32 node_idx = 0; node_idx < simulation.GetNodeCount(); node_idx++ )
+    {
+        churn.ring.push_back(simulation.GetNodeHandle(node_idx));
+    }
+
+    // -upload copies the render state out after every step, -async runs the steps on a FluidSimRunner2D
+    // and overlaps that copy (of the previously published frame) with the next step. -field then splats and shades
+    // the copy like the app's field view does every frame.
+    bench_field field(options);
+    bool upload = p_upload.get() || p_async.get() || field.is_enabled();
+    std::unique_ptr<FluidSimRunner2D> runner;
+    if( p_async.get() )
+    {
+        runner = std::make_unique<FluidSimRunner2D>();
+        simulation.Publish();
+    }
+    std::vector<glm::f32vec4> staged_positions;
+    std::vector<FluidNodeInfo2D> staged_infos;
+
+    bench_trajectory trajectory;
+    if( !trajectory.open(simulation) )
+        return -1;
+
+    // The timed steps are logged from the post warmup state, -replay runs them again.
+    FluidSimInputLog2D input_log;
+    if( p_record_input.as_value() )
+    {
+        if( churn_count )
+            FLUIDBENCH_WARN("Churned nodes aren't logged, the recording won't replay.");
+
+        input_log.Begin(simulation, get_u32(p_input_checksum_interval, 1));
+        simulation.SetInputLog(&input_log);
+    }
+
+    phase_totals totals{ };
+    sys::moment start = sys::now();
+    for( u32 step = 0; step < run.steps; step++ )
+    {
+        if( churn_count )
+        {
+            sys::moment churn_start = sys::now();
+            churn_nodes(simulation, churn);
+            totals.churn += seconds_since(churn_start);
+        }
+
+        if( runner )
+        {
+            runner->Kick([&]()
+                {
+                    simulation.Simulate(run.delta_time, forces);
+                    trajectory.record(simulation);
+                    simulation.Publish();
+                });
+
+            // Stage the frame the previous step published while this one runs, like the app's render upload.
+            sys::moment upload_start = sys::now();
+            const FluidSimFrame2D& frame = simulation.Acquire();
+            staged_positions.assign(frame.positions.begin(), frame.positions.end());
+            staged_infos.assign(frame.node_infos.begin(), frame.node_infos.end());
+            totals.upload += seconds_since(upload_start);
+
+            runner->Wait();
+        }
+        else
+        {
+            simulation.Simulate(run.delta_time, forces);
+            trajectory.record(simulation);
+            if( upload )
+            {
+                sys::moment upload_start = sys::now();
+                staged_positions.assign(simulation.GetNodePositions().begin(), simulation.GetNodePositions().end());
+                staged_infos.resize(simulation.GetNodeCount());
+                simulation.WriteNodeInfos(staged_infos.data());
+                totals.upload += seconds_since(upload_start);
+            }
+        }
+
+        if( field.is_enabled() )
+            field.update(staged_positions, staged_infos);
+        JobDispatch::reset_counters();
+
+        const FluidSimStats2D& stats = simulation.GetStats();
+        totals.search += stats.neighbour_search_time;
+        totals.density += stats.density_pass_time;
+        totals.pressure += stats.pressure_pass_time;
+        totals.step += stats.step_time;
+        totals.neighbours += stats.neighbour_count;
+        totals.list_rebuilds += stats.neighbour_lists_rebuilt ? 1 : 0;
+        totals.substeps += stats.substep_count;
+        totals.awake_nodes += stats.awake_node_count;
+        totals.pressure_iterations += stats.pressure_iterations;
+    }
+    f64 wall_time = seconds_since(start);
+
+    if( p_record_input.as_value() )
+    {
+        simulation.SetInputLog(nullptr);
+        if( !input_log.Save(p_record_input.as_value()) )
+            FLUIDBENCH_ERROR("Can't save input log {}.", p_record_input.as_value());
+    }
+
+    u32 steps = std::max(run.steps, 1u);
+    f64 per_step = 1e3 / steps;
+    report_phases("", simulation.GetNodeCount(), run, wall_time, totals);
+    FLUIDBENCH_INFO("substeps/step {:.2f}, awake nodes/step {}", f64_cast(totals.substeps) / steps, totals.awake_nodes / steps);
+    if( options.solver == FluidSimSolver2D::Flip )
+        FLUIDBENCH_INFO("pressure iterations/step {:.1f}, residual of the last {:.6f}",
+            f64_cast(totals.pressure_iterations) / steps, simulation.GetStats().pressure_residual);
+    if( upload )
+        FLUIDBENCH_INFO("upload {:.3f}ms/step{}", totals.upload * per_step, runner ? ", overlapped with the simulation" : "");
+    field.report(run.steps);
+    if( obstacles )
+        report_obstacles(*obstacles, simulation);
+    if( churn_count )
+        FLUIDBENCH_INFO("churn {} nodes/step, remove and insert {:.3f}ms/step", churn_count, totals.churn * per_step);
+    trajectory.report(simulation, run.steps);
+    field.write_image(simulation);
+    FLUIDBENCH_INFO("checksum {:016x}", simulation.CalculateChecksum());
+    return 0;
+}
+
+} //
+
+int main(int argc, const char* argv[])
+{
+    std::vector<const char*> args;
+    for( i32 i = 1; i < argc; i++ )
+    {
+        args.push_back(argv[i]);
+    }
+    sys::param::init(args);
+
+    JobDispatch::initialize();
+
+    if( p_replay.as_value() )
+        return replay_input(p_replay.as_value());
+
+    if( get_u32(p_dimensions, 2) == 3 )
+        return run_simulation_3d();
+
+    if( p_compare_solvers.get() )
+        return compare_solvers();
+
+    return run_simulation_2d();
+}
@@ -16,6 +16,7 @@
   
   prj_Crawler = "game"
   prj_Shaderdev = "shaderdev"
+  prj_FluidBench = "fluidbench"
 
   prj_ImGui = "DearImGui"
 
@@ -40,10 +41,6 @@
   }
 
   exceptionhandling ("Off")
-  buildoptions
-  {
-    "/Zc:__cplusplus",
-  }
 
   targetdir ("../bin/%{prj.name}/" .. g_Outputdir)
   objdir    ("../bin-int/%{prj.name}/" .. g_Outputdir)
@@ -60,6 +57,20 @@
       "PLATFORM_WINDOWS",
     }
 
+  -- Only core and fluidbench build on linux, the rest needs the windows glfw and vulkan libraries.
+  filter "system:linux"
+    defines
+    {
+      "PLATFORM_LINUX",
+    }
+
+  filter "toolset:msc*"
+    buildoptions
+    {
+      "/Zc:__cplusplus",
+      "/MD",
+    }
+
   filter "configurations:Debug"
     defines
     {
@@ -68,7 +79,6 @@
     symbols "On"
     optimize "Off"
     runtime "Release"
-    buildoptions "/MD"
 
   filter "configurations:ReleasePdb"
     defines
@@ -78,7 +88,6 @@
     symbols "On"
     optimize "On"
     runtime "Release"
-    buildoptions "/MD"
 
   filter "configurations:Release"
     defines
@@ -88,7 +97,6 @@
     symbols "Off"
     optimize "On"
     runtime "Release"
-    buildoptions "/MD"
 
   filter "configurations:Final"
     defines
@@ -98,7 +106,6 @@
     symbols "Off"
     optimize "Off"
     runtime "Release"
-    buildoptions "/MD"
 
   filter {}
 
@@ -122,10 +129,19 @@
           "%{g_Vendordir}/stb",
         }
     
-        buildoptions
-        {
-          "/FIforceinclude.h",
-        }
+        filter "toolset:msc*"
+          buildoptions
+          {
+            "/FIforceinclude.h",
+          }
+
+        filter "toolset:gcc or clang"
+          buildoptions
+          {
+            "-include forceinclude.h",
+          }
+
+        filter {}
         --pchheader "forceinclude.h"
         --pchsource "forceinclude.cpp"
 
@@ -156,10 +172,19 @@
           "%{g_Vendordir}/glslang",
         }
     
-        buildoptions
-        {
-          "/FIforceinclude.h",
-        }
+        filter "toolset:msc*"
+          buildoptions
+          {
+            "/FIforceinclude.h",
+          }
+
+        filter "toolset:gcc or clang"
+          buildoptions
+          {
+            "-include forceinclude.h",
+          }
+
+        filter {}
 
         dependson
         {
@@ -247,10 +272,19 @@
           "%{prj_ImGui}",
         }
 
-        buildoptions
-        {
-          "/FIforceinclude.h",
-        }
+        filter "toolset:msc*"
+          buildoptions
+          {
+            "/FIforceinclude.h",
+          }
+
+        filter "toolset:gcc or clang"
+          buildoptions
+          {
+            "-include forceinclude.h",
+          }
+
+        filter {}
 
         dependson
         {
@@ -332,10 +366,19 @@
       "%{prj_Framework}",
     }
 
-    buildoptions
-    {
-      "/FIforceinclude.h",
-    }
+    filter "toolset:msc*"
+      buildoptions
+      {
+        "/FIforceinclude.h",
+      }
+
+    filter "toolset:gcc or clang"
+      buildoptions
+      {
+        "-include forceinclude.h",
+      }
+
+    filter {}
 
     libdirs
     {
@@ -407,10 +450,19 @@
 	  "%{prj_Graphics}",
     }
 
-    buildoptions
-    {
-      "/FIforceinclude.h",
-    }
+    filter "toolset:msc*"
+      buildoptions
+      {
+        "/FIforceinclude.h",
+      }
+
+    filter "toolset:gcc or clang"
+      buildoptions
+      {
+        "-include forceinclude.h",
+      }
+
+    filter {}
 
     files
     {
@@ -461,6 +513,87 @@
       {
       }
 
+----------------------------------------------------------------------
+--------------------------------FluidBench----------------------------
+----------------------------------------------------------------------
+-- On linux: premake5 gmake2 && make config=release fluidbench
+  project (prj_FluidBench)
+    location "%{prj.name}"
+    kind "ConsoleApp"
+    
+    includedirs
+    {
+      "%{g_Vendordir}/glm-1.0.0/glm", --used by core
+      
+      "%{prj.name}",
+      "%{prj_Core}",
+
+      -- fluidsim is built straight from the game sources, it only depends on core
+      "%{prj_Crawler}",
+    }
+
+    dependson
+    {
+      "%{prj_Core}",
+    }
+
+    filter "toolset:msc*"
+      buildoptions
+      {
+        "/FIforceinclude.h",
+      }
+
+    filter "toolset:gcc or clang"
+      buildoptions
+      {
+        "-include forceinclude.h",
+      }
+
+    filter {}
+
+    files
+    {
+        "%{prj.name}/*.params",
+        "%{prj_Crawler}/fluidsim/**.h",
+        "%{prj_Crawler}/fluidsim/**.inl",
+        "%{prj_Crawler}/fluidsim/**.cpp",
+    }
+
+    libdirs
+    {
+    }
+
+    links
+    {
+      "%{prj_Core}",
+    }
+
+    filter "system:linux"
+      links
+      {
+        "pthread",
+      }
+
+    filter "configurations:Debug"
+      defines
+      {
+      }
+
+    filter "configurations:ReleasePdb"
+      defines
+      {
+      }
+
+    filter "configurations:Release"
+      defines
+      {
+      }
+
+     filter "configurations:Final"
+      defines
+      {
+      }
+
 group "3rdparty"
   ----------------------------------------------------------------------
   ----------------------------------ImGui-------------------------------
@@ -1,45 +1,243 @@
 #include "FluidSim2D.h"
+#include "FluidSimInputLog2D.h"
+#include "FluidSimSnapshot2D.h"
+#include "sim_channels.h"
+#include "system/hash.h"
+
+#include <atomic>
 
 FluidSim2D::FluidSim2D(FluidSimOptions2D options) :
     m_data(options)
-{ }
+{
+    SelectKernel(options);
+    if( options.solver == FluidSimSolver2D::Flip )
+        m_grid = std::make_unique<FluidSimGrid2D>(options);
+}
 
 void FluidSim2D::Simulate(
     f64 delta_time,
     const std::vector<FluidSimExternalForce2D>& external_forces)
 {
-    m_data.FillPredictedPositions();
-    m_data.BuildSpatialLookup(true);
+    sys::moment step_start = sys::now();
+    m_stats.neighbour_search_time = 0.0;
+    m_stats.density_pass_time = 0.0;
+    m_stats.pressure_pass_time = 0.0;
+    m_stats.substep_count = 0;
 
-    for( u64 node_idx = 0; node_idx < m_data.GetNodeCount(); node_idx++ )
+    const FluidSimOptions2D& options = m_data.GetOptions();
+    if( !options.adaptive_time_step )
     {
-        ApplyExternalForces(node_idx, delta_time, external_forces);
-        CalculateDensity(node_idx);
+        SimulateStep(delta_time, external_forces);
+        m_stats.substep_count = 1;
+        m_stats.time_step = delta_time;
+    }
+    else
+    {
+        u32 max_substeps = std::max(options.max_substeps, 1u);
+        f64 remaining_time = delta_time;
+        while( remaining_time > 0.0 )
+        {
+            // When out of substeps the rest are spread evenly, taking longer steps than is stable but keeping to the budget.
+            u32 substeps_left = max_substeps - m_stats.substep_count;
+            f64 substep_time = std::min(remaining_time, std::max(GetStableTimeStep(), remaining_time / substeps_left));
+
+            // Guard against rounding leaving a sliver of time that would cost a whole substep.
+            if( remaining_time - substep_time < delta_time * 1e-6 )
+                substep_time = remaining_time;
+
+            SimulateStep(substep_time, external_forces);
+
+            remaining_time -= substep_time;
+            m_stats.substep_count++;
+            m_stats.time_step = substep_time;
+        }
     }
 
-    for( u64 node_idx = 0; node_idx < m_data.GetNodeCount(); node_idx++ )
+    m_stats.step_time = GetSecondsBetween(step_start, sys::now());
+    m_stats.max_speed = m_maxSpeed;
+    m_stats.max_acceleration = m_maxAcceleration;
+
+    if( m_inputLog )
+        m_inputLog->RecordSimulate(*this, delta_time, external_forces);
+}
+
+void FluidSim2D::SimulateStep(
+    f64 delta_time,
+    const std::vector<FluidSimExternalForce2D>& external_forces)
+{
+    if( m_data.GetOptions().reorder_interval && ++m_stepsSinceReorder >= m_data.GetOptions().reorder_interval )
     {
-        // Must be done after pre-calculating all the densities
-        ApplyPressureForce(node_idx, delta_time);
+        m_data.ReorderNodes();
+        m_stepsSinceReorder = 0;
     }
 
-    m_data.MoveNodes(delta_time);
+    if( m_data.GetOptions().adaptive_time_step )
+        m_stepStartVelocities = m_data.GetNodeVelocities();
 
-    // Debugging
-    for( FluidNodeInfo2D& node : m_data.GetNodeInfos() )
+    if( m_grid )
     {
-        node.color = { 1.f, 1.f, 1.f };
+        SimulateGridStep(delta_time, external_forces);
+        return;
     }
+
+    bool position_based = m_data.GetOptions().solver == FluidSimSolver2D::PositionBased;
+    if( position_based )
+    {
+        // The position based solver predicts where the external forces take the nodes, the constraints then correct that.
+        m_data.ForEachNodeRange([&](u32 range_begin, u32 range_end, u32)
+            {
+                for( u64 node_idx = range_begin; node_idx < range_end; node_idx++ )
+                {
+                    if( m_data.IsNodeAwake(u32_cast(node_idx)) )
+                        ApplyExternalForces(node_idx, delta_time, external_forces);
+                }
+            });
+
+        m_data.FillPredictedPositions(f32_cast(delta_time));
+    }
+    else
+    {
+        m_data.FillPredictedPositions();
+    }
+
+    sys::moment search_start = sys::now();
+    bool use_lists = m_data.GetOptions().neighbour_lists;
+    bool lists_rebuilt = false;
+    if( use_lists )
+        lists_rebuilt = m_data.UpdateNeighbourLists();
+    else
+        m_data.BuildSpatialLookup(true);
+
+    if( m_data.GetOptions().sleeping )
+    {
+        for( const FluidSimExternalForce2D& force : external_forces )
+        {
+            if( force.type == FluidSimExternalForceType2D::PointForce )
+                m_data.WakeRegion(force.asPointForce.position, force.asPointForce.radius);
+        }
+
+        m_data.UpdateSleep();
+    }
+
+    sys::moment density_start = sys::now();
+    if( position_based )
+        (this->*m_constraintPass)(delta_time);
+    else
+        (this->*m_densityPass)(delta_time, external_forces);
+
+    sys::moment pressure_start = sys::now();
+    if( !position_based )
+        (this->*m_pressurePass)(delta_time);
+
+    sys::moment pressure_end = sys::now();
+
+    if( position_based )
+    {
+        // Velocities only exist once the nodes have moved to their corrected positions.
+        m_data.MoveNodesToPredicted(delta_time);
+        if( m_data.GetOptions().adaptive_time_step )
+            MeasureMotion(delta_time);
+    }
+    else
+    {
+        // Measured before moving so edge bounces don't count as acceleration.
+        if( m_data.GetOptions().adaptive_time_step )
+            MeasureMotion(delta_time);
+
+        m_data.MoveNodes(delta_time);
+    }
+
+    // Debugging
+    m_data.ForEachNodeRange([&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u64 node_idx = range_begin; node_idx < range_end; node_idx++ )
+            {
+                m_data.GetNodeColors()[node_idx] = { 1.f, 1.f, 1.f };
+            }
+        });
+
+    m_stats.neighbour_search_time += GetSecondsBetween(search_start, density_start);
+    m_stats.density_pass_time += GetSecondsBetween(density_start, pressure_start);
+    m_stats.pressure_pass_time += GetSecondsBetween(pressure_start, pressure_end);
+    m_stats.neighbour_lists_rebuilt = lists_rebuilt;
+    m_stats.awake_node_count = m_data.GetAwakeNodeCount();
+}
+
+void FluidSim2D::SimulateGridStep(
+    f64 delta_time,
+    const std::vector<FluidSimExternalForce2D>& external_forces)
+{
+    // Forces go on the nodes before the transfer, so the grid's change of velocity is only the projection's.
+    sys::moment transfer_start = sys::now();
+    m_data.ForEachNodeRange([&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u64 node_idx = range_begin; node_idx < range_end; node_idx++ )
+            {
+                ApplyExternalForces(node_idx, delta_time, external_forces);
+            }
+        });
+
+    m_grid->TransferToGrid(m_data);
+
+    sys::moment project_start = sys::now();
+    m_grid->Project();
+    m_grid->TransferToNodes(m_data);
+
+    sys::moment project_end = sys::now();
+
+    if( m_data.GetOptions().adaptive_time_step )
+        MeasureMotion(delta_time);
+
+    // Also rebuilds the spatial lookup, which keeps reordering the nodes into cell order for the transfers.
+    m_data.MoveNodes(delta_time);
+
+    m_stats.density_pass_time += GetSecondsBetween(transfer_start, project_start);
+    m_stats.pressure_pass_time += GetSecondsBetween(project_start, project_end);
+    m_stats.neighbour_count = 0;
+    m_stats.candidate_count = 0;
+    m_stats.collision_count = 0;
+    m_stats.neighbour_lists_rebuilt = false;
+    m_stats.awake_node_count = m_data.GetNodeCount();
+    m_stats.pressure_iterations = m_grid->GetPressureIterations();
+    m_stats.pressure_residual = m_grid->GetPressureResidual();
 }
 
 void FluidSim2D::ApplyDebug(const std::vector<FluidSimExternalDebug2D>& external_debug)
 {
     ApplyExternalDebug(external_debug);
+
+    if( m_inputLog )
+        m_inputLog->RecordApplyDebug(external_debug);
 }
 
-void FluidSim2D::InsertNode(FluidNodeInfo2D node, glm::f32vec2 position)
+void FluidSim2D::SetInputLog(FluidSimInputLog2D* input_log)
 {
-    m_data.InsertNode(node, position);
+    m_inputLog = input_log;
+}
+
+void FluidSim2D::SetObstacles(const FluidSimObstacles2D* obstacles)
+{
+    m_data.SetObstacles(obstacles);
+}
+
+FluidNodeHandle2D FluidSim2D::InsertNode(FluidNodeInfo2D node, glm::f32vec2 position)
+{
+    return m_data.InsertNode(node, position);
+}
+
+void FluidSim2D::InsertNodes(std::span<const FluidNodeInfo2D> nodes, std::span<const glm::f32vec2> positions, std::span<FluidNodeHandle2D> handles)
+{
+    m_data.InsertNodes(nodes, positions, handles);
+}
+
+u32 FluidSim2D::RemoveNodes(std::span<const FluidNodeHandle2D> handles)
+{
+    return m_data.RemoveNodes(handles);
+}
+
+void FluidSim2D::ReserveNodes(u32 node_count)
+{
+    m_data.ReserveNodes(node_count);
 }
 
 void FluidSim2D::FinishInserting()
@@ -52,9 +250,85 @@ void FluidSim2D::Clear()
     m_data.ClearNodes();
 }
 
-const std::vector<FluidNodeInfo2D>& FluidSim2D::GetNodeInfos() const
+void FluidSim2D::WriteNodeInfos(FluidNodeInfo2D* destination) const
+{
+    m_data.WriteNodeInfos(destination);
+}
+
+FluidSimFrame2D& FluidSim2D::BeginPublish()
+{
+    FluidSimFrame2D& frame = m_frames[m_publishFrame];
+    frame.positions.assign(m_data.GetNodePositions().begin(), m_data.GetNodePositions().end());
+    frame.node_infos.resize(GetNodeCount());
+    m_data.WriteNodeInfos(frame.node_infos.data());
+    frame.stats = m_stats;
+    frame.sequence = ++m_publishSequence;
+    return frame;
+}
+
+void FluidSim2D::EndPublish()
+{
+    std::lock_guard<std::mutex> lock(m_frameMutex);
+    std::swap(m_publishFrame, m_readyFrame);
+    m_frameReady = true;
+}
+
+void FluidSim2D::Publish()
+{
+    BeginPublish();
+    EndPublish();
+}
+
+const FluidSimFrame2D& FluidSim2D::Acquire()
+{
+    std::lock_guard<std::mutex> lock(m_frameMutex);
+    if( m_frameReady )
+    {
+        std::swap(m_acquiredFrame, m_readyFrame);
+        m_frameReady = false;
+    }
+
+    return m_frames[m_acquiredFrame];
+}
+
+std::vector<u8> FluidSim2D::SaveSnapshot() const
 {
-    return m_data.GetNodeInfos();
+    FluidSimSnapshotHeader2D header{ };
+    header.steps_since_reorder = m_stepsSinceReorder;
+    header.max_speed = m_maxSpeed;
+    header.max_acceleration = m_maxAcceleration;
+
+    std::vector<u8> snapshot;
+    m_data.WriteSnapshot(header, snapshot);
+    return snapshot;
+}
+
+bool FluidSim2D::LoadSnapshot(std::span<const u8> snapshot)
+{
+    const FluidSimSnapshotHeader2D* header = ReadSnapshotHeader(snapshot);
+    if( !header )
+    {
+        FLUIDSIM_ERROR("Not a snapshot this build can load.");
+        return false;
+    }
+
+    const FluidSimOptions2D& options = m_data.GetOptions();
+    if( header->options.extent != options.extent || header->options.grid_extent != options.grid_extent || header->options.grid_mode != options.grid_mode )
+    {
+        FLUIDSIM_ERROR("Snapshot was saved with a different domain.");
+        return false;
+    }
+
+    if( !m_data.ReadSnapshot(*header, snapshot) )
+    {
+        FLUIDSIM_ERROR("Snapshot node ids or sleep states are inconsistent.");
+        return false;
+    }
+
+    m_stepsSinceReorder = header->steps_since_reorder;
+    m_maxSpeed = header->max_speed;
+    m_maxAcceleration = header->max_acceleration;
+    return true;
 }
 
 const std::vector<glm::f32vec4>& FluidSim2D::GetNodePositions() const
@@ -62,108 +336,864 @@ const std::vector<glm::f32vec4>& FluidSim2D::GetNodePositions() const
     return m_data.GetNodePositions();
 }
 
+const std::vector<glm::f32vec2>& FluidSim2D::GetNodeVelocities() const
+{
+    return m_data.GetNodeVelocities();
+}
+
+const std::vector<u32>& FluidSim2D::GetNodeIds() const
+{
+    return m_data.GetNodeIds();
+}
+
+u32 FluidSim2D::GetNodeIndex(u32 node_id) const
+{
+    return m_data.GetNodeIndex(node_id);
+}
+
+u32 FluidSim2D::GetNodeIdCapacity() const
+{
+    return m_data.GetNodeIdCapacity();
+}
+
+FluidNodeHandle2D FluidSim2D::GetNodeHandle(u32 node_index) const
+{
+    return m_data.GetNodeHandle(node_index);
+}
+
+bool FluidSim2D::IsNodeAlive(FluidNodeHandle2D handle) const
+{
+    return m_data.IsNodeAlive(handle);
+}
+
 u32 FluidSim2D::GetNodeCount() const
 {
     return m_data.GetNodeCount();
 }
 
-f32 FluidSim2D::SmoothingFunction(f32 radius, f32 dst) const
+const FluidSimOptions2D& FluidSim2D::GetOptions() const
 {
-    f32 volume = (glm::pi<f32>() * std::pow(radius, 4.f)) / 6.f;
-    return (radius - dst) * (radius - dst) / volume;
+    return m_data.GetOptions();
 }
 
-f32 FluidSim2D::SmoothingFunctionDerivitive(f32 radius, f32 dst) const
+const FluidSimStats2D& FluidSim2D::GetStats() const
 {
-    f32 scale = 12.f / (std::pow(radius, 4.f) * glm::pi<f32>());
-    return (dst - radius) * scale;
+    return m_stats;
 }
 
-void FluidSim2D::CalculateDensity(u64 node_idx)
+u64 FluidSim2D::CalculateChecksum() const
 {
-    // Our grid extent will match our smoothing radius, so we only need to check +-1 around our current cell.
+    std::vector<glm::f32vec4> state;
+    state.reserve(GetNodeCount());
+    for( u32 node_id = 0; node_id < m_data.GetNodeIdCapacity(); node_id++ )
+    {
+        u32 node_idx = m_data.GetNodeIndex(node_id);
+        if( node_idx == FluidSimData2D::invalid_node_index )
+            continue;
+
+        const glm::f32vec4& position = m_data.GetNodePositions()[node_idx];
+        const glm::f32vec2& velocity = m_data.GetNodeVelocities()[node_idx];
+        state.push_back({ position.x, position.y, velocity.x, velocity.y });
+    }
+
+    return sys::hash64(state.data(), state.size() * sizeof(glm::f32vec4));
+}
+
+f64 FluidSim2D::GetStableTimeStep() const
+{
+    // Largest dt with speed * dt + acceleration * dt^2 / 2 <= cfl distance.
+    f64 max_distance = f64_cast(m_data.GetOptions().cfl_factor) * m_kernel.radius;
+    f64 speed = m_maxSpeed;
+    f64 acceleration = m_maxAcceleration;
+    if( acceleration > 0.0 )
+        return (std::sqrt(speed * speed + 2.0 * acceleration * max_distance) - speed) / acceleration;
+
+    if( speed > 0.0 )
+        return max_distance / speed;
+
+    return std::numeric_limits<f64>::max();
+}
+
+void FluidSim2D::MeasureMotion(f64 delta_time)
+{
+    // Squared speed and squared velocity change per range, then the max over ranges.
+    const std::vector<glm::f32vec2>& velocities = m_data.GetNodeVelocities();
+    m_rangeMotion.assign(m_data.GetRangeCount(), { 0.f, 0.f });
+    m_data.ForEachNodeRange([&](u32 range_begin, u32 range_end, u32 range_index)
+        {
+            glm::f32vec2 max_motion{ 0.f, 0.f };
+            for( u32 node_idx = range_begin; node_idx < range_end; node_idx++ )
+            {
+                glm::f32vec2 velocity_change = velocities[node_idx] - m_stepStartVelocities[node_idx];
+                max_motion.x = std::max(max_motion.x, glm::dot(velocities[node_idx], velocities[node_idx]));
+                max_motion.y = std::max(max_motion.y, glm::dot(velocity_change, velocity_change));
+            }
+
+            m_rangeMotion[range_index] = max_motion;
+        });
+
+    glm::f32vec2 max_motion{ 0.f, 0.f };
+    for( const glm::f32vec2& range_motion : m_rangeMotion )
+    {
+        max_motion = glm::max(max_motion, range_motion);
+    }
+
+    m_maxSpeed = std::sqrt(max_motion.x);
+    m_maxAcceleration = f32_cast(std::sqrt(max_motion.y) / delta_time);
+}
+
+void FluidSim2D::SelectKernel(const FluidSimOptions2D& options)
+{
+    switch( options.kernel )
+    {
+        case FluidSimKernel2D::Poly6:
+            SelectKernel<FluidSimPoly6Kernel2D>(options.precision);
+            break;
+        case FluidSimKernel2D::CubicSpline:
+            SelectKernel<FluidSimCubicSplineKernel2D>(options.precision);
+            break;
+        case FluidSimKernel2D::Wendland:
+            SelectKernel<FluidSimWendlandKernel2D>(options.precision);
+            break;
+        default:
+            SelectKernel<FluidSimSpikyKernel2D>(options.precision);
+            break;
+    }
+}
+
+template<typename Kernel>
+void FluidSim2D::SelectKernel(FluidSimPrecision2D precision)
+{
+    m_kernel = MakeKernelConstants2D<Kernel>(m_data.GetOptions().smoothing_radius);
+    if( precision == FluidSimPrecision2D::F64 )
+    {
+        m_densityPass = &FluidSim2D::DensityPass<Kernel, FluidSimF64Precision2D>;
+        m_pressurePass = &FluidSim2D::PressurePass<Kernel, FluidSimF64Precision2D>;
+        m_constraintPass = &FluidSim2D::ConstraintPass<Kernel, FluidSimF64Precision2D>;
+    }
+    else
+    {
+        m_densityPass = &FluidSim2D::DensityPass<Kernel, FluidSimF32Precision2D>;
+        m_pressurePass = &FluidSim2D::PressurePass<Kernel, FluidSimF32Precision2D>;
+        m_constraintPass = &FluidSim2D::ConstraintPass<Kernel, FluidSimF32Precision2D>;
+    }
+}
+
+template<typename Kernel, typename Precision>
+void FluidSim2D::DensityPass(f64 delta_time, const std::vector<FluidSimExternalForce2D>& external_forces)
+{
+    // Each pass only writes to the node it is processing and only reads neighbouring state
+    // that isn't written until the next pass, so ranges can safely run in parallel.
+    std::atomic<u64> neighbour_count{ 0 };
+    std::atomic<u64> candidate_count{ 0 };
+    std::atomic<u64> collision_count{ 0 };
+    bool use_simd = Precision::vectorised && m_data.GetOptions().simd_kernels;
+    m_data.ForEachNodeRange([&](u32 range_begin, u32 range_end, u32)
+        {
+            u64 range_neighbours = 0;
+            u64 range_candidates = 0;
+            u64 range_collisions = 0;
+            for( u64 node_idx = range_begin; node_idx < range_end; node_idx++ )
+            {
+                // Sleeping nodes keep their density and velocity from when they fell asleep.
+                if( !m_data.IsNodeAwake(u32_cast(node_idx)) )
+                    continue;
+
+                ApplyExternalForces(node_idx, delta_time, external_forces);
+
+                FluidSimLookupCounters2D lookup_counters{ };
+                range_neighbours += use_simd
+                    ? CalculateDensitySimd<Kernel>(node_idx, lookup_counters)
+                    : CalculateDensity<Kernel, Precision>(node_idx, lookup_counters);
+                range_candidates += lookup_counters.candidate_count;
+                range_collisions += lookup_counters.collision_count;
+            }
+
+            neighbour_count += range_neighbours;
+            candidate_count += range_candidates;
+            collision_count += range_collisions;
+        });
+
+    m_stats.neighbour_count = neighbour_count.load();
+    m_stats.candidate_count = candidate_count.load();
+    m_stats.collision_count = collision_count.load();
+}
+
+template<typename Kernel, typename Precision>
+void FluidSim2D::PressurePass(f64 delta_time)
+{
+    const FluidSimOptions2D& options = m_data.GetOptions();
+    if( options.symmetric_pressure && !options.neighbour_lists && options.grid_mode != FluidSimGridMode2D::Hashed )
+    {
+        ApplyPressureForcesSymmetric<Kernel, Precision>(delta_time);
+        return;
+    }
+
+    bool use_simd = Precision::vectorised && m_data.GetOptions().simd_kernels;
+    m_data.ForEachNodeRange([&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u64 node_idx = range_begin; node_idx < range_end; node_idx++ )
+            {
+                if( !m_data.IsNodeAwake(u32_cast(node_idx)) )
+                    continue;
+
+                // Must be done after pre-calculating all the densities
+                if( use_simd )
+                    ApplyPressureForceSimd<Kernel>(node_idx, delta_time);
+                else
+                    ApplyPressureForce<Kernel, Precision>(node_idx, delta_time);
+            }
+        });
+}
+
+template<typename Kernel, typename Precision>
+void FluidSim2D::ConstraintPass(f64)
+{
+    const FluidSimOptions2D& options = m_data.GetOptions();
+    m_constraintMultipliers.resize(m_data.GetNodeCount());
+    m_constraintCorrections.resize(m_data.GetNodeCount());
+
+    std::vector<glm::f32vec2>& predicted_positions = m_data.GetNodePredictedPositions();
+    f32 tensile_reference = f32_cast(Kernel::Value(tensile_distance * m_kernel.radius, m_kernel));
+    bool use_simd = Precision::vectorised && options.simd_kernels;
+    u32 iterations = std::max(options.pbf_iterations, 1u);
+    for( u32 iteration = 0; iteration < iterations; iteration++ )
+    {
+        // Sleeping nodes don't move, but their multipliers still push on awake neighbours.
+        std::atomic<u64> neighbour_count{ 0 };
+        std::atomic<u64> candidate_count{ 0 };
+        std::atomic<u64> collision_count{ 0 };
+        m_data.ForEachNodeRange([&](u32 range_begin, u32 range_end, u32)
+            {
+                u64 range_neighbours = 0;
+                u64 range_candidates = 0;
+                u64 range_collisions = 0;
+                for( u64 node_idx = range_begin; node_idx < range_end; node_idx++ )
+                {
+                    FluidSimLookupCounters2D lookup_counters{ };
+                    range_neighbours += use_simd
+                        ? CalculateConstraintMultiplierSimd<Kernel>(node_idx, lookup_counters)
+                        : CalculateConstraintMultiplier<Kernel, Precision>(node_idx, lookup_counters);
+                    range_candidates += lookup_counters.candidate_count;
+                    range_collisions += lookup_counters.collision_count;
+                }
+
+                neighbour_count += range_neighbours;
+                candidate_count += range_candidates;
+                collision_count += range_collisions;
+            });
+
+        m_data.ForEachNodeRange([&](u32 range_begin, u32 range_end, u32)
+            {
+                for( u64 node_idx = range_begin; node_idx < range_end; node_idx++ )
+                {
+                    if( !m_data.IsNodeAwake(u32_cast(node_idx)) )
+                        continue;
+
+                    m_constraintCorrections[node_idx] = use_simd
+                        ? CalculateConstraintCorrectionSimd<Kernel>(node_idx, tensile_reference)
+                        : CalculateConstraintCorrection<Kernel, Precision>(node_idx, tensile_reference);
+                }
+            });
+
+        // Only moved once every correction is known, the corrections read the neighbours' predicted positions.
+        m_data.ForEachNodeRange([&](u32 range_begin, u32 range_end, u32)
+            {
+                for( u64 node_idx = range_begin; node_idx < range_end; node_idx++ )
+                {
+                    if( !m_data.IsNodeAwake(u32_cast(node_idx)) )
+                        continue;
+
+                    predicted_positions[node_idx] += m_constraintCorrections[node_idx];
+                    m_data.HandlePredictedEdge(u32_cast(node_idx));
+                }
+            });
+
+        // The vectorised passes walk the lookup's copy of the positions, neighbour lists gather the live ones.
+        if( use_simd && !options.neighbour_lists && iteration + 1 < iterations )
+            m_data.FillLookupPositions();
+
+        // Every iteration visits the same pairs, the first one's counts stand for the step.
+        if( iteration == 0 )
+        {
+            m_stats.neighbour_count = neighbour_count.load();
+            m_stats.candidate_count = candidate_count.load();
+            m_stats.collision_count = collision_count.load();
+        }
+    }
+}
+
+template<typename Kernel, typename Precision>
+u32 FluidSim2D::CalculateConstraintMultiplier(u64 node_idx, FluidSimLookupCounters2D& lookup_counters)
+{
+    using scalar = typename Precision::scalar;
+    using vec2 = typename Precision::vec2;
+
+    // The constraint is density / target_density - 1 and its gradient with respect to a neighbour's position is
+    // mass / target_density * -grad W, the node's own gradient being the negated sum of those.
     const std::vector<glm::f32vec2>& node_positions = m_data.GetNodePredictedPositions();
-    std::vector<FluidNodeInfo2D>& node_infos = m_data.GetNodeInfos();
-    FluidNodeInfo2D& current_info = node_infos[node_idx];
-    current_info.density = 0;
+    const std::vector<f32>& masses = m_data.GetNodeMasses();
+    glm::f32vec2 current_position = node_positions[node_idx];
+    scalar inverse_target_density = scalar(1) / scalar(m_data.GetOptions().target_density);
 
-    glm::f32vec2 node_position = node_positions[node_idx];
-    ForEachNodeInRadius(node_position, m_data.GetOptions().smoothing_radius, [&](FluidNodeInfo2D& node, const glm::f32vec2&, u32 node_index)
+    scalar density = 0;
+    vec2 gradient_sum{ 0, 0 };
+    scalar gradient_length_sum = 0;
+    u32 neighbour_count = 0;
+    auto accumulate = [&](u32 node_index, const glm::f32vec2& position, f32 lookup_distance)
         {
             if( node_index == node_idx )
                 return;
 
-            glm::f32vec2 position = m_data.GetNodePredictedPositions()[node_index];
+            scalar distance = Precision::Distance(current_position, position, lookup_distance);
+            scalar mass = masses[node_index];
+            density += mass * Kernel::Value(distance, m_kernel);
+            neighbour_count++;
+
+            if( lookup_distance <= 0.0005f )
+                return; // Too close to have a direction
+
+            vec2 gradient = (vec2(current_position) - vec2(position)) * (mass * inverse_target_density * Kernel::Slope(distance, m_kernel) / distance);
+            gradient_sum += gradient;
+            gradient_length_sum += glm::dot(gradient, gradient);
+        };
+
+    lookup_counters = m_data.GetOptions().neighbour_lists
+        ? m_data.ForEachNeighbour(u32_cast(node_idx), m_kernel.radius, accumulate)
+        : m_data.ForEachNodeInRadius(current_position, m_kernel.radius, accumulate);
+
+    m_data.GetNodeDensities()[node_idx] = f32_cast(density);
+
+    // Clamped so the constraint only pushes nodes apart, under-dense nodes at the surface aren't pulled together.
+    scalar constraint = density * inverse_target_density - scalar(1);
+    scalar gradient_norm = glm::dot(gradient_sum, gradient_sum) + gradient_length_sum + scalar(m_data.GetOptions().pbf_relaxation);
+    m_constraintMultipliers[node_idx] = constraint > 0 && gradient_norm > 0 ? f32_cast(-constraint / gradient_norm) : 0.f;
+    return neighbour_count;
+}
+
+template<typename Kernel, typename Precision>
+glm::f32vec2 FluidSim2D::CalculateConstraintCorrection(u64 node_idx, f32 tensile_reference) const
+{
+    using scalar = typename Precision::scalar;
+    using vec2 = typename Precision::vec2;
+
+    const std::vector<glm::f32vec2>& node_positions = m_data.GetNodePredictedPositions();
+    const std::vector<f32>& masses = m_data.GetNodeMasses();
+    glm::f32vec2 current_position = node_positions[node_idx];
+    scalar current_multiplier = m_constraintMultipliers[node_idx];
+    scalar inverse_target_density = scalar(1) / scalar(m_data.GetOptions().target_density);
+    scalar inverse_tensile_reference = tensile_reference > 0.f ? scalar(1) / scalar(tensile_reference) : scalar(0);
+
+    vec2 correction{ 0, 0 };
+    auto accumulate = [&](u32 node_index, const glm::f32vec2& position, f32 lookup_distance)
+        {
+            if( node_index == node_idx || lookup_distance <= 0.0005f )
+                return;
+
+            scalar distance = Precision::Distance(current_position, position, lookup_distance);
+            scalar tensile_ratio = Kernel::Value(distance, m_kernel) * inverse_tensile_reference;
+            tensile_ratio = tensile_ratio > scalar(min_tensile_ratio) ? tensile_ratio * tensile_ratio : scalar(0);
+            scalar tensile_correction = -scalar(tensile_strength) * tensile_ratio * tensile_ratio;
+
+            scalar multiplier = current_multiplier + scalar(m_constraintMultipliers[node_index]) + tensile_correction;
+            scalar slope = Kernel::Slope(distance, m_kernel);
+            correction += (vec2(current_position) - vec2(position)) * (multiplier * scalar(masses[node_index]) * inverse_target_density * slope / distance);
+        };
+
+    if( m_data.GetOptions().neighbour_lists )
+        m_data.ForEachNeighbour(u32_cast(node_idx), m_kernel.radius, accumulate);
+    else
+        m_data.ForEachNodeInRadius(current_position, m_kernel.radius, accumulate);
+
+    return glm::f32vec2(correction);
+}
+
+template<typename Kernel>
+u32 FluidSim2D::CalculateConstraintMultiplierSimd(u64 node_idx, FluidSimLookupCounters2D& lookup_counters)
+{
+    using simd = FluidSimSimd;
+    glm::f32vec2 node_position = m_data.GetNodePredictedPositions()[node_idx];
+    const f32* masses = m_data.GetNodeMasses().data();
+    f32 inverse_target_density = 1.f / m_data.GetOptions().target_density;
+    simd::floats position_x = simd::Set(node_position.x);
+    simd::floats position_y = simd::Set(node_position.y);
+    simd::floats radius_squared = simd::Set(m_kernel.radius_squared);
+    simd::floats min_distance = simd::Set(0.0005f);
+    simd::floats gradient_scale = simd::Set(inverse_target_density);
 
-            f32 distance = glm::length(position - node_position);
-            f32 influence = SmoothingFunction(m_data.GetOptions().smoothing_radius, distance);
-            current_info.density += current_info.mass * influence;
+    // The gradients are summed with the opposite sign to the scalar pass, only their squared lengths are used.
+    simd::floats density_sum = simd::Set(0.f);
+    simd::floats gradient_x = simd::Set(0.f);
+    simd::floats gradient_y = simd::Set(0.f);
+    simd::floats gradient_length_sum = simd::Set(0.f);
+    u32 neighbour_count = 0;
+    lookup_counters = ForEachSimdBatch(node_idx, [&](simd::floats other_x, simd::floats other_y, simd::indices node_indices, simd::mask valid_lanes)
+        {
+            simd::floats delta_x = simd::Sub(other_x, position_x);
+            simd::floats delta_y = simd::Sub(other_y, position_y);
+            simd::floats distance_squared = simd::Add(simd::Mul(delta_x, delta_x), simd::Mul(delta_y, delta_y));
+            simd::floats distance = simd::Sqrt(distance_squared);
+
+            simd::mask in_radius = simd::And(valid_lanes, simd::LessEqual(distance_squared, radius_squared));
+            in_radius = simd::AndNot(simd::IndexEquals(node_indices, u32_cast(node_idx)), in_radius);
+            simd::mask has_direction = simd::And(in_radius, simd::Greater(distance, min_distance));
+
+            simd::floats mass = simd::Gather(masses, node_indices);
+            density_sum = simd::Add(density_sum, simd::Select(in_radius, simd::Mul(mass, Kernel::ShapeSimd(distance, m_kernel))));
+            neighbour_count += simd::MaskCount(in_radius);
+
+            simd::floats scale = simd::Select(has_direction, simd::Div(
+                simd::Mul(simd::Mul(mass, gradient_scale), Kernel::SlopeSimd(distance, m_kernel)),
+                distance));
+            simd::floats pair_x = simd::Mul(delta_x, scale);
+            simd::floats pair_y = simd::Mul(delta_y, scale);
+            gradient_x = simd::Add(gradient_x, pair_x);
+            gradient_y = simd::Add(gradient_y, pair_y);
+            gradient_length_sum = simd::Add(gradient_length_sum, simd::Add(simd::Mul(pair_x, pair_x), simd::Mul(pair_y, pair_y)));
         });
+
+    f32 density = simd::Sum(density_sum) * m_kernel.density_scale;
+    m_data.GetNodeDensities()[node_idx] = density;
+
+    glm::f32vec2 gradient_sum{ simd::Sum(gradient_x), simd::Sum(gradient_y) };
+    f32 constraint = density * inverse_target_density - 1.f;
+    f32 gradient_norm = glm::dot(gradient_sum, gradient_sum) + simd::Sum(gradient_length_sum) + m_data.GetOptions().pbf_relaxation;
+    m_constraintMultipliers[node_idx] = constraint > 0.f && gradient_norm > 0.f ? -constraint / gradient_norm : 0.f;
+    return neighbour_count;
 }
 
+template<typename Kernel>
+glm::f32vec2 FluidSim2D::CalculateConstraintCorrectionSimd(u64 node_idx, f32 tensile_reference) const
+{
+    using simd = FluidSimSimd;
+    glm::f32vec2 node_position = m_data.GetNodePredictedPositions()[node_idx];
+    const f32* masses = m_data.GetNodeMasses().data();
+    const f32* multipliers = m_constraintMultipliers.data();
+    simd::floats position_x = simd::Set(node_position.x);
+    simd::floats position_y = simd::Set(node_position.y);
+    simd::floats radius_squared = simd::Set(m_kernel.radius_squared);
+    simd::floats min_distance = simd::Set(0.0005f);
+    simd::floats current_multiplier = simd::Set(m_constraintMultipliers[node_idx]);
+    simd::floats gradient_scale = simd::Set(1.f / m_data.GetOptions().target_density);
+    simd::floats tensile_scale = simd::Set(tensile_reference > 0.f ? m_kernel.density_scale / tensile_reference : 0.f);
+    simd::floats tensile_strength_lanes = simd::Set(tensile_strength);
+    simd::floats min_ratio = simd::Set(min_tensile_ratio);
+
+    simd::floats correction_x = simd::Set(0.f);
+    simd::floats correction_y = simd::Set(0.f);
+    ForEachSimdBatch(node_idx, [&](simd::floats other_x, simd::floats other_y, simd::indices node_indices, simd::mask valid_lanes)
+        {
+            simd::floats delta_x = simd::Sub(other_x, position_x);
+            simd::floats delta_y = simd::Sub(other_y, position_y);
+            simd::floats distance_squared = simd::Add(simd::Mul(delta_x, delta_x), simd::Mul(delta_y, delta_y));
+            simd::floats distance = simd::Sqrt(distance_squared);
+
+            simd::mask in_radius = simd::And(valid_lanes, simd::LessEqual(distance_squared, radius_squared));
+            in_radius = simd::And(in_radius, simd::Greater(distance, min_distance));
+            in_radius = simd::AndNot(simd::IndexEquals(node_indices, u32_cast(node_idx)), in_radius);
+
+            simd::floats tensile_ratio = simd::Mul(Kernel::ShapeSimd(distance, m_kernel), tensile_scale);
+            tensile_ratio = simd::Select(simd::Greater(tensile_ratio, min_ratio), tensile_ratio);
+            tensile_ratio = simd::Mul(tensile_ratio, tensile_ratio);
+            simd::floats tensile_correction = simd::Mul(tensile_strength_lanes, simd::Mul(tensile_ratio, tensile_ratio));
+
+            simd::floats multiplier = simd::Sub(simd::Add(current_multiplier, simd::Gather(multipliers, node_indices)), tensile_correction);
+            simd::floats mass = simd::Gather(masses, node_indices);
+            simd::floats scale = simd::Select(in_radius, simd::Div(
+                simd::Mul(simd::Mul(multiplier, simd::Mul(mass, gradient_scale)), Kernel::SlopeSimd(distance, m_kernel)),
+                distance));
+
+            correction_x = simd::Add(correction_x, simd::Mul(delta_x, scale));
+            correction_y = simd::Add(correction_y, simd::Mul(delta_y, scale));
+        });
+
+    // Summed along other - node, the correction is along node - other.
+    return { -simd::Sum(correction_x), -simd::Sum(correction_y) };
+}
+
+template<typename Kernel, typename Precision>
+u32 FluidSim2D::CalculateDensity(u64 node_idx, FluidSimLookupCounters2D& lookup_counters)
+{
+    using scalar = typename Precision::scalar;
+
+    // Our grid extent will match our smoothing radius, so we only need to check +-1 around our current cell.
+    const std::vector<glm::f32vec2>& node_positions = m_data.GetNodePredictedPositions();
+    glm::f32vec2 current_position = node_positions[node_idx];
+    scalar current_mass = m_data.GetNodeMasses()[node_idx];
+    scalar current_density = 0;
+
+    u32 neighbour_count = 0;
+    auto accumulate = [&](u32 node_index, const glm::f32vec2& position, f32 distance)
+        {
+            if( node_index == node_idx )
+                return;
+
+            scalar influence = Kernel::Value(Precision::Distance(current_position, position, distance), m_kernel);
+            current_density += current_mass * influence;
+            neighbour_count++;
+        };
+
+    lookup_counters = m_data.GetOptions().neighbour_lists
+        ? m_data.ForEachNeighbour(u32_cast(node_idx), m_kernel.radius, accumulate)
+        : m_data.ForEachNodeInRadius(current_position, m_kernel.radius, accumulate);
+
+    m_data.GetNodeDensities()[node_idx] = f32_cast(current_density);
+    return neighbour_count;
+}
+
+template<typename Kernel, typename Precision>
 void FluidSim2D::ApplyPressureForce(u64 node_idx, f64 delta_time)
 {
-    glm::f32vec2 pressure_force{ 0.f, 0.f };
+    using scalar = typename Precision::scalar;
+    using vec2 = typename Precision::vec2;
+
+    vec2 pressure_force{ 0, 0 };
     glm::f32vec2 current_position = m_data.GetNodePredictedPositions()[node_idx];
 
-    FluidNodeInfo2D& current_info = m_data.GetNodeInfos()[node_idx];
-    if( current_info.density <= 0.0005f )
+    const std::vector<f32>& densities = m_data.GetNodeDensities();
+    const std::vector<f32>& masses = m_data.GetNodeMasses();
+    scalar current_density = densities[node_idx];
+    if( current_density <= scalar(0.0005f) )
         return;
 
-
-    ForEachNodeInRadius(current_position, m_data.GetOptions().smoothing_radius, [&](FluidNodeInfo2D& node, const glm::f32vec2&, u32 node_index)
+    auto accumulate = [&](u32 node_index, const glm::f32vec2& position, f32 lookup_distance)
         {
             if( node_index == node_idx )
                 return;
 
-            // The position it gives us is the real position. We want to use the predicted one.
-            glm::f32vec2 position = m_data.GetNodePredictedPositions()[node_index];
-
-            f32 distance = glm::length(position - current_position);
-            if( distance <= 0.0005f )
+            if( lookup_distance <= 0.0005f )
                 return; // We're too close to accurately calculate forces
 
-            f32 density_a = m_data.GetNodeInfos()[node_index].density;
-            f32 density_b = m_data.GetNodeInfos()[node_idx].density;
-            f32 shared_pressure = (DensityAsPressure(density_a) + DensityAsPressure(density_b)) / 2.f;
+            scalar distance = Precision::Distance(current_position, position, lookup_distance);
+            scalar density_a = densities[node_index];
+            scalar density_b = current_density;
+            scalar shared_pressure = (DensityAsPressure(density_a) + DensityAsPressure(density_b)) / scalar(2);
 
-            glm::f32vec2 direction = (position - current_position) / distance;
-            f32 slope = SmoothingFunctionDerivitive(m_data.GetOptions().smoothing_radius, distance);
-            f32 mass = m_data.GetNodeInfos()[node_index].mass;
+            vec2 direction = (vec2(position) - vec2(current_position)) / distance;
+            scalar slope = Kernel::Slope(distance, m_kernel);
+            scalar mass = masses[node_index];
             pressure_force += direction * shared_pressure * slope * mass / density_a;
+        };
+
+    if( m_data.GetOptions().neighbour_lists )
+        m_data.ForEachNeighbour(u32_cast(node_idx), m_kernel.radius, accumulate);
+    else
+        m_data.ForEachNodeInRadius(current_position, m_kernel.radius, accumulate);
+
+    m_data.GetNodeVelocities()[node_idx] += glm::f32vec2(pressure_force / current_density) * f32_cast(delta_time);
+}
+
+template<typename Batch>
+FluidSimLookupCounters2D FluidSim2D::ForEachSimdBatch(u64 node_idx, Batch&& batch) const
+{
+    using simd = FluidSimSimd;
+    if( m_data.GetOptions().neighbour_lists )
+    {
+        // Listed neighbours are scattered through the streams, so positions have to be gathered.
+        const u32* neighbours = m_data.GetNeighbours().data();
+        const f32* positions = &m_data.GetNodePredictedPositions().data()->x;
+        u32 list_begin = m_data.GetNeighbourOffsets()[node_idx];
+        u32 list_end = m_data.GetNeighbourOffsets()[node_idx + 1];
+        for( u32 idx = list_begin; idx < list_end; idx += simd::width )
+        {
+            simd::indices node_indices = simd::LoadIndices(neighbours + idx);
+            batch(
+                simd::GatherInterleaved(positions, node_indices),
+                simd::GatherInterleaved(positions + 1, node_indices),
+                node_indices,
+                simd::FirstLanes(list_end - idx));
+        }
+
+        return { .candidate_count = list_end - list_begin, .collision_count = 0 };
+    }
+
+    const u32* lookup = m_data.GetCellLookup().data();
+    const f32* lookup_x = m_data.GetLookupPositionsX().data();
+    const f32* lookup_y = m_data.GetLookupPositionsY().data();
+    return m_data.ForEachSpanInRadius(m_data.GetNodePredictedPositions()[node_idx], m_kernel.radius, [&](u32 span_begin, u32 span_end)
+        {
+            for( u32 idx = span_begin; idx < span_end; idx += simd::width )
+            {
+                batch(
+                    simd::Load(lookup_x + idx),
+                    simd::Load(lookup_y + idx),
+                    simd::LoadIndices(lookup + idx),
+                    simd::FirstLanes(span_end - idx));
+            }
         });
+}
 
-    current_info.velocity += (pressure_force / current_info.density) * f32_cast(delta_time);
+template<typename Kernel>
+u32 FluidSim2D::CalculateDensitySimd(u64 node_idx, FluidSimLookupCounters2D& lookup_counters)
+{
+    using simd = FluidSimSimd;
+    glm::f32vec2 node_position = m_data.GetNodePredictedPositions()[node_idx];
+    simd::floats position_x = simd::Set(node_position.x);
+    simd::floats position_y = simd::Set(node_position.y);
+    simd::floats radius_squared = simd::Set(m_kernel.radius_squared);
+
+    simd::floats influence_sum = simd::Set(0.f);
+    u32 neighbour_count = 0;
+    lookup_counters = ForEachSimdBatch(node_idx, [&](simd::floats other_x, simd::floats other_y, simd::indices node_indices, simd::mask valid_lanes)
+        {
+            simd::floats delta_x = simd::Sub(other_x, position_x);
+            simd::floats delta_y = simd::Sub(other_y, position_y);
+            simd::floats distance_squared = simd::Add(simd::Mul(delta_x, delta_x), simd::Mul(delta_y, delta_y));
+
+            simd::mask in_radius = simd::And(valid_lanes, simd::LessEqual(distance_squared, radius_squared));
+            in_radius = simd::AndNot(simd::IndexEquals(node_indices, u32_cast(node_idx)), in_radius);
+
+            simd::floats influence = Kernel::ShapeSimd(simd::Sqrt(distance_squared), m_kernel);
+            influence_sum = simd::Add(influence_sum, simd::Select(in_radius, influence));
+            neighbour_count += simd::MaskCount(in_radius);
+        });
+
+    f32 current_mass = m_data.GetNodeMasses()[node_idx];
+    m_data.GetNodeDensities()[node_idx] = current_mass * simd::Sum(influence_sum) * m_kernel.density_scale;
+    return neighbour_count;
 }
 
-void FluidSim2D::ForEachNodeInRadius(glm::f32vec2 sample_point, f32 radius, FluidSimData2D::ForEachNodeFunc function)
+template<typename Kernel>
+void FluidSim2D::ApplyPressureForceSimd(u64 node_idx, f64 delta_time)
 {
-    glm::ivec2 current_cell = m_data.GetCellCoordinates(sample_point);
-    i32 range = i32_cast(std::ceil(radius / std::min(m_data.GetOptions().grid_extent.x, m_data.GetOptions().grid_extent.y)));
+    using simd = FluidSimSimd;
+    const f32* densities = m_data.GetNodeDensities().data();
+    const f32* masses = m_data.GetNodeMasses().data();
+    f32 current_density = densities[node_idx];
+    if( current_density <= 0.0005f )
+        return;
 
-    for( i32 cell_y = current_cell.y - range; cell_y <= current_cell.y + range; cell_y++ )
-    {
-        for( i32 cell_x = current_cell.x - range; cell_x <= current_cell.x + range; cell_x++ )
+    glm::f32vec2 current_position = m_data.GetNodePredictedPositions()[node_idx];
+    simd::floats position_x = simd::Set(current_position.x);
+    simd::floats position_y = simd::Set(current_position.y);
+    simd::floats radius_squared = simd::Set(m_kernel.radius_squared);
+    simd::floats min_distance = simd::Set(0.0005f);
+    simd::floats target_density = simd::Set(m_data.GetOptions().target_density);
+    simd::floats pressure_multiplier = simd::Set(m_data.GetOptions().pressure_multiplier);
+    simd::floats current_pressure = simd::Set(DensityAsPressure(current_density));
+    simd::floats half = simd::Set(0.5f);
+
+    simd::floats force_x = simd::Set(0.f);
+    simd::floats force_y = simd::Set(0.f);
+    ForEachSimdBatch(node_idx, [&](simd::floats other_x, simd::floats other_y, simd::indices node_indices, simd::mask valid_lanes)
+        {
+            simd::floats delta_x = simd::Sub(other_x, position_x);
+            simd::floats delta_y = simd::Sub(other_y, position_y);
+            simd::floats distance_squared = simd::Add(simd::Mul(delta_x, delta_x), simd::Mul(delta_y, delta_y));
+            simd::floats distance = simd::Sqrt(distance_squared);
+
+            // Too close nodes are skipped as we can't accurately calculate a direction.
+            simd::mask in_radius = simd::And(valid_lanes, simd::LessEqual(distance_squared, radius_squared));
+            in_radius = simd::And(in_radius, simd::Greater(distance, min_distance));
+            in_radius = simd::AndNot(simd::IndexEquals(node_indices, u32_cast(node_idx)), in_radius);
+
+            simd::floats density = simd::Gather(densities, node_indices);
+            simd::floats mass = simd::Gather(masses, node_indices);
+            simd::floats pressure = simd::Mul(simd::Sub(density, target_density), pressure_multiplier);
+            simd::floats shared_pressure = simd::Mul(simd::Add(pressure, current_pressure), half);
+            simd::floats slope = Kernel::SlopeSimd(distance, m_kernel);
+
+            // Direction is delta / distance, fold the divide into the per neighbour scale.
+            simd::floats scale = simd::Div(
+                simd::Mul(simd::Mul(shared_pressure, slope), mass),
+                simd::Mul(density, distance));
+
+            force_x = simd::Add(force_x, simd::Select(in_radius, simd::Mul(delta_x, scale)));
+            force_y = simd::Add(force_y, simd::Select(in_radius, simd::Mul(delta_y, scale)));
+        });
+
+    glm::f32vec2 pressure_force{ simd::Sum(force_x), simd::Sum(force_y) };
+    m_data.GetNodeVelocities()[node_idx] += (pressure_force / current_density) * f32_cast(delta_time);
+}
+
+template<typename Kernel, typename Precision>
+void FluidSim2D::ApplyPressureForcesSymmetric(f64 delta_time)
+{
+    // The force on a from b is dir * shared_pressure * slope * mass_b / (density_b * density_a), and the force
+    // on b from a is the same with the direction flipped and mass_a. Everything but the mass is computed once.
+    const std::vector<u32>& lookup = m_data.GetCellLookup();
+    const std::vector<f32>& densities = m_data.GetNodeDensities();
+    const std::vector<f32>& masses = m_data.GetNodeMasses();
+    const f32* lookup_x = m_data.GetLookupPositionsX().data();
+    const f32* lookup_y = m_data.GetLookupPositionsY().data();
+    u32 lookup_size = u32_cast(lookup.size());
+
+    // Nodes only pair with the nodes up to reach cells away from their own, so nodes whose cells are further
+    // apart than twice that never write the same slot. Cells are coloured with a stride of one more than that and
+    // only one colour is run at a time. A cell is never split between ranges, so every slot is written by one
+    // range per colour in lookup order, and the sums don't depend on the range or worker count.
+    glm::f32vec2 grid_extent = m_data.GetOptions().grid_extent;
+    glm::ivec2 reach{ i32_cast(std::ceil(m_kernel.radius / grid_extent.x)), i32_cast(std::ceil(m_kernel.radius / grid_extent.y)) };
+    glm::ivec2 stride = reach * 2 + 1;
+    u32 color_count = u32_cast(stride.x * stride.y);
+
+    // The vectorised kernel reads whole batches, padded like the lookup positions.
+    m_pairPressures.resize(lookup_size + FluidSimCore::lookup_padding);
+    m_pairMassOverDensities.resize(lookup_size + FluidSimCore::lookup_padding);
+    m_pairReceiveScales.resize(lookup_size + FluidSimCore::lookup_padding);
+    m_pairColors.resize(lookup_size);
+    m_pairAccelerationsX.resize(lookup_size);
+    m_pairAccelerationsY.resize(lookup_size);
+
+    m_data.ForEachRange(lookup_size, m_data.GetRangeCount(), [&](u32 range_begin, u32 range_end, u32)
         {
-            glm::ivec2 check_cell{ cell_x, cell_y };
-            m_data.ForEachNodeInCell(check_cell, [&](FluidNodeInfo2D& node, const glm::f32vec2&, u32 node_index)
+            for( u32 lookup_idx = range_begin; lookup_idx < range_end; lookup_idx++ )
+            {
+                u32 node_idx = lookup[lookup_idx];
+                f32 density = densities[node_idx];
+                m_pairPressures[lookup_idx] = DensityAsPressure(density);
+                m_pairMassOverDensities[lookup_idx] = density > 0.f ? masses[node_idx] / density : 0.f;
+                // Nodes with next to no density or that are asleep don't receive pressure forces, but still exert them.
+                bool receives = density > 0.0005f && m_data.IsNodeAwake(node_idx);
+                m_pairReceiveScales[lookup_idx] = receives ? 1.f / density : 0.f;
+
+                glm::ivec2 cell_coords = m_data.GetFiledCellCoordinates({ lookup_x[lookup_idx], lookup_y[lookup_idx] });
+                glm::ivec2 color = ((cell_coords % stride) + stride) % stride;
+                m_pairColors[lookup_idx] = u32_cast(color.y * stride.x + color.x);
+                m_pairAccelerationsX[lookup_idx] = 0.f;
+                m_pairAccelerationsY[lookup_idx] = 0.f;
+            }
+        });
+
+    bool use_simd = Precision::vectorised && m_data.GetOptions().simd_kernels;
+    const std::vector<FluidSimSleepState2D>& sleep_states = m_data.GetNodeSleepStates();
+    for( u32 color = 0; color < color_count; color++ )
+    {
+        m_data.ForEachCellRange([&](u32 range_begin, u32 range_end, u32)
+            {
+                for( u32 lookup_idx = range_begin; lookup_idx < range_end; lookup_idx++ )
                 {
-                    // The position it gives us is the real position. We want to use the predicted one.
-                    glm::f32vec2 position = m_data.GetNodePredictedPositions()[node_index];
+                    if( m_pairColors[lookup_idx] != color )
+                        continue;
 
-                    if( glm::length(position - sample_point) > radius )
-                        return;
+                    // Every pair of a deep sleep node is with another sleeping node, neither side receives anything.
+                    if( !sleep_states.empty() && sleep_states[lookup[lookup_idx]] == FluidSimSleepState2D::DeepSleep )
+                        continue;
 
-                    function(node, position, node_index);
-                });
-        }
+                    if( use_simd )
+                        AccumulatePairForcesSimd<Kernel>(lookup_idx, reach, m_pairAccelerationsX.data(), m_pairAccelerationsY.data());
+                    else
+                        AccumulatePairForces<Kernel, Precision>(lookup_idx, reach, m_pairAccelerationsX.data(), m_pairAccelerationsY.data());
+                }
+            });
     }
+
+    std::vector<glm::f32vec2>& velocities = m_data.GetNodeVelocities();
+    m_data.ForEachRange(lookup_size, m_data.GetRangeCount(), [&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u32 lookup_idx = range_begin; lookup_idx < range_end; lookup_idx++ )
+            {
+                glm::f32vec2 acceleration{ m_pairAccelerationsX[lookup_idx], m_pairAccelerationsY[lookup_idx] };
+                velocities[lookup[lookup_idx]] += acceleration * f32_cast(delta_time);
+            }
+        });
 }
 
-f32 FluidSim2D::DensityAsPressure(f32 density) const
+template<typename Kernel, typename Precision>
+void FluidSim2D::AccumulatePairForces(u32 lookup_idx, glm::ivec2 reach, f32* acceleration_x, f32* acceleration_y) const
 {
-    f32 error = density - m_data.GetOptions().target_density;
-    return error * m_data.GetOptions().pressure_multiplier;
+    using scalar = typename Precision::scalar;
+    using vec2 = typename Precision::vec2;
+
+    const f32* lookup_x = m_data.GetLookupPositionsX().data();
+    const f32* lookup_y = m_data.GetLookupPositionsY().data();
+    glm::f32vec2 current_position{ lookup_x[lookup_idx], lookup_y[lookup_idx] };
+    scalar current_pressure = m_pairPressures[lookup_idx];
+    scalar current_mass_over_density = m_pairMassOverDensities[lookup_idx];
+
+    // The search covers reach cells around the node's own instead of the bounds of its radius, which can round
+    // into one more cell. Nodes are only ever written by the colour pass of the cells within reach.
+    glm::ivec2 cell_coords = m_data.GetFiledCellCoordinates(current_position);
+
+    vec2 current_acceleration{ 0, 0 };
+    m_data.ForEachSpanInCells(cell_coords - reach, cell_coords + reach, [&](u32 span_begin, u32 span_end)
+        {
+            for( u32 idx = std::max(span_begin, lookup_idx + 1); idx < span_end; idx++ )
+            {
+                vec2 delta{ scalar(lookup_x[idx]) - scalar(current_position.x), scalar(lookup_y[idx]) - scalar(current_position.y) };
+                scalar distance = glm::length(delta);
+                if( distance > scalar(m_kernel.radius) || distance <= scalar(0.0005f) )
+                    continue;
+
+                scalar shared_pressure = (current_pressure + scalar(m_pairPressures[idx])) / scalar(2);
+                vec2 pair_force = delta * (shared_pressure * Kernel::Slope(distance, m_kernel) / distance);
+
+                current_acceleration += pair_force * scalar(m_pairMassOverDensities[idx]);
+                acceleration_x[idx] -= f32_cast(pair_force.x * current_mass_over_density * scalar(m_pairReceiveScales[idx]));
+                acceleration_y[idx] -= f32_cast(pair_force.y * current_mass_over_density * scalar(m_pairReceiveScales[idx]));
+            }
+        });
+
+    acceleration_x[lookup_idx] += f32_cast(current_acceleration.x * scalar(m_pairReceiveScales[lookup_idx]));
+    acceleration_y[lookup_idx] += f32_cast(current_acceleration.y * scalar(m_pairReceiveScales[lookup_idx]));
+}
+
+template<typename Kernel>
+void FluidSim2D::AccumulatePairForcesSimd(u32 lookup_idx, glm::ivec2 reach, f32* acceleration_x, f32* acceleration_y) const
+{
+    using simd = FluidSimSimd;
+    const f32* lookup_x = m_data.GetLookupPositionsX().data();
+    const f32* lookup_y = m_data.GetLookupPositionsY().data();
+    const f32* pressures = m_pairPressures.data();
+    const f32* mass_over_densities = m_pairMassOverDensities.data();
+    const f32* receive_scales = m_pairReceiveScales.data();
+
+    glm::f32vec2 current_position{ lookup_x[lookup_idx], lookup_y[lookup_idx] };
+    simd::floats position_x = simd::Set(current_position.x);
+    simd::floats position_y = simd::Set(current_position.y);
+    simd::floats radius_squared = simd::Set(m_kernel.radius_squared);
+    simd::floats min_distance = simd::Set(0.0005f);
+    simd::floats current_pressure = simd::Set(pressures[lookup_idx]);
+    simd::floats current_mass_over_density = simd::Set(mass_over_densities[lookup_idx]);
+    simd::floats half = simd::Set(0.5f);
+
+    // Same search as the scalar kernel. Spans only hold the cells within reach, which no other range writes to
+    // during this colour, so the lanes of the span are written back whole. Past its end they could be.
+    glm::ivec2 cell_coords = m_data.GetFiledCellCoordinates(current_position);
+
+    simd::floats force_x = simd::Set(0.f);
+    simd::floats force_y = simd::Set(0.f);
+    m_data.ForEachSpanInCells(cell_coords - reach, cell_coords + reach, [&](u32 span_begin, u32 span_end)
+        {
+            // Batches past the end of the span touch the padded tail of the buffers, those lanes are masked to 0.
+            for( u32 idx = std::max(span_begin, lookup_idx + 1); idx < span_end; idx += simd::width )
+            {
+                simd::mask in_span = simd::FirstLanes(span_end - idx);
+                simd::floats delta_x = simd::Sub(simd::Load(lookup_x + idx), position_x);
+                simd::floats delta_y = simd::Sub(simd::Load(lookup_y + idx), position_y);
+                simd::floats distance_squared = simd::Add(simd::Mul(delta_x, delta_x), simd::Mul(delta_y, delta_y));
+                simd::floats distance = simd::Sqrt(distance_squared);
+
+                simd::mask in_radius = simd::And(in_span, simd::LessEqual(distance_squared, radius_squared));
+                in_radius = simd::And(in_radius, simd::Greater(distance, min_distance));
+
+                simd::floats shared_pressure = simd::Mul(simd::Add(simd::Load(pressures + idx), current_pressure), half);
+                simd::floats slope = Kernel::SlopeSimd(distance, m_kernel);
+                simd::floats scale = simd::Select(in_radius, simd::Div(simd::Mul(shared_pressure, slope), distance));
+                simd::floats pair_x = simd::Mul(delta_x, scale);
+                simd::floats pair_y = simd::Mul(delta_y, scale);
+
+                simd::floats mass_over_density = simd::Load(mass_over_densities + idx);
+                force_x = simd::Add(force_x, simd::Mul(pair_x, mass_over_density));
+                force_y = simd::Add(force_y, simd::Mul(pair_y, mass_over_density));
+
+                simd::floats other_scale = simd::Mul(current_mass_over_density, simd::Load(receive_scales + idx));
+                simd::floats other_x = simd::Sub(simd::MaskedLoad(acceleration_x + idx, in_span), simd::Mul(pair_x, other_scale));
+                simd::floats other_y = simd::Sub(simd::MaskedLoad(acceleration_y + idx, in_span), simd::Mul(pair_y, other_scale));
+                simd::MaskedStore(acceleration_x + idx, in_span, other_x);
+                simd::MaskedStore(acceleration_y + idx, in_span, other_y);
+            }
+        });
+
+    acceleration_x[lookup_idx] += simd::Sum(force_x) * receive_scales[lookup_idx];
+    acceleration_y[lookup_idx] += simd::Sum(force_y) * receive_scales[lookup_idx];
+}
+
+template<typename T>
+T FluidSim2D::DensityAsPressure(T density) const
+{
+    T error = density - T(m_data.GetOptions().target_density);
+    return error * T(m_data.GetOptions().pressure_multiplier);
 }
 
 void FluidSim2D::ApplyExternalForces(u64 node_idx, f64 delta_time, const std::vector<FluidSimExternalForce2D>& external_forces)
@@ -175,7 +1205,20 @@ void FluidSim2D::ApplyExternalForces(u64 node_idx, f64 delta_time, const std::ve
             case FluidSimExternalForceType2D::GravityForce:
             {
                 FluidSimGravityForce gravity = force.asGravityForce;
-                m_data.GetNodeInfos()[node_idx].velocity.y += -gravity.acceleration * f32_cast(delta_time);
+                m_data.GetNodeVelocities()[node_idx].y += -gravity.acceleration * f32_cast(delta_time);
+                break;
+            }
+            case FluidSimExternalForceType2D::PointForce:
+            {
+                // Pushes away from the point (pulls for a negative force), fading out linearly to the radius.
+                FluidSimPointForce2D point = force.asPointForce;
+                glm::f32vec2 offset = glm::f32vec2(m_data.GetNodePositions()[node_idx]) - point.position;
+                f32 distance = glm::length(offset);
+                if( distance >= point.radius || distance <= 0.0005f )
+                    break;
+
+                f32 falloff = 1.f - distance / point.radius;
+                m_data.GetNodeVelocities()[node_idx] += (offset / distance) * point.force * falloff * f32_cast(delta_time);
                 break;
             }
         }
@@ -184,6 +1227,9 @@ void FluidSim2D::ApplyExternalForces(u64 node_idx, f64 delta_time, const std::ve
 
 void FluidSim2D::ApplyExternalDebug(const std::vector<FluidSimExternalDebug2D>& external_debug)
 {
+    // Painting finds nodes through the lookup, which is out of date if nodes were inserted or removed since the last step.
+    m_data.UpdateSpatialLookup();
+
     for( const FluidSimExternalDebug2D& debug : external_debug )
     {
         switch( debug.type )
@@ -194,11 +1240,11 @@ void FluidSim2D::ApplyExternalDebug(const std::vector<FluidSimExternalDebug2D>&
                 // Special case for wanting to only select nodes we're hovered on.
                 if( paint.radius == 0.f )
                 {
-                    m_data.ForEachNodeInCell(paint.position, [&](FluidNodeInfo2D& info, const glm::f32vec2& position, u32 node_index)
+                    m_data.ForEachNodeInCell(paint.position, [&](const glm::f32vec2& position, u32 node_index)
                         {
-                            if( glm::distance(paint.position, position) <= info.node_radius )
+                            if( glm::distance(paint.position, position) <= m_data.GetNodeRadii()[node_index] )
                             {
-                                info.color = paint.color;
+                                m_data.GetNodeColors()[node_index] = paint.color;
                             }
                         });
                     break;
@@ -214,11 +1260,11 @@ void FluidSim2D::ApplyExternalDebug(const std::vector<FluidSimExternalDebug2D>&
                     for( i32 x = sample_coords.x - search_extent_x; x <= sample_coords.x + search_extent_x; x++ )
                     {
                         glm::ivec2 coords{ x, y };
-                        m_data.ForEachNodeInCell(coords, [&](FluidNodeInfo2D& info, const glm::f32vec2& position, u32 node_index)
+                        m_data.ForEachNodeInCell(coords, [&](const glm::f32vec2& position, u32 node_index)
                             {
                                 if( glm::distance(paint.position, position) <= paint.radius )
                                 {
-                                    info.color = paint.color;
+                                    m_data.GetNodeColors()[node_index] = paint.color;
                                 }
                             });
                     }
@@ -230,7 +1276,7 @@ void FluidSim2D::ApplyExternalDebug(const std::vector<FluidSimExternalDebug2D>&
                 FluidSimSetColor set_color = debug.asSetColor;
                 for( u32 node_idx = 0; node_idx < m_data.GetNodeCount(); node_idx++ )
                 {
-                    m_data.GetNodeInfos()[node_idx].color = set_color.color;
+                    m_data.GetNodeColors()[node_idx] = set_color.color;
                 }
                 break;
             }
@@ -239,9 +1285,9 @@ void FluidSim2D::ApplyExternalDebug(const std::vector<FluidSimExternalDebug2D>&
                 FluidSimSetDensityColor density_color = debug.asDensityColor;
                 for( u32 node_idx = 0; node_idx < m_data.GetNodeCount(); node_idx++ )
                 {
-                    f32 raw_interp = (m_data.GetNodeInfos()[node_idx].density - density_color.min_density) / (density_color.max_density - density_color.min_density);
+                    f32 raw_interp = (m_data.GetNodeDensities()[node_idx] - density_color.min_density) / (density_color.max_density - density_color.min_density);
                     f32 clamped_interp = std::clamp(raw_interp, 0.f, 1.f);
-                    m_data.GetNodeInfos()[node_idx].color = density_color.min_color + ((density_color.max_color - density_color.min_color) * clamped_interp);
+                    m_data.GetNodeColors()[node_idx] = density_color.min_color + ((density_color.max_color - density_color.min_color) * clamped_interp);
                 }
                 break;
             }
@@ -250,13 +1296,18 @@ void FluidSim2D::ApplyExternalDebug(const std::vector<FluidSimExternalDebug2D>&
                 FluidSimSetVelocityColor velocity_color = debug.asVelocityColor;
                 for( u32 node_idx = 0; node_idx < m_data.GetNodeCount(); node_idx++ )
                 {
-                    f32 velocity = glm::length(m_data.GetNodeInfos()[node_idx].velocity);
+                    f32 velocity = glm::length(m_data.GetNodeVelocities()[node_idx]);
                     f32 raw_interp = (velocity - velocity_color.min_velocity) / (velocity_color.max_velocity - velocity_color.min_velocity);
                     f32 clamped_interp = std::clamp(raw_interp, 0.f, 1.f);
-                    m_data.GetNodeInfos()[node_idx].color = velocity_color.min_color + ((velocity_color.max_color - velocity_color.min_color) * clamped_interp);
+                    m_data.GetNodeColors()[node_idx] = velocity_color.min_color + ((velocity_color.max_color - velocity_color.min_color) * clamped_interp);
                 }
                 break;
             }
         }
     }
+}
+
+f64 FluidSim2D::GetSecondsBetween(sys::moment start, sys::moment end)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e9;
 }
\ No newline at end of file
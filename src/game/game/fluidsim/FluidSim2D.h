@@ -1,6 +1,10 @@
 #pragma once
 #include "glm.hpp"
+#include "system/timer.h"
 #include "FluidSimData2D.h"
+#include "FluidSimGrid2D.h"
+
+#include <mutex>
 
 struct FluidSimGravityForce
 {
@@ -78,6 +82,56 @@ struct FluidSimExternalDebug2D
     };
 };
 
+struct FluidSimStats2D
+{
+    // Wall clock times of the last Simulate call summed over its substeps, in seconds. The grid solver has no
+    // neighbour search, its transfer to the grid counts as the density pass and its projection and transfer back
+    // as the pressure pass.
+    f64 step_time;
+    f64 neighbour_search_time;
+    f64 density_pass_time;
+    f64 pressure_pass_time;
+
+    // Substeps the last Simulate call was split into, always 1 without adaptive_time_step.
+    u32 substep_count;
+    // Length of the last substep, and the fastest node speed and acceleration it measured.
+    f64 time_step;
+    f32 max_speed;
+    f32 max_acceleration;
+
+    // Neighbour pairs within the smoothing radius visited by the density pass of the last substep.
+    // The pressure pass visits the same pairs.
+    u64 neighbour_count;
+
+    // Nodes walked by the density pass lookups, and how many of those were hash collisions.
+    // The SIMD kernels walk whole spans without classifying nodes, so only count candidates.
+    u64 candidate_count;
+    u64 collision_count;
+
+    // Whether the neighbour lists were rebuilt this step or reused from a previous one.
+    bool neighbour_lists_rebuilt;
+
+    // Nodes simulated by the last substep, all of them unless sleeping is enabled.
+    u32 awake_node_count;
+
+    // Conjugate gradient iterations of the grid solver's last pressure solve, and the divergence it left relative
+    // to the divergence before the solve. Zero for the other solvers.
+    u32 pressure_iterations;
+    f32 pressure_residual;
+};
+
+// Copy of the node state a renderer needs, so it can be read while the simulation carries on stepping.
+struct FluidSimFrame2D
+{
+    std::vector<glm::f32vec4> positions;
+    std::vector<FluidNodeInfo2D> node_infos;
+    FluidSimStats2D stats{ };
+    // Incremented by every publish, 0 until the first one.
+    u64 sequence{ 0 };
+};
+
+class FluidSimInputLog2D;
+
 class FluidSim2D
 {
 public:
@@ -90,27 +144,169 @@ public:
 
     void ApplyDebug(const std::vector<FluidSimExternalDebug2D>& external_debug);
 
-    void InsertNode(FluidNodeInfo2D node, glm::f32vec2 position);
+    FluidNodeHandle2D InsertNode(FluidNodeInfo2D node, glm::f32vec2 position);
     void FinishInserting();
+    // Bulk insertion and O(1) removal for emitters and drains, see FluidSimData2D.
+    void InsertNodes(std::span<const FluidNodeInfo2D> nodes, std::span<const glm::f32vec2> positions, std::span<FluidNodeHandle2D> handles = { });
+    u32 RemoveNodes(std::span<const FluidNodeHandle2D> handles);
+    void ReserveNodes(u32 node_count);
 
-    const std::vector<FluidNodeInfo2D>& GetNodeInfos() const;
+    void WriteNodeInfos(FluidNodeInfo2D* destination) const;
     const std::vector<glm::f32vec4>& GetNodePositions() const;
+    const std::vector<glm::f32vec2>& GetNodeVelocities() const;
+
+    // Nodes are periodically reordered in memory, use ids to follow a node between steps.
+    const std::vector<u32>& GetNodeIds() const;
+    u32 GetNodeIndex(u32 node_id) const;
+    u32 GetNodeIdCapacity() const;
+    FluidNodeHandle2D GetNodeHandle(u32 node_index) const;
+    bool IsNodeAlive(FluidNodeHandle2D handle) const;
 
     u32 GetNodeCount() const;
+    const FluidSimOptions2D& GetOptions() const;
+    const FluidSimStats2D& GetStats() const;
+
+    // Hands frames from the thread stepping the simulation to one reader on another thread. Triple buffered so
+    // neither side ever waits: BeginPublish fills the back frame from the current state, its positions may then be
+    // replaced (e.g. with interpolated ones) before EndPublish makes it the latest frame.
+    FluidSimFrame2D& BeginPublish();
+    void EndPublish();
+    void Publish();
+    // Latest published frame. It isn't touched by the publisher until the next Acquire, so it can be read while
+    // the simulation steps on another thread.
+    const FluidSimFrame2D& Acquire();
+
+    // While set, every Simulate and ApplyDebug call is appended to the log so the run can be replayed.
+    void SetInputLog(FluidSimInputLog2D* input_log);
+    // Static obstacles every solver collides nodes with, see FluidSimData2D::SetObstacles.
+    void SetObstacles(const FluidSimObstacles2D* obstacles);
+
+    // Versioned binary image of the nodes and options, see FluidSimSnapshot2D.h.
+    std::vector<u8> SaveSnapshot() const;
+    // Replaces every node with those of the snapshot. Only the domain (extent, grid extent and grid mode) has to match
+    // the options it was saved with, the rest are this simulation's own so a scene can be stepped with different settings.
+    // Returns false, logging why, when the snapshot can't be loaded.
+    bool LoadSnapshot(std::span<const u8> snapshot);
+
+    // Hash of every node's position and velocity, in node id order so reordering doesn't change it.
+    u64 CalculateChecksum() const;
 
     void Clear();
 private:
-    f32 SmoothingFunction(f32 radius, f32 dst) const;
-    f32 SmoothingFunctionDerivitive(f32 radius, f32 dst) const;
+    void SimulateStep(f64 delta_time, const std::vector<FluidSimExternalForce2D>& external_forces);
+    // Step of the FLIP solver, see FluidSimSolver2D::Flip.
+    void SimulateGridStep(f64 delta_time, const std::vector<FluidSimExternalForce2D>& external_forces);
+
+    // Longest substep that keeps every node within the CFL distance, given the last measured speed and acceleration.
+    f64 GetStableTimeStep() const;
+    // Parallel max reduction over the nodes of |velocity| and |velocity - m_stepStartVelocities| / delta_time,
+    // run after the forces are applied and before the nodes are moved.
+    void MeasureMotion(f64 delta_time);
 
-    void CalculateDensity(u64 node_idx);
+    // Picks the instantiation of the passes for the kernel and precision of the options, and the kernel's constants.
+    void SelectKernel(const FluidSimOptions2D& options);
+    template<typename Kernel>
+    void SelectKernel(FluidSimPrecision2D precision);
+
+    // The density and pressure passes of a step, one instantiation per kernel and precision.
+    template<typename Kernel, typename Precision>
+    void DensityPass(f64 delta_time, const std::vector<FluidSimExternalForce2D>& external_forces);
+    template<typename Kernel, typename Precision>
+    void PressurePass(f64 delta_time);
+
+    // Position based solver, see FluidSimSolver2D. Replaces both passes: each iteration computes every node's
+    // constraint multiplier from its density, then the correction to its predicted position from its neighbours'.
+    // Corrections are applied together once all are known (Jacobi style), so ranges can run in parallel.
+    template<typename Kernel, typename Precision>
+    void ConstraintPass(f64 delta_time);
+    template<typename Kernel, typename Precision>
+    u32 CalculateConstraintMultiplier(u64 node_idx, FluidSimLookupCounters2D& lookup_counters);
+    template<typename Kernel, typename Precision>
+    glm::f32vec2 CalculateConstraintCorrection(u64 node_idx, f32 tensile_reference) const;
+    template<typename Kernel>
+    u32 CalculateConstraintMultiplierSimd(u64 node_idx, FluidSimLookupCounters2D& lookup_counters);
+    template<typename Kernel>
+    glm::f32vec2 CalculateConstraintCorrectionSimd(u64 node_idx, f32 tensile_reference) const;
+
+    template<typename Kernel, typename Precision>
+    u32 CalculateDensity(u64 node_idx, FluidSimLookupCounters2D& lookup_counters);
+    template<typename Kernel, typename Precision>
     void ApplyPressureForce(u64 node_idx, f64 delta_time);
 
-    f32 DensityAsPressure(f32 density) const;
+    // Feeds batch(other_x, other_y, node_indices, valid_lanes) FluidSimSimd::width candidates at a time,
+    // either from the node's neighbour list or from the cell lookup spans around it.
+    template<typename Batch>
+    FluidSimLookupCounters2D ForEachSimdBatch(u64 node_idx, Batch&& batch) const;
+
+    // Same maths as above, FluidSimSimd::width neighbours at a time. Always f32.
+    template<typename Kernel>
+    u32 CalculateDensitySimd(u64 node_idx, FluidSimLookupCounters2D& lookup_counters);
+    template<typename Kernel>
+    void ApplyPressureForceSimd(u64 node_idx, f64 delta_time);
+
+    // Pressure pass that evaluates each neighbour pair once, see FluidSimOptions2D::symmetric_pressure.
+    // Works in cell lookup order: the node at lookup_idx only pairs with nodes later in the lookup and at most
+    // reach cells away, adding its share to its own acceleration and the equal and opposite share to the other node's.
+    template<typename Kernel, typename Precision>
+    void ApplyPressureForcesSymmetric(f64 delta_time);
+    template<typename Kernel, typename Precision>
+    void AccumulatePairForces(u32 lookup_idx, glm::ivec2 reach, f32* acceleration_x, f32* acceleration_y) const;
+    template<typename Kernel>
+    void AccumulatePairForcesSimd(u32 lookup_idx, glm::ivec2 reach, f32* acceleration_x, f32* acceleration_y) const;
+
+    template<typename T>
+    T DensityAsPressure(T density) const;
 
-    void ForEachNodeInRadius(glm::f32vec2 sample_point, f32 radius, FluidSimData2D::ForEachNodeFunc function);
     void ApplyExternalForces(u64 node_idx, f64 delta_time, const std::vector<FluidSimExternalForce2D>& external_forces);
     void ApplyExternalDebug(const std::vector<FluidSimExternalDebug2D>& external_debug);
+
+    static f64 GetSecondsBetween(sys::moment start, sys::moment end);
 private:
+    // Artificial pressure of the position based solver, -tensile_strength * (W(d) / W(tensile_distance * radius))^4
+    // added to the multipliers of every pair. Keeps nodes with few neighbours at the surface from clumping.
+    static constexpr f32 tensile_strength = 0.1f;
+    static constexpr f32 tensile_distance = 0.2f;
+    // Smaller ratios are dropped, their 4th power is negligible and would be denormal which is very slow to compute with.
+    static constexpr f32 min_tensile_ratio = 1e-6f;
+
     FluidSimData2D m_data;
+    // Only created for the FLIP solver.
+    std::unique_ptr<FluidSimGrid2D> m_grid;
+    FluidSimKernelConstants2D m_kernel{ };
+    using DensityPassFunc = void (FluidSim2D::*)(f64 delta_time, const std::vector<FluidSimExternalForce2D>& external_forces);
+    using StepPassFunc = void (FluidSim2D::*)(f64 delta_time);
+    DensityPassFunc m_densityPass{ nullptr };
+    StepPassFunc m_pressurePass{ nullptr };
+    StepPassFunc m_constraintPass{ nullptr };
+    FluidSimStats2D m_stats{ };
+    u32 m_stepsSinceReorder{ 0 };
+    FluidSimInputLog2D* m_inputLog{ nullptr };
+
+    // Adaptive time step state, velocities at the start of the substep and per range maxima for the reduction.
+    std::vector<glm::f32vec2> m_stepStartVelocities;
+    std::vector<glm::f32vec2> m_rangeMotion;
+    f32 m_maxSpeed{ 0.f };
+    f32 m_maxAcceleration{ 0.f };
+
+    // Symmetric pressure pass scratch, per node inputs and accelerations in cell lookup order. Each node's cell
+    // colour decides which pass handles it, so pairs can write to both nodes without atomics.
+    std::vector<f32> m_pairPressures;
+    std::vector<f32> m_pairMassOverDensities;
+    std::vector<f32> m_pairReceiveScales;
+    std::vector<u32> m_pairColors;
+    std::vector<f32> m_pairAccelerationsX;
+    std::vector<f32> m_pairAccelerationsY;
+
+    // Position based solver scratch, per node constraint multipliers and position corrections.
+    std::vector<f32> m_constraintMultipliers;
+    std::vector<glm::f32vec2> m_constraintCorrections;
+
+    // Published frames, one being written by the publisher, one waiting to be acquired and one held by the reader.
+    std::array<FluidSimFrame2D, 3> m_frames;
+    u32 m_publishFrame{ 0 };
+    u32 m_readyFrame{ 1 };
+    u32 m_acquiredFrame{ 2 };
+    bool m_frameReady{ false };
+    u64 m_publishSequence{ 0 };
+    std::mutex m_frameMutex;
 };
\ No newline at end of file
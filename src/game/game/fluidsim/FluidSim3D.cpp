@@ -0,0 +1,321 @@
+#include "FluidSim3D.h"
+#include "system/hash.h"
+
+#include <atomic>
+
+FluidSim3D::FluidSim3D(FluidSimOptions3D options) :
+    m_data(options),
+    m_kernel(GetKernelConstants(options))
+{ }
+
+void FluidSim3D::Simulate(
+    f64 delta_time,
+    const std::vector<FluidSimExternalForce3D>& external_forces)
+{
+    sys::moment step_start = sys::now();
+    const FluidSimOptions3D& options = m_data.GetOptions();
+    if( options.reorder_interval && ++m_stepsSinceReorder >= options.reorder_interval )
+    {
+        m_data.ReorderNodes();
+        m_stepsSinceReorder = 0;
+    }
+
+    m_data.FillPredictedPositions();
+
+    sys::moment search_start = sys::now();
+    bool lists_rebuilt = false;
+    if( options.neighbour_lists )
+        lists_rebuilt = m_data.UpdateNeighbourLists();
+    else
+        m_data.BuildSpatialLookup();
+
+    // Same passes as FluidSim2D, each only writes to the node it is processing.
+    sys::moment density_start = sys::now();
+    std::atomic<u64> neighbour_count{ 0 };
+    std::atomic<u64> candidate_count{ 0 };
+    m_data.ForEachNodeRange([&](u32 range_begin, u32 range_end, u32)
+        {
+            u64 range_neighbours = 0;
+            u64 range_candidates = 0;
+            for( u32 node_idx = range_begin; node_idx < range_end; node_idx++ )
+            {
+                ApplyExternalForces(node_idx, delta_time, external_forces);
+
+                u32 node_candidates = 0;
+                range_neighbours += CalculateDensity(node_idx, node_candidates);
+                range_candidates += node_candidates;
+            }
+
+            neighbour_count += range_neighbours;
+            candidate_count += range_candidates;
+        });
+
+    sys::moment pressure_start = sys::now();
+    m_data.ForEachNodeRange([&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u32 node_idx = range_begin; node_idx < range_end; node_idx++ )
+            {
+                ApplyPressureForce(node_idx, delta_time);
+            }
+        });
+
+    sys::moment pressure_end = sys::now();
+    m_data.MoveNodes(delta_time);
+
+    m_stats.neighbour_search_time = GetSecondsBetween(search_start, density_start);
+    m_stats.density_pass_time = GetSecondsBetween(density_start, pressure_start);
+    m_stats.pressure_pass_time = GetSecondsBetween(pressure_start, pressure_end);
+    m_stats.neighbour_count = neighbour_count.load();
+    m_stats.candidate_count = candidate_count.load();
+    m_stats.neighbour_lists_rebuilt = lists_rebuilt;
+    m_stats.step_time = GetSecondsBetween(step_start, sys::now());
+}
+
+void FluidSim3D::InsertNodes(std::span<const FluidNodeInfo3D> nodes, std::span<const glm::f32vec3> positions)
+{
+    m_data.InsertNodes(nodes, positions);
+}
+
+void FluidSim3D::Clear()
+{
+    m_data.ClearNodes();
+}
+
+const std::vector<glm::f32vec3>& FluidSim3D::GetNodePositions() const
+{
+    return m_data.GetNodePositions();
+}
+
+const std::vector<glm::f32vec3>& FluidSim3D::GetNodeVelocities() const
+{
+    return m_data.GetNodeVelocities();
+}
+
+const std::vector<f32>& FluidSim3D::GetNodeDensities() const
+{
+    return m_data.GetNodeDensities();
+}
+
+const std::vector<u32>& FluidSim3D::GetNodeIds() const
+{
+    return m_data.GetNodeIds();
+}
+
+u32 FluidSim3D::GetNodeIndex(u32 node_id) const
+{
+    return m_data.GetNodeIndex(node_id);
+}
+
+u32 FluidSim3D::GetNodeCount() const
+{
+    return m_data.GetNodeCount();
+}
+
+const FluidSimOptions3D& FluidSim3D::GetOptions() const
+{
+    return m_data.GetOptions();
+}
+
+const FluidSimStats3D& FluidSim3D::GetStats() const
+{
+    return m_stats;
+}
+
+u64 FluidSim3D::CalculateChecksum() const
+{
+    std::vector<glm::f32vec3> state;
+    state.reserve(u64_cast(GetNodeCount()) * 2);
+    for( u32 node_id = 0; node_id < GetNodeCount(); node_id++ )
+    {
+        u32 node_idx = m_data.GetNodeIndex(node_id);
+        state.push_back(m_data.GetNodePositions()[node_idx]);
+        state.push_back(m_data.GetNodeVelocities()[node_idx]);
+    }
+
+    return sys::hash64(state.data(), state.size() * sizeof(glm::f32vec3));
+}
+
+FluidSimKernelConstants3D FluidSim3D::GetKernelConstants(const FluidSimOptions3D& options)
+{
+    f32 radius = options.smoothing_radius;
+    f32 radius_5 = radius * radius * radius * radius * radius;
+    return
+    {
+        .radius = radius,
+        .radius_squared = radius * radius,
+        .density_scale = 15.f / (2.f * glm::pi<f32>() * radius_5),
+        .gradient_scale = 15.f / (glm::pi<f32>() * radius_5),
+    };
+}
+
+template<typename Batch>
+u32 FluidSim3D::ForEachSimdBatch(u32 node_idx, Batch&& batch) const
+{
+    using simd = FluidSimSimd;
+    if( m_data.GetOptions().neighbour_lists )
+    {
+        const u32* neighbours = m_data.GetNeighbours().data();
+        const f32* positions_x = m_data.GetPredictedPositionsX().data();
+        const f32* positions_y = m_data.GetPredictedPositionsY().data();
+        const f32* positions_z = m_data.GetPredictedPositionsZ().data();
+        u32 list_begin = m_data.GetNeighbourOffsets()[node_idx];
+        u32 list_end = m_data.GetNeighbourOffsets()[node_idx + 1];
+        for( u32 idx = list_begin; idx < list_end; idx += simd::width )
+        {
+            simd::indices node_indices = simd::LoadIndices(neighbours + idx);
+            batch(
+                simd::Gather(positions_x, node_indices),
+                simd::Gather(positions_y, node_indices),
+                simd::Gather(positions_z, node_indices),
+                node_indices,
+                simd::FirstLanes(list_end - idx));
+        }
+
+        return list_end - list_begin;
+    }
+
+    const u32* lookup = m_data.GetCellLookup().data();
+    const f32* lookup_x = m_data.GetLookupPositionsX().data();
+    const f32* lookup_y = m_data.GetLookupPositionsY().data();
+    const f32* lookup_z = m_data.GetLookupPositionsZ().data();
+    return m_data.ForEachSpanInRadius(m_data.GetNodePredictedPosition(node_idx), m_kernel.radius, [&](u32 span_begin, u32 span_end)
+        {
+            for( u32 idx = span_begin; idx < span_end; idx += simd::width )
+            {
+                batch(
+                    simd::Load(lookup_x + idx),
+                    simd::Load(lookup_y + idx),
+                    simd::Load(lookup_z + idx),
+                    simd::LoadIndices(lookup + idx),
+                    simd::FirstLanes(span_end - idx));
+            }
+        });
+}
+
+u32 FluidSim3D::CalculateDensity(u32 node_idx, u32& candidate_count)
+{
+    using simd = FluidSimSimd;
+    glm::f32vec3 node_position = m_data.GetNodePredictedPosition(node_idx);
+    simd::floats position_x = simd::Set(node_position.x);
+    simd::floats position_y = simd::Set(node_position.y);
+    simd::floats position_z = simd::Set(node_position.z);
+    simd::floats radius = simd::Set(m_kernel.radius);
+    simd::floats radius_squared = simd::Set(m_kernel.radius_squared);
+
+    simd::floats influence_sum = simd::Set(0.f);
+    u32 neighbour_count = 0;
+    candidate_count = ForEachSimdBatch(node_idx, [&](simd::floats other_x, simd::floats other_y, simd::floats other_z, simd::indices node_indices, simd::mask valid_lanes)
+        {
+            simd::floats delta_x = simd::Sub(other_x, position_x);
+            simd::floats delta_y = simd::Sub(other_y, position_y);
+            simd::floats delta_z = simd::Sub(other_z, position_z);
+            simd::floats distance_squared = simd::Add(simd::Add(simd::Mul(delta_x, delta_x), simd::Mul(delta_y, delta_y)), simd::Mul(delta_z, delta_z));
+
+            simd::mask in_radius = simd::And(valid_lanes, simd::LessEqual(distance_squared, radius_squared));
+            in_radius = simd::AndNot(simd::IndexEquals(node_indices, node_idx), in_radius);
+
+            simd::floats falloff = simd::Sub(radius, simd::Sqrt(distance_squared));
+            influence_sum = simd::Add(influence_sum, simd::Select(in_radius, simd::Mul(falloff, falloff)));
+            neighbour_count += simd::MaskCount(in_radius);
+        });
+
+    f32 current_mass = m_data.GetNodeMasses()[node_idx];
+    m_data.GetNodeDensities()[node_idx] = current_mass * simd::Sum(influence_sum) * m_kernel.density_scale;
+    return neighbour_count;
+}
+
+void FluidSim3D::ApplyPressureForce(u32 node_idx, f64 delta_time)
+{
+    using simd = FluidSimSimd;
+    const f32* densities = m_data.GetNodeDensities().data();
+    const f32* masses = m_data.GetNodeMasses().data();
+    f32 current_density = densities[node_idx];
+    if( current_density <= 0.0005f )
+        return;
+
+    glm::f32vec3 current_position = m_data.GetNodePredictedPosition(node_idx);
+    simd::floats position_x = simd::Set(current_position.x);
+    simd::floats position_y = simd::Set(current_position.y);
+    simd::floats position_z = simd::Set(current_position.z);
+    simd::floats radius = simd::Set(m_kernel.radius);
+    simd::floats radius_squared = simd::Set(m_kernel.radius_squared);
+    simd::floats gradient_scale = simd::Set(m_kernel.gradient_scale);
+    simd::floats min_distance = simd::Set(0.0005f);
+    simd::floats target_density = simd::Set(m_data.GetOptions().target_density);
+    simd::floats pressure_multiplier = simd::Set(m_data.GetOptions().pressure_multiplier);
+    simd::floats current_pressure = simd::Set(DensityAsPressure(current_density));
+    simd::floats half = simd::Set(0.5f);
+
+    simd::floats force_x = simd::Set(0.f);
+    simd::floats force_y = simd::Set(0.f);
+    simd::floats force_z = simd::Set(0.f);
+    ForEachSimdBatch(node_idx, [&](simd::floats other_x, simd::floats other_y, simd::floats other_z, simd::indices node_indices, simd::mask valid_lanes)
+        {
+            simd::floats delta_x = simd::Sub(other_x, position_x);
+            simd::floats delta_y = simd::Sub(other_y, position_y);
+            simd::floats delta_z = simd::Sub(other_z, position_z);
+            simd::floats distance_squared = simd::Add(simd::Add(simd::Mul(delta_x, delta_x), simd::Mul(delta_y, delta_y)), simd::Mul(delta_z, delta_z));
+            simd::floats distance = simd::Sqrt(distance_squared);
+
+            // Too close nodes are skipped as we can't accurately calculate a direction.
+            simd::mask in_radius = simd::And(valid_lanes, simd::LessEqual(distance_squared, radius_squared));
+            in_radius = simd::And(in_radius, simd::Greater(distance, min_distance));
+            in_radius = simd::AndNot(simd::IndexEquals(node_indices, node_idx), in_radius);
+
+            simd::floats density = simd::Gather(densities, node_indices);
+            simd::floats mass = simd::Gather(masses, node_indices);
+            simd::floats pressure = simd::Mul(simd::Sub(density, target_density), pressure_multiplier);
+            simd::floats shared_pressure = simd::Mul(simd::Add(pressure, current_pressure), half);
+            simd::floats slope = simd::Mul(simd::Sub(distance, radius), gradient_scale);
+
+            // Direction is delta / distance, fold the divide into the per neighbour scale.
+            simd::floats scale = simd::Div(
+                simd::Mul(simd::Mul(shared_pressure, slope), mass),
+                simd::Mul(density, distance));
+
+            force_x = simd::Add(force_x, simd::Select(in_radius, simd::Mul(delta_x, scale)));
+            force_y = simd::Add(force_y, simd::Select(in_radius, simd::Mul(delta_y, scale)));
+            force_z = simd::Add(force_z, simd::Select(in_radius, simd::Mul(delta_z, scale)));
+        });
+
+    glm::f32vec3 pressure_force{ simd::Sum(force_x), simd::Sum(force_y), simd::Sum(force_z) };
+    m_data.GetNodeVelocities()[node_idx] += (pressure_force / current_density) * f32_cast(delta_time);
+}
+
+f32 FluidSim3D::DensityAsPressure(f32 density) const
+{
+    f32 error = density - m_data.GetOptions().target_density;
+    return error * m_data.GetOptions().pressure_multiplier;
+}
+
+void FluidSim3D::ApplyExternalForces(u32 node_idx, f64 delta_time, const std::vector<FluidSimExternalForce3D>& external_forces)
+{
+    for( const FluidSimExternalForce3D& force : external_forces )
+    {
+        switch( force.type )
+        {
+            case FluidSimExternalForceType3D::GravityForce:
+            {
+                m_data.GetNodeVelocities()[node_idx].y += -force.asGravityForce.acceleration * f32_cast(delta_time);
+                break;
+            }
+            case FluidSimExternalForceType3D::PointForce:
+            {
+                FluidSimPointForce3D point = force.asPointForce;
+                glm::f32vec3 offset = m_data.GetNodePositions()[node_idx] - point.position;
+                f32 distance = glm::length(offset);
+                if( distance >= point.radius || distance <= 0.0005f )
+                    break;
+
+                f32 falloff = 1.f - distance / point.radius;
+                m_data.GetNodeVelocities()[node_idx] += (offset / distance) * point.force * falloff * f32_cast(delta_time);
+                break;
+            }
+        }
+    }
+}
+
+f64 FluidSim3D::GetSecondsBetween(sys::moment start, sys::moment end)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e9;
+}
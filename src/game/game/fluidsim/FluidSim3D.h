@@ -0,0 +1,102 @@
+#pragma once
+#include "system/timer.h"
+#include "FluidSim2D.h"
+#include "FluidSimData3D.h"
+
+struct FluidSimPointForce3D
+{
+    glm::f32vec3 position;
+    f32 radius;
+    f32 force;
+};
+
+enum class FluidSimExternalForceType3D
+{
+    GravityForce = 0,
+    PointForce,
+};
+
+struct FluidSimExternalForce3D
+{
+    FluidSimExternalForceType3D type;
+    union
+    {
+        FluidSimGravityForce asGravityForce;
+        FluidSimPointForce3D asPointForce;
+    };
+};
+
+struct FluidSimStats3D
+{
+    // Wall clock times of the last Simulate call, in seconds.
+    f64 step_time;
+    f64 neighbour_search_time;
+    f64 density_pass_time;
+    f64 pressure_pass_time;
+
+    // Neighbour pairs within the smoothing radius visited by the density pass, and the nodes its lookups walked.
+    u64 neighbour_count;
+    u64 candidate_count;
+
+    bool neighbour_lists_rebuilt;
+};
+
+// Normalisation constants of the 3D smoothing kernels.
+struct FluidSimKernelConstants3D
+{
+    f32 radius;
+    f32 radius_squared;
+    // 15 / (2 * pi * r^5), the reciprocal of the volume of (r - d)^2 over the sphere
+    f32 density_scale;
+    // 15 / (pi * r^5), the derivative of the density kernel is (d - r) * gradient_scale
+    f32 gradient_scale;
+};
+
+// The FluidSim2D solver in three dimensions. Density and pressure are only computed by the vectorised kernels,
+// FluidSimSimd's scalar fallback is the reference path.
+class FluidSim3D
+{
+public:
+    FluidSim3D(FluidSimOptions3D options);
+    ~FluidSim3D() = default;
+
+    void Simulate(
+        f64 delta_time,
+        const std::vector<FluidSimExternalForce3D>& external_forces = { });
+
+    void InsertNodes(std::span<const FluidNodeInfo3D> nodes, std::span<const glm::f32vec3> positions);
+    void Clear();
+
+    const std::vector<glm::f32vec3>& GetNodePositions() const;
+    const std::vector<glm::f32vec3>& GetNodeVelocities() const;
+    const std::vector<f32>& GetNodeDensities() const;
+    const std::vector<u32>& GetNodeIds() const;
+    u32 GetNodeIndex(u32 node_id) const;
+
+    u32 GetNodeCount() const;
+    const FluidSimOptions3D& GetOptions() const;
+    const FluidSimStats3D& GetStats() const;
+
+    // Hash of every node's position and velocity, in node id order so reordering doesn't change it.
+    u64 CalculateChecksum() const;
+private:
+    static FluidSimKernelConstants3D GetKernelConstants(const FluidSimOptions3D& options);
+
+    // Feeds batch(other_x, other_y, other_z, node_indices, valid_lanes) FluidSimSimd::width candidates at a time,
+    // either from the node's neighbour list or from the cell lookup spans around it. Returns the candidates walked.
+    template<typename Batch>
+    u32 ForEachSimdBatch(u32 node_idx, Batch&& batch) const;
+
+    u32 CalculateDensity(u32 node_idx, u32& candidate_count);
+    void ApplyPressureForce(u32 node_idx, f64 delta_time);
+    f32 DensityAsPressure(f32 density) const;
+
+    void ApplyExternalForces(u32 node_idx, f64 delta_time, const std::vector<FluidSimExternalForce3D>& external_forces);
+
+    static f64 GetSecondsBetween(sys::moment start, sys::moment end);
+private:
+    FluidSimData3D m_data;
+    FluidSimKernelConstants3D m_kernel;
+    FluidSimStats3D m_stats{ };
+    u32 m_stepsSinceReorder{ 0 };
+};
@@ -0,0 +1,122 @@
+#include "FluidSimCore.h"
+#include "threading/JobDispatcher.h"
+
+void FluidSimCore::ForEachRange(u32 count, u32 range_count, const ForEachRangeFunc& function)
+{
+    if( range_count <= 1 )
+    {
+        function(0, count, 0);
+        return;
+    }
+
+    // Range boundaries only depend on the count and range count, so every element
+    // is always processed by exactly the same maths regardless of which worker picks it up.
+    JobDispatch::dispatch_and_wait(range_count, 1, [&](DispatchState state)
+        {
+            u32 range_begin = u32_cast((u64_cast(count) * state.jobIndex) / range_count);
+            u32 range_end = u32_cast((u64_cast(count) * (state.jobIndex + 1)) / range_count);
+            function(range_begin, range_end, state.jobIndex);
+        });
+}
+
+u32 FluidSimCore::GetRangeCount(u32 count, bool multithreaded)
+{
+    if( !multithreaded )
+        return 1;
+
+    u32 max_ranges = u32_cast(JobDispatch::get_worker_count()) * ranges_per_worker;
+    u32 wanted_ranges = (count + min_range_size - 1) / min_range_size;
+    return std::max(1u, std::min(max_ranges, wanted_ranges));
+}
+
+u32 FluidSimCore::GetWorkerRangeCount(u32 count, bool multithreaded)
+{
+    if( !multithreaded )
+        return 1;
+
+    return std::max(1u, std::min(u32_cast(JobDispatch::get_worker_count()), GetRangeCount(count, multithreaded)));
+}
+
+u32 FluidSimCore::GetSortRangeCount(u32 count, bool multithreaded)
+{
+    u32 worker_ranges = multithreaded
+        ? u32_cast(JobDispatch::get_worker_count())
+        : 1;
+
+    return count >= min_parallel_sort_size ? std::max(worker_ranges, 1u) : 1;
+}
+
+void FluidSimCore::SortByCell(std::span<const u32> cell_ids, u32 cell_count, u32 range_count,
+    std::span<u32> cell_offsets, std::span<u32> lookup, std::vector<u32>& range_cell_counts)
+{
+    u32 count = u32_cast(cell_ids.size());
+    if( range_count <= 1 )
+    {
+        // Count into the slot after each cell so the prefix sum leaves start offsets in place.
+        for( u32 idx = 0; idx < count; idx++ )
+        {
+            cell_offsets[cell_ids[idx] + 1]++;
+        }
+
+        for( u32 cell_id = 0; cell_id <= cell_count; cell_id++ )
+        {
+            cell_offsets[cell_id + 1] += cell_offsets[cell_id];
+        }
+
+        // Borrow the histogram storage as write cursors, scattering in node order keeps the sort stable.
+        range_cell_counts.assign(cell_offsets.begin(), cell_offsets.end() - 1);
+        for( u32 idx = 0; idx < count; idx++ )
+        {
+            lookup[range_cell_counts[cell_ids[idx]]++] = idx;
+        }
+
+        return;
+    }
+
+    range_cell_counts.assign(u64_cast(range_count) * cell_count, 0);
+
+    // Each range counts its own nodes, then each cell turns its column of counts into
+    // per range offsets. Ranges scatter in node order into their own slice of every cell,
+    // so the result is identical to the serial sort.
+    ForEachRange(count, range_count, [&](u32 range_begin, u32 range_end, u32 range_index)
+        {
+            u32* counts = &range_cell_counts[u64_cast(range_index) * cell_count];
+            for( u32 idx = range_begin; idx < range_end; idx++ )
+            {
+                counts[cell_ids[idx]]++;
+            }
+        });
+
+    ForEachRange(cell_count, range_count, [&](u32 cell_begin, u32 cell_end, u32)
+        {
+            for( u32 cell_id = cell_begin; cell_id < cell_end; cell_id++ )
+            {
+                u32 running = 0;
+                for( u32 range_index = 0; range_index < range_count; range_index++ )
+                {
+                    u32& range_count_in_cell = range_cell_counts[u64_cast(range_index) * cell_count + cell_id];
+                    u32 counted = range_count_in_cell;
+                    range_count_in_cell = running;
+                    running += counted;
+                }
+
+                cell_offsets[cell_id + 1] = running;
+            }
+        });
+
+    for( u32 cell_id = 0; cell_id < cell_count; cell_id++ )
+    {
+        cell_offsets[cell_id + 1] += cell_offsets[cell_id];
+    }
+    cell_offsets[cell_count + 1] = cell_offsets[cell_count];
+
+    ForEachRange(count, range_count, [&](u32 range_begin, u32 range_end, u32 range_index)
+        {
+            u32* cursors = &range_cell_counts[u64_cast(range_index) * cell_count];
+            for( u32 idx = range_begin; idx < range_end; idx++ )
+            {
+                u32 cell_id = cell_ids[idx];
+                lookup[cell_offsets[cell_id] + cursors[cell_id]++] = idx;
+            }
+        });
+}
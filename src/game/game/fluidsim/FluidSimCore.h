@@ -0,0 +1,122 @@
+#pragma once
+#include "FluidSimSimd.h"
+
+#include <functional>
+#include <span>
+
+// The dimension independent parts of the node data, shared by FluidSimData2D and FluidSimData3D so both run
+// the same parallel ranges, counting sort, stream permutation and neighbour list assembly.
+class FluidSimCore
+{
+public:
+    // Splits [0, count) into range_count contiguous ranges and calls the function once per range. With more than
+    // one range they run on the JobDispatch workers, so the function must only write to its own range.
+    using ForEachRangeFunc = std::function<void(u32 range_begin, u32 range_end, u32 range_index)>;
+    static void ForEachRange(u32 count, u32 range_count, const ForEachRangeFunc& function);
+
+    // Ranges to split count nodes into, a few per worker so uneven ranges balance out.
+    static u32 GetRangeCount(u32 count, bool multithreaded);
+    // One range per worker, for passes that keep scratch proportional to the node count per range.
+    static u32 GetWorkerRangeCount(u32 count, bool multithreaded);
+    // Ranges SortByCell should use, 1 when the sort is too small to be worth splitting.
+    static u32 GetSortRangeCount(u32 count, bool multithreaded);
+
+    // Stable counting sort of the indices of cell_ids by cell id, O(nodes + cells). cell_offsets must hold
+    // cell_count + 2 zeros and receives the start of every cell in lookup, plus the always empty cell cell_count.
+    // With more than one range each range builds a histogram of its own so the scatter runs without atomics,
+    // the result is identical to the serial sort. range_cell_counts is scratch.
+    static void SortByCell(std::span<const u32> cell_ids, u32 cell_count, u32 range_count,
+        std::span<u32> cell_offsets, std::span<u32> lookup, std::vector<u32>& range_cell_counts);
+
+    // stream[idx] = stream[order[idx]] for every element of the stream.
+    template<typename T>
+    static void PermuteStream(std::vector<T>& stream, std::span<const u32> order, u32 range_count);
+
+    // Parallel max of displacement_squared(u32 idx) over [0, count), e.g. to test movement against a neighbour skin.
+    template<typename Displacement>
+    static f32 GetMaxDisplacementSquared(u32 count, u32 range_count, Displacement&& displacement_squared,
+        std::vector<f32>& range_displacements);
+
+    // Builds CSR neighbour lists, the neighbours of a node are neighbours[offsets[node], offsets[node + 1]).
+    // search(u32 node_index, std::vector<u32>& list) appends the neighbours of one node. Each range searches into
+    // its own buffer of range_neighbours, then the buffers are copied into place once the offsets are known.
+    // Padded with lookup_padding valid indices like the cell lookup.
+    template<typename Search>
+    static void BuildNeighbourLists(u32 node_count, u32 range_count, Search&& search,
+        std::vector<u32>& offsets, std::vector<u32>& neighbours, std::vector<std::vector<u32>>& range_neighbours);
+
+    static constexpr u32 min_range_size = 512;
+    static constexpr u32 ranges_per_worker = 4;
+    static constexpr u32 min_parallel_sort_size = 8192;
+    static constexpr u32 lookup_padding = FluidSimSimd::width;
+};
+
+template<typename T>
+void FluidSimCore::PermuteStream(std::vector<T>& stream, std::span<const u32> order, u32 range_count)
+{
+    std::vector<T> permuted(stream.size());
+    ForEachRange(u32_cast(stream.size()), range_count, [&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u32 idx = range_begin; idx < range_end; idx++ )
+            {
+                permuted[idx] = stream[order[idx]];
+            }
+        });
+
+    stream.swap(permuted);
+}
+
+template<typename Displacement>
+f32 FluidSimCore::GetMaxDisplacementSquared(u32 count, u32 range_count, Displacement&& displacement_squared,
+    std::vector<f32>& range_displacements)
+{
+    range_displacements.assign(range_count, 0.f);
+    ForEachRange(count, range_count, [&](u32 range_begin, u32 range_end, u32 range_index)
+        {
+            f32 max_displacement = 0.f;
+            for( u32 idx = range_begin; idx < range_end; idx++ )
+            {
+                max_displacement = std::max(max_displacement, displacement_squared(idx));
+            }
+
+            range_displacements[range_index] = max_displacement;
+        });
+
+    return *std::max_element(range_displacements.begin(), range_displacements.end());
+}
+
+template<typename Search>
+void FluidSimCore::BuildNeighbourLists(u32 node_count, u32 range_count, Search&& search,
+    std::vector<u32>& offsets, std::vector<u32>& neighbours, std::vector<std::vector<u32>>& range_neighbours)
+{
+    offsets.resize(node_count + 1);
+    offsets[0] = 0;
+    range_neighbours.resize(range_count);
+
+    ForEachRange(node_count, range_count, [&](u32 range_begin, u32 range_end, u32 range_index)
+        {
+            std::vector<u32>& list = range_neighbours[range_index];
+            list.clear();
+
+            for( u32 node_idx = range_begin; node_idx < range_end; node_idx++ )
+            {
+                u32 list_begin = u32_cast(list.size());
+                search(node_idx, list);
+                offsets[node_idx + 1] = u32_cast(list.size()) - list_begin;
+            }
+        });
+
+    for( u32 node_idx = 0; node_idx < node_count; node_idx++ )
+    {
+        offsets[node_idx + 1] += offsets[node_idx];
+    }
+
+    neighbours.resize(offsets.back() + lookup_padding);
+    std::fill(neighbours.end() - lookup_padding, neighbours.end(), 0);
+
+    ForEachRange(node_count, range_count, [&](u32 range_begin, u32, u32 range_index)
+        {
+            const std::vector<u32>& list = range_neighbours[range_index];
+            std::copy(list.begin(), list.end(), neighbours.begin() + offsets[range_begin]);
+        });
+}
@@ -1,6 +1,10 @@
 #include "FluidSimData2D.h"
+#include "FluidSimObstacles2D.h"
+#include "FluidSimSnapshot2D.h"
 #include "sim_channels.h"
 
+#include <atomic>
+
 FluidSimData2D::FluidSimData2D(FluidSimOptions2D options) :
     m_options(options)
 {
@@ -8,81 +12,752 @@ FluidSimData2D::FluidSimData2D(FluidSimOptions2D options) :
     m_rows = i32_cast(std::ceil(options.extent.y / options.grid_extent.y));
 }
 
-void FluidSimData2D::InsertNode(FluidNodeInfo2D node, glm::f32vec2 position)
+FluidNodeHandle2D FluidSimData2D::InsertNode(FluidNodeInfo2D node, glm::f32vec2 position)
 {
     m_positions.push_back({ position.x, position.y, 0.f, 1.f });
     m_predictedPositions.push_back(position);
-    m_nodeInfos.push_back(node);
+    m_velocities.push_back(node.velocity);
+    m_radii.push_back(node.node_radius);
+    m_densities.push_back(node.density);
+    m_masses.push_back(node.mass);
+    m_colors.push_back(node.color);
+
+    u32 node_id = AllocateNodeId();
+    m_nodeIds.push_back(node_id);
+    m_nodeIndices[node_id] = GetNodeCount() - 1;
+    OnNodesChanged();
+    return { node_id, m_nodeGenerations[node_id] };
 }
 
-void FluidSimData2D::MoveNodes(f64 delta_time)
+void FluidSimData2D::InsertNodes(std::span<const FluidNodeInfo2D> nodes, std::span<const glm::f32vec2> positions, std::span<FluidNodeHandle2D> handles)
+{
+    FLUIDSIM_ASSERT(nodes.size() == positions.size(), "Every inserted node needs a position.");
+    FLUIDSIM_ASSERT(handles.empty() || handles.size() == nodes.size(), "Handles must be empty or one per inserted node.");
+
+    ReserveNodes(GetNodeCount() + u32_cast(nodes.size()));
+    for( u64 idx = 0; idx < nodes.size(); idx++ )
+    {
+        FluidNodeHandle2D handle = InsertNode(nodes[idx], positions[idx]);
+        if( !handles.empty() )
+            handles[idx] = handle;
+    }
+}
+
+u32 FluidSimData2D::RemoveNodes(std::span<const FluidNodeHandle2D> handles)
+{
+    u32 removed_count = 0;
+    for( const FluidNodeHandle2D& handle : handles )
+    {
+        if( !IsNodeAlive(handle) )
+            continue;
+
+        // Swap the last node into the hole so every stream stays dense.
+        u32 node_idx = m_nodeIndices[handle.id];
+        u32 last_idx = GetNodeCount() - 1;
+        if( node_idx != last_idx )
+        {
+            m_positions[node_idx] = m_positions[last_idx];
+            m_predictedPositions[node_idx] = m_predictedPositions[last_idx];
+            m_velocities[node_idx] = m_velocities[last_idx];
+            m_radii[node_idx] = m_radii[last_idx];
+            m_densities[node_idx] = m_densities[last_idx];
+            m_masses[node_idx] = m_masses[last_idx];
+            m_colors[node_idx] = m_colors[last_idx];
+            m_nodeIds[node_idx] = m_nodeIds[last_idx];
+            m_nodeIndices[m_nodeIds[node_idx]] = node_idx;
+        }
+
+        m_positions.pop_back();
+        m_predictedPositions.pop_back();
+        m_velocities.pop_back();
+        m_radii.pop_back();
+        m_densities.pop_back();
+        m_masses.pop_back();
+        m_colors.pop_back();
+        m_nodeIds.pop_back();
+
+        m_nodeIndices[handle.id] = invalid_node_index;
+        m_nodeGenerations[handle.id]++;
+        m_freeNodeIds.push_back(handle.id);
+        removed_count++;
+    }
+
+    if( removed_count )
+        OnNodesChanged();
+
+    return removed_count;
+}
+
+void FluidSimData2D::ReserveNodes(u32 node_count)
+{
+    if( node_count <= m_positions.capacity() )
+        return;
+
+    // Grow geometrically so emitters inserting a few nodes every step don't reallocate every step.
+    u64 capacity = std::max<u64>(node_count, m_positions.capacity() * 2);
+    m_positions.reserve(capacity);
+    m_predictedPositions.reserve(capacity);
+    m_velocities.reserve(capacity);
+    m_radii.reserve(capacity);
+    m_densities.reserve(capacity);
+    m_masses.reserve(capacity);
+    m_colors.reserve(capacity);
+    m_nodeIds.reserve(capacity);
+    m_nodeIndices.reserve(capacity);
+    m_nodeGenerations.reserve(capacity);
+}
+
+u32 FluidSimData2D::AllocateNodeId()
 {
-    for( u64 node_idx = 0; node_idx < m_positions.size(); node_idx++ )
+    if( !m_freeNodeIds.empty() )
     {
-        m_positions[node_idx] += glm::f32vec4(m_nodeInfos[node_idx].velocity * f32_cast(delta_time), 0.f, 0.f);
-        HandleEdge(node_idx);
+        u32 node_id = m_freeNodeIds.back();
+        m_freeNodeIds.pop_back();
+        return node_id;
     }
 
+    m_nodeIndices.push_back(invalid_node_index);
+    m_nodeGenerations.push_back(0);
+    return u32_cast(m_nodeIndices.size() - 1);
+}
+
+void FluidSimData2D::OnNodesChanged()
+{
+    m_neighbourListsValid = false;
+    m_nodeSleepStates.clear();
+    m_lookupDirty = true;
+}
+
+void FluidSimData2D::MoveNodes(f64 delta_time)
+{
+    ForEachNodeRange([&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u64 node_idx = range_begin; node_idx < range_end; node_idx++ )
+            {
+                if( !IsNodeAwake(u32_cast(node_idx)) )
+                    continue;
+
+                m_positions[node_idx] += glm::f32vec4(m_velocities[node_idx] * f32_cast(delta_time), 0.f, 0.f);
+                HandleEdge(node_idx);
+            }
+        });
+
     // This is soely for our debug features. We shouldn't ever need to build our spatial lookup
     // from anything except the predicted positions.
     BuildSpatialLookup(false);
 }
 
+void FluidSimData2D::MoveNodesToPredicted(f64 delta_time)
+{
+    f32 inverse_time = f32_cast(1.0 / delta_time);
+    ForEachNodeRange([&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u64 node_idx = range_begin; node_idx < range_end; node_idx++ )
+            {
+                if( !IsNodeAwake(u32_cast(node_idx)) )
+                    continue;
+
+                glm::f32vec2 position = m_positions[node_idx];
+                m_velocities[node_idx] = (m_predictedPositions[node_idx] - position) * inverse_time;
+                m_positions[node_idx].x = m_predictedPositions[node_idx].x;
+                m_positions[node_idx].y = m_predictedPositions[node_idx].y;
+                HandleEdge(node_idx);
+            }
+        });
+
+    BuildSpatialLookup(false);
+}
+
+void FluidSimData2D::HandlePredictedEdge(u32 node_index)
+{
+    glm::f32vec2& position = m_predictedPositions[node_index];
+    if( m_options.should_bounce && m_options.extent.x > 0.f && m_options.extent.y > 0.f )
+    {
+        for( u32 axis = 0; axis < 2; axis++ )
+        {
+            if( position[axis] < 0.f )
+                position[axis] = std::min(-position[axis] * m_options.dampening_factor, m_options.extent[axis]);
+            else if( position[axis] > m_options.extent[axis] )
+                position[axis] = std::max(m_options.extent[axis] - (position[axis] - m_options.extent[axis]) * m_options.dampening_factor, 0.f);
+        }
+    }
+
+    if( m_obstacles )
+    {
+        glm::f32vec2 gradient;
+        f32 distance = m_obstacles->Sample(position, &gradient);
+        f32 gradient_length = glm::length(gradient);
+        if( distance < 0.f && gradient_length > 0.f )
+            position -= gradient * (distance / gradient_length);
+    }
+}
+
+void FluidSimData2D::SetObstacles(const FluidSimObstacles2D* obstacles)
+{
+    FLUIDSIM_ASSERT(!obstacles || obstacles->IsBuilt(), "Obstacles have to be built before they are set.");
+    m_obstacles = obstacles;
+}
+
 void FluidSimData2D::ClearNodes()
 {
     m_positions.clear();
     m_predictedPositions.clear();
-    m_nodeInfos.clear();
+    m_velocities.clear();
+    m_radii.clear();
+    m_densities.clear();
+    m_masses.clear();
+    m_colors.clear();
+    m_nodeIds.clear();
+    m_nodeIndices.clear();
+    m_nodeGenerations.clear();
+    m_freeNodeIds.clear();
+    m_neighbourListsValid = false;
+    m_nodeSleepStates.clear();
+    m_cellQuietSteps.clear();
+    m_tiles.Clear();
+    m_lookupDirty = true;
 }
 
-void FluidSimData2D::ForEachNodeInCell(glm::ivec2 cell_coords, ForEachNodeFunc function)
+void FluidSimData2D::WriteSnapshot(const FluidSimSnapshotHeader2D& state, std::vector<u8>& snapshot) const
 {
-    if( cell_coords.x >= m_columns || cell_coords.y >= m_rows )
-        return;
+    std::vector<glm::ivec2> tile_coordinates(m_tiles.GetTileCount());
+    for( u32 tile_index = 0; tile_index < m_tiles.GetTileCount(); tile_index++ )
+    {
+        tile_coordinates[tile_index] = m_tiles.GetTileCoordinates(tile_index);
+    }
 
-    u32 cell_id = GetCellId(cell_coords);
-    u32 idx = m_startIndices[cell_id];
-    while( idx < GetNodeCount() && m_cellLookup[idx].cell_id == cell_id )
+    struct Stream
     {
-        u32 node_index = m_cellLookup[idx].node_index;
-        function(
-            m_nodeInfos[node_index],
-            m_positions[node_index],
-            node_index
-        );
+        const void* data;
+        u64 element_size;
+        u64 element_count;
+    };
+    auto as_stream = [](const auto& stream) -> Stream
+        {
+            return { stream.data(), sizeof(stream[0]), stream.size() };
+        };
+
+    // In FluidSimSnapshotStream2D order.
+    Stream streams[u32_cast(FluidSimSnapshotStream2D::Count)] =
+    {
+        as_stream(m_positions),
+        as_stream(m_predictedPositions),
+        as_stream(m_velocities),
+        as_stream(m_radii),
+        as_stream(m_densities),
+        as_stream(m_masses),
+        as_stream(m_colors),
+        as_stream(m_nodeIds),
+        as_stream(m_nodeGenerations),
+        as_stream(m_freeNodeIds),
+        as_stream(m_nodeSleepStates),
+        as_stream(m_cellQuietSteps),
+        as_stream(tile_coordinates),
+    };
+
+    auto align = [](u64 offset)
+        {
+            return (offset + FluidSimSnapshotHeader2D::stream_alignment - 1) & ~(FluidSimSnapshotHeader2D::stream_alignment - 1);
+        };
+
+    // Struct copies can carry the padding along, so everything is assigned member by member over zeroed bytes.
+    FluidSimSnapshotHeader2D header;
+    memset(&header, 0, sizeof(FluidSimSnapshotHeader2D));
+    header.magic = FluidSimSnapshotHeader2D::magic_value;
+    header.version = FluidSimSnapshotHeader2D::current_version;
+    header.header_size = sizeof(FluidSimSnapshotHeader2D);
+    header.stream_count = u32_cast(FluidSimSnapshotStream2D::Count);
+    header.node_count = GetNodeCount();
+    header.node_id_capacity = GetNodeIdCapacity();
+    WriteSnapshotOptions(header.options);
+    header.steps_since_reorder = state.steps_since_reorder;
+    header.max_speed = state.max_speed;
+    header.max_acceleration = state.max_acceleration;
+
+    u64 offset = align(sizeof(FluidSimSnapshotHeader2D));
+    for( u32 idx = 0; idx < header.stream_count; idx++ )
+    {
+        header.streams[idx].offset = offset;
+        header.streams[idx].element_size = u32_cast(streams[idx].element_size);
+        header.streams[idx].element_count = u32_cast(streams[idx].element_count);
+        offset = align(offset + streams[idx].element_size * streams[idx].element_count);
+    }
+    header.total_size = offset;
+
+    snapshot.assign(header.total_size, 0);
+    memcpy(snapshot.data(), &header, sizeof(FluidSimSnapshotHeader2D));
+    for( u32 idx = 0; idx < header.stream_count; idx++ )
+    {
+        if( streams[idx].element_count )
+            memcpy(snapshot.data() + header.streams[idx].offset, streams[idx].data, streams[idx].element_size * streams[idx].element_count);
+    }
+}
+
+void FluidSimData2D::WriteSnapshotOptions(FluidSimOptions2D& options) const
+{
+    options.extent = m_options.extent;
+    options.grid_extent = m_options.grid_extent;
+    options.grid_mode = m_options.grid_mode;
+    options.should_bounce = m_options.should_bounce;
+    options.dampening_factor = m_options.dampening_factor;
+    options.smoothing_radius = m_options.smoothing_radius;
+    options.target_density = m_options.target_density;
+    options.pressure_multiplier = m_options.pressure_multiplier;
+    options.kernel = m_options.kernel;
+    options.precision = m_options.precision;
+    options.solver = m_options.solver;
+    options.pbf_iterations = m_options.pbf_iterations;
+    options.pbf_relaxation = m_options.pbf_relaxation;
+    options.flip_ratio = m_options.flip_ratio;
+    options.flip_pressure_iterations = m_options.flip_pressure_iterations;
+    options.flip_pressure_tolerance = m_options.flip_pressure_tolerance;
+    options.multithreaded = m_options.multithreaded;
+    options.simd_kernels = m_options.simd_kernels;
+    options.neighbour_lists = m_options.neighbour_lists;
+    options.neighbour_skin = m_options.neighbour_skin;
+    options.reorder_interval = m_options.reorder_interval;
+    options.symmetric_pressure = m_options.symmetric_pressure;
+    options.adaptive_time_step = m_options.adaptive_time_step;
+    options.cfl_factor = m_options.cfl_factor;
+    options.max_substeps = m_options.max_substeps;
+    options.sleeping = m_options.sleeping;
+    options.sleep_energy = m_options.sleep_energy;
+    options.sleep_steps = m_options.sleep_steps;
+}
+
+bool FluidSimData2D::ReadSnapshot(const FluidSimSnapshotHeader2D& header, std::span<const u8> snapshot)
+{
+    ClearNodes();
+
+    // ReadSnapshotHeader has checked the element size and length of every stream already.
+    auto read_stream = [&](auto& stream, FluidSimSnapshotStream2D type)
+        {
+            const FluidSimSnapshotStreamInfo2D& info = header.streams[u32_cast(type)];
+            stream.resize(info.element_count);
+            if( info.element_count )
+                memcpy(stream.data(), snapshot.data() + info.offset, u64_cast(info.element_count) * info.element_size);
+        };
+
+    read_stream(m_positions, FluidSimSnapshotStream2D::Positions);
+    read_stream(m_predictedPositions, FluidSimSnapshotStream2D::PredictedPositions);
+    read_stream(m_velocities, FluidSimSnapshotStream2D::Velocities);
+    read_stream(m_radii, FluidSimSnapshotStream2D::Radii);
+    read_stream(m_densities, FluidSimSnapshotStream2D::Densities);
+    read_stream(m_masses, FluidSimSnapshotStream2D::Masses);
+    read_stream(m_colors, FluidSimSnapshotStream2D::Colors);
+    read_stream(m_nodeIds, FluidSimSnapshotStream2D::NodeIds);
+    read_stream(m_nodeGenerations, FluidSimSnapshotStream2D::NodeGenerations);
+    read_stream(m_freeNodeIds, FluidSimSnapshotStream2D::FreeNodeIds);
+
+    // Tiles are allocated again in the saved order, so cells get the ids the quiet steps were saved under.
+    std::vector<glm::ivec2> tile_coordinates;
+    read_stream(tile_coordinates, FluidSimSnapshotStream2D::TileCoordinates);
+    if( m_options.grid_mode == FluidSimGridMode2D::Tiled )
+    {
+        for( glm::ivec2 tile_coords : tile_coordinates )
+        {
+            m_tiles.Insert(tile_coords);
+        }
+    }
+
+    // Ids index the other streams, so every one must be in range and used by exactly one node or be free.
+    bool ids_valid = m_nodeIds.size() + m_freeNodeIds.size() == header.node_id_capacity;
+    m_nodeIndices.assign(header.node_id_capacity, invalid_node_index);
+    for( u32 node_idx = 0; ids_valid && node_idx < GetNodeCount(); node_idx++ )
+    {
+        u32 node_id = m_nodeIds[node_idx];
+        ids_valid = node_id < header.node_id_capacity && m_nodeIndices[node_id] == invalid_node_index;
+        if( ids_valid )
+            m_nodeIndices[node_id] = node_idx;
+    }
+    // Free ids are marked while checking so one listed twice is caught too.
+    static constexpr u32 free_marker = invalid_node_index - 1;
+    for( u32 free_id : m_freeNodeIds )
+    {
+        ids_valid = ids_valid && free_id < header.node_id_capacity && m_nodeIndices[free_id] == invalid_node_index;
+        if( ids_valid )
+            m_nodeIndices[free_id] = free_marker;
+    }
+    for( u32 free_id : m_freeNodeIds )
+    {
+        if( free_id < header.node_id_capacity && m_nodeIndices[free_id] == free_marker )
+            m_nodeIndices[free_id] = invalid_node_index;
+    }
+
+    if( !ids_valid )
+    {
+        ClearNodes();
+        return false;
+    }
+
+    OnNodesChanged();
+
+    // Only adopted when sleeping, states left behind would otherwise keep nodes frozen. Quiet steps that don't
+    // match the rebuilt cells are started over by the next UpdateSleep.
+    if( m_options.sleeping )
+    {
+        read_stream(m_nodeSleepStates, FluidSimSnapshotStream2D::NodeSleepStates);
+        read_stream(m_cellQuietSteps, FluidSimSnapshotStream2D::CellQuietSteps);
+
+        bool states_valid = std::all_of(m_nodeSleepStates.begin(), m_nodeSleepStates.end(), [](FluidSimSleepState2D state)
+            {
+                return state <= FluidSimSleepState2D::DeepSleep;
+            });
+        if( !states_valid )
+        {
+            ClearNodes();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void FluidSimData2D::ReorderNodes()
+{
+    UpdateSpatialLookup();
+
+    // m_cellLookup holds node indices in cell order, which is exactly the gather order we want.
+    u32 range_count = GetRangeCount();
+    FluidSimCore::PermuteStream(m_positions, m_cellLookup, range_count);
+    FluidSimCore::PermuteStream(m_predictedPositions, m_cellLookup, range_count);
+    FluidSimCore::PermuteStream(m_velocities, m_cellLookup, range_count);
+    FluidSimCore::PermuteStream(m_radii, m_cellLookup, range_count);
+    FluidSimCore::PermuteStream(m_densities, m_cellLookup, range_count);
+    FluidSimCore::PermuteStream(m_masses, m_cellLookup, range_count);
+    FluidSimCore::PermuteStream(m_colors, m_cellLookup, range_count);
+    FluidSimCore::PermuteStream(m_nodeIds, m_cellLookup, range_count);
+    FluidSimCore::PermuteStream(m_nodeCellIds, m_cellLookup, range_count);
+    if( !m_nodeSleepStates.empty() )
+        FluidSimCore::PermuteStream(m_nodeSleepStates, m_cellLookup, range_count);
+
+    // The lists hold node indices, which have all just changed.
+    m_neighbourListsValid = false;
+
+    // After the permutation the lookup is simply the identity.
+    ForEachNodeRange([&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u32 node_idx = range_begin; node_idx < range_end; node_idx++ )
+            {
+                m_cellLookup[node_idx] = node_idx;
+                m_nodeIndices[m_nodeIds[node_idx]] = node_idx;
+            }
+        });
+}
+
+bool FluidSimData2D::UpdateNeighbourLists()
+{
+    if( NeighbourListsCoverMovement() )
+        return false;
+
+    BuildSpatialLookup(true);
+    BuildNeighbourLists();
+    return true;
+}
+
+void FluidSimData2D::UpdateSleep()
+{
+    m_nodeSleepStates.resize(GetNodeCount());
+    if( m_cellQuietSteps.size() != m_cellCount )
+        m_cellQuietSteps.assign(m_cellCount, 0);
+
+    // One extra entry for the empty cell outside of every tile, which never wakes anything.
+    m_cellEnergetic.resize(m_cellCount + 1);
+    m_cellAsleep.resize(m_cellCount + 1);
+    m_cellEnergetic[m_cellCount] = 0;
+    m_cellAsleep[m_cellCount] = 1;
+
+    // Cells within this many cells of each other can hold neighbouring nodes.
+    glm::ivec2 reach
+    {
+        i32_cast(std::ceil(m_options.smoothing_radius / m_options.grid_extent.x)),
+        i32_cast(std::ceil(m_options.smoothing_radius / m_options.grid_extent.y))
+    };
+
+    auto for_each_reachable_cell = [&](u32 cell_id, auto&& visitor)
+        {
+            glm::ivec2 cell_coords = GetLookupCellCoordinates(cell_id);
+            for( i32 y = cell_coords.y - reach.y; y <= cell_coords.y + reach.y; y++ )
+            {
+                for( i32 x = cell_coords.x - reach.x; x <= cell_coords.x + reach.x; x++ )
+                {
+                    if( IsCellInGrid({ x, y }) && !visitor(GetCellId({ x, y })) )
+                        return;
+                }
+            }
+        };
+
+    u32 range_count = GetRangeCount();
+    ForEachRange(m_cellCount, range_count, [&](u32 cell_begin, u32 cell_end, u32)
+        {
+            for( u32 cell_id = cell_begin; cell_id < cell_end; cell_id++ )
+            {
+                u32 node_begin = m_cellOffsets[cell_id];
+                u32 node_end = m_cellOffsets[cell_id + 1];
+                if( node_begin == node_end )
+                {
+                    m_cellEnergetic[cell_id] = 0;
+                    continue;
+                }
+
+                f32 energy = 0.f;
+                for( u32 idx = node_begin; idx < node_end; idx++ )
+                {
+                    u32 node_index = m_cellLookup[idx];
+                    energy += 0.5f * m_masses[node_index] * glm::dot(m_velocities[node_index], m_velocities[node_index]);
+                }
+
+                bool energetic = energy > m_options.sleep_energy * (node_end - node_begin);
+                if( !energetic && !m_wakeRegions.empty() )
+                {
+                    glm::f32vec2 cell_min = glm::f32vec2(GetLookupCellCoordinates(cell_id)) * m_options.grid_extent;
+                    for( const glm::f32vec3& region : m_wakeRegions )
+                    {
+                        glm::f32vec2 closest = glm::clamp(glm::f32vec2(region), cell_min, cell_min + m_options.grid_extent);
+                        energetic |= glm::distance(closest, glm::f32vec2(region)) <= region.z;
+                    }
+                }
+
+                m_cellEnergetic[cell_id] = energetic ? 1 : 0;
+            }
+        });
+
+    ForEachRange(m_cellCount, range_count, [&](u32 cell_begin, u32 cell_end, u32)
+        {
+            for( u32 cell_id = cell_begin; cell_id < cell_end; cell_id++ )
+            {
+                // Nothing in an empty cell can keep its neighbours awake.
+                if( m_cellOffsets[cell_id] == m_cellOffsets[cell_id + 1] )
+                {
+                    m_cellAsleep[cell_id] = 1;
+                    continue;
+                }
+
+                bool stirred = false;
+                for_each_reachable_cell(cell_id, [&](u32 other_cell_id)
+                    {
+                        stirred = m_cellEnergetic[other_cell_id] != 0;
+                        return !stirred;
+                    });
+
+                m_cellQuietSteps[cell_id] = stirred ? 0 : std::min(m_cellQuietSteps[cell_id] + 1, m_options.sleep_steps);
+                m_cellAsleep[cell_id] = m_cellQuietSteps[cell_id] >= m_options.sleep_steps ? 1 : 0;
+            }
+        });
+
+    std::atomic<u32> awake_node_count{ 0 };
+    ForEachRange(m_cellCount, range_count, [&](u32 cell_begin, u32 cell_end, u32)
+        {
+            u32 range_awake = 0;
+            for( u32 cell_id = cell_begin; cell_id < cell_end; cell_id++ )
+            {
+                u32 node_begin = m_cellOffsets[cell_id];
+                u32 node_end = m_cellOffsets[cell_id + 1];
+                if( node_begin == node_end )
+                    continue;
+
+                FluidSimSleepState2D state = FluidSimSleepState2D::Awake;
+                if( m_cellAsleep[cell_id] )
+                {
+                    state = FluidSimSleepState2D::DeepSleep;
+                    for_each_reachable_cell(cell_id, [&](u32 other_cell_id)
+                        {
+                            if( !m_cellAsleep[other_cell_id] )
+                                state = FluidSimSleepState2D::Asleep;
+                            return state == FluidSimSleepState2D::DeepSleep;
+                        });
+                }
+                else
+                {
+                    range_awake += node_end - node_begin;
+                }
+
+                for( u32 idx = node_begin; idx < node_end; idx++ )
+                {
+                    m_nodeSleepStates[m_cellLookup[idx]] = state;
+                }
+            }
+
+            awake_node_count += range_awake;
+        });
+
+    m_awakeNodeCount = awake_node_count.load();
+    m_wakeRegions.clear();
+}
+
+void FluidSimData2D::WakeRegion(glm::f32vec2 position, f32 radius)
+{
+    m_wakeRegions.push_back({ position.x, position.y, radius });
+}
+
+const std::vector<FluidSimSleepState2D>& FluidSimData2D::GetNodeSleepStates() const
+{
+    return m_nodeSleepStates;
+}
+
+u32 FluidSimData2D::GetAwakeNodeCount() const
+{
+    return m_nodeSleepStates.empty() ? GetNodeCount() : m_awakeNodeCount;
+}
+
+glm::ivec2 FluidSimData2D::GetLookupCellCoordinates(u32 cell_id) const
+{
+    if( m_options.grid_mode == FluidSimGridMode2D::Dense )
+        return { i32_cast(cell_id) % m_columns, i32_cast(cell_id) / m_columns };
 
-        idx++;
+    if( m_options.grid_mode == FluidSimGridMode2D::Tiled )
+    {
+        u32 local_id = cell_id % cells_per_tile;
+        glm::ivec2 local{ i32_cast(local_id) % tile_size, i32_cast(local_id) / tile_size };
+        return m_tiles.GetTileCoordinates(cell_id / cells_per_tile) * tile_size + local;
     }
+
+    return GetCellCoordinates(m_predictedPositions[m_cellLookup[m_cellOffsets[cell_id]]]);
+}
+
+const std::vector<u32>& FluidSimData2D::GetNeighbourOffsets() const
+{
+    return m_neighbourOffsets;
+}
+
+const std::vector<u32>& FluidSimData2D::GetNeighbours() const
+{
+    return m_neighbours;
+}
+
+bool FluidSimData2D::NeighbourListsCoverMovement() const
+{
+    if( !m_neighbourListsValid || m_options.neighbour_skin <= 0.f )
+        return false;
+
+    // A pair missing from the lists was more than radius + skin apart, so it can't be within
+    // the radius until the two nodes have closed more than the skin between them.
+    f32 half_skin = m_options.neighbour_skin * 0.5f;
+    f32 max_displacement = FluidSimCore::GetMaxDisplacementSquared(GetNodeCount(), GetRangeCount(), [&](u32 node_idx)
+        {
+            glm::f32vec2 moved = m_predictedPositions[node_idx] - m_neighbourListPositions[node_idx];
+            return glm::dot(moved, moved);
+        }, m_rangeDisplacements);
+    return max_displacement <= half_skin * half_skin;
+}
+
+void FluidSimData2D::BuildNeighbourLists()
+{
+    using simd = FluidSimSimd;
+    f32 search_radius = m_options.smoothing_radius + std::max(m_options.neighbour_skin, 0.f);
+    simd::floats search_radius_squared = simd::Set(search_radius * search_radius);
+
+    FluidSimCore::BuildNeighbourLists(GetNodeCount(), GetRangeCount(), [&](u32 node_idx, std::vector<u32>& range_neighbours)
+        {
+            const glm::f32vec2& node_position = m_predictedPositions[node_idx];
+            simd::floats position_x = simd::Set(node_position.x);
+            simd::floats position_y = simd::Set(node_position.y);
+
+            // Test a batch of the span at once then push the indices of the set lanes in order,
+            // which keeps the lists in the same order as ForEachNodeInRadius would visit them.
+            ForEachSpanInRadius(node_position, search_radius, [&](u32 span_begin, u32 span_end)
+                {
+                    for( u32 idx = span_begin; idx < span_end; idx += simd::width )
+                    {
+                        simd::floats delta_x = simd::Sub(simd::Load(&m_lookupPositionsX[idx]), position_x);
+                        simd::floats delta_y = simd::Sub(simd::Load(&m_lookupPositionsY[idx]), position_y);
+                        simd::floats distance_squared = simd::Add(simd::Mul(delta_x, delta_x), simd::Mul(delta_y, delta_y));
+                        simd::mask in_radius = simd::And(simd::FirstLanes(span_end - idx), simd::LessEqual(distance_squared, search_radius_squared));
+
+                        for( u32 lanes = simd::MaskBits(in_radius); lanes; lanes &= lanes - 1 )
+                        {
+                            u32 node_index = m_cellLookup[idx + std::countr_zero(lanes)];
+                            if( node_index != node_idx )
+                                range_neighbours.push_back(node_index);
+                        }
+                    }
+                });
+        }, m_neighbourOffsets, m_neighbours, m_rangeNeighbours);
+
+    m_neighbourListPositions = m_predictedPositions;
+    m_neighbourListsValid = true;
+}
+
+const std::vector<u32>& FluidSimData2D::GetNodeIds() const
+{
+    return m_nodeIds;
+}
+
+u32 FluidSimData2D::GetNodeIndex(u32 node_id) const
+{
+    return m_nodeIndices[node_id];
 }
 
-void FluidSimData2D::ForEachNodeInCell(glm::ivec2 cell_coords, ForEachConstNodeFunc function) const
+u32 FluidSimData2D::GetNodeIdCapacity() const
 {
-    if( cell_coords.x >= m_columns || cell_coords.y >= m_rows )
+    return u32_cast(m_nodeIndices.size());
+}
+
+FluidNodeHandle2D FluidSimData2D::GetNodeHandle(u32 node_index) const
+{
+    u32 node_id = m_nodeIds[node_index];
+    return { node_id, m_nodeGenerations[node_id] };
+}
+
+bool FluidSimData2D::IsNodeAlive(FluidNodeHandle2D handle) const
+{
+    return handle.id < GetNodeIdCapacity()
+        && m_nodeGenerations[handle.id] == handle.generation
+        && m_nodeIndices[handle.id] != invalid_node_index;
+}
+
+void FluidSimData2D::ForEachNodeInCell(glm::ivec2 cell_coords, ForEachNodeFunc function) const
+{
+    if( !m_cellCount || !IsCellInGrid(cell_coords) )
         return;
 
     u32 cell_id = GetCellId(cell_coords);
-    u32 idx = m_startIndices[cell_id];
-    while( idx < GetNodeCount() && m_cellLookup[idx].cell_id == cell_id )
+    for( u32 idx = m_cellOffsets[cell_id]; idx < m_cellOffsets[cell_id + 1]; idx++ )
     {
-        u32 node_index = m_cellLookup[idx].node_index;
+        u32 node_index = m_cellLookup[idx];
         function(
-            m_nodeInfos[node_index],
             m_positions[node_index],
             node_index
         );
-
-        idx++;
     }
 }
 
-void FluidSimData2D::ForEachNodeInCell(glm::f32vec2 sample_point, ForEachNodeFunc function)
+void FluidSimData2D::ForEachNodeInCell(glm::f32vec2 sample_point, ForEachNodeFunc function) const
 {
     ForEachNodeInCell(GetCellCoordinates(sample_point), function);
 }
 
-void FluidSimData2D::ForEachNodeInCell(glm::f32vec2 sample_point, ForEachConstNodeFunc function) const
+void FluidSimData2D::ForEachNodeRange(ForEachRangeFunc function) const
 {
-    ForEachNodeInCell(GetCellCoordinates(sample_point), function);
+    ForEachRange(GetNodeCount(), GetRangeCount(), function);
+}
+
+void FluidSimData2D::ForEachRange(u32 count, u32 range_count, ForEachRangeFunc function) const
+{
+    FluidSimCore::ForEachRange(count, range_count, function);
+}
+
+void FluidSimData2D::ForEachCellRange(ForEachRangeFunc function) const
+{
+    // Each boundary moves back to the start of the cell it falls in.
+    auto cell_start = [&](u32 lookup_idx)
+        {
+            if( lookup_idx >= m_cellLookup.size() )
+                return lookup_idx;
+
+            auto offsets_end = m_cellOffsets.begin() + m_cellCount + 1;
+            return *(std::upper_bound(m_cellOffsets.begin(), offsets_end, lookup_idx) - 1);
+        };
+
+    ForEachRange(u32_cast(m_cellLookup.size()), GetRangeCount(), [&](u32 range_begin, u32 range_end, u32 range_index)
+        {
+            function(cell_start(range_begin), cell_start(range_end), range_index);
+        });
+}
+
+u32 FluidSimData2D::GetRangeCount() const
+{
+    return FluidSimCore::GetRangeCount(GetNodeCount(), m_options.multithreaded);
 }
 
 glm::ivec2 FluidSimData2D::GetCellCoordinates(glm::f32vec2 position) const
@@ -94,14 +769,80 @@ glm::ivec2 FluidSimData2D::GetCellCoordinates(glm::f32vec2 position) const
     };
 }
 
-std::vector<FluidNodeInfo2D>& FluidSimData2D::GetNodeInfos()
+glm::ivec2 FluidSimData2D::GetFiledCellCoordinates(glm::f32vec2 position) const
+{
+    glm::ivec2 cell_coords = GetCellCoordinates(position);
+
+    // Nodes can be predicted slightly outside of the extent, keep them in the edge cells. Tiled mode only clamps
+    // when bounded, fast nodes predicted far outside of the extent would otherwise each allocate a tile of their own.
+    bool bounded = m_options.extent.x > 0.f && m_options.extent.y > 0.f;
+    if( m_options.grid_mode == FluidSimGridMode2D::Dense || (m_options.grid_mode == FluidSimGridMode2D::Tiled && bounded) )
+        cell_coords = ClampToGrid(cell_coords);
+
+    return cell_coords;
+}
+
+std::vector<glm::f32vec2>& FluidSimData2D::GetNodeVelocities()
+{
+    return m_velocities;
+}
+
+const std::vector<glm::f32vec2>& FluidSimData2D::GetNodeVelocities() const
+{
+    return m_velocities;
+}
+
+std::vector<f32>& FluidSimData2D::GetNodeDensities()
+{
+    return m_densities;
+}
+
+const std::vector<f32>& FluidSimData2D::GetNodeDensities() const
+{
+    return m_densities;
+}
+
+std::vector<glm::f32vec3>& FluidSimData2D::GetNodeColors()
+{
+    return m_colors;
+}
+
+const std::vector<glm::f32vec3>& FluidSimData2D::GetNodeColors() const
+{
+    return m_colors;
+}
+
+const std::vector<f32>& FluidSimData2D::GetNodeMasses() const
+{
+    return m_masses;
+}
+
+const std::vector<f32>& FluidSimData2D::GetNodeRadii() const
 {
-    return m_nodeInfos;
+    return m_radii;
+}
+
+FluidNodeInfo2D FluidSimData2D::GetNodeInfo(u32 node_index) const
+{
+    return
+    {
+        .velocity = m_velocities[node_index],
+        .node_radius = m_radii[node_index],
+        .density = m_densities[node_index],
+        .mass = m_masses[node_index],
+        .color = m_colors[node_index],
+    };
 }
 
-const std::vector<FluidNodeInfo2D>& FluidSimData2D::GetNodeInfos() const
+void FluidSimData2D::WriteNodeInfos(FluidNodeInfo2D* destination) const
 {
-    return m_nodeInfos;
+    ForEachNodeRange([&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u32 node_idx = range_begin; node_idx < range_end; node_idx++ )
+            {
+                destination[node_idx] = GetNodeInfo(node_idx);
+            }
+        });
 }
 
 const std::vector<glm::f32vec4>& FluidSimData2D::GetNodePositions() const
@@ -109,11 +850,31 @@ const std::vector<glm::f32vec4>& FluidSimData2D::GetNodePositions() const
     return m_positions;
 }
 
+std::vector<glm::f32vec2>& FluidSimData2D::GetNodePredictedPositions()
+{
+    return m_predictedPositions;
+}
+
 const std::vector<glm::f32vec2>& FluidSimData2D::GetNodePredictedPositions() const
 {
     return m_predictedPositions;
 }
 
+const std::vector<u32>& FluidSimData2D::GetCellLookup() const
+{
+    return m_cellLookup;
+}
+
+const std::vector<f32>& FluidSimData2D::GetLookupPositionsX() const
+{
+    return m_lookupPositionsX;
+}
+
+const std::vector<f32>& FluidSimData2D::GetLookupPositionsY() const
+{
+    return m_lookupPositionsY;
+}
+
 u32 FluidSimData2D::GetNodeCount() const
 {
     return u32_cast(m_positions.size());
@@ -124,69 +885,170 @@ const FluidSimOptions2D& FluidSimData2D::GetOptions() const
     return m_options;
 }
 
-void FluidSimData2D::FillPredictedPositions()
+void FluidSimData2D::FillPredictedPositions(f32 lookahead_time)
 {
-    constexpr f32 const_lookahead_dt = 1.f / 120.f;
-    for( u32 node_idx = 0; node_idx < GetNodeCount(); node_idx++ )
-    {
-        m_predictedPositions[node_idx] = m_positions[node_idx];
-        m_predictedPositions[node_idx] += m_nodeInfos[node_idx].velocity * const_lookahead_dt;
-    }
+    ForEachNodeRange([&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u32 node_idx = range_begin; node_idx < range_end; node_idx++ )
+            {
+                m_predictedPositions[node_idx] = m_positions[node_idx];
+                m_predictedPositions[node_idx] += m_velocities[node_idx] * lookahead_time;
+            }
+        });
 }
 
 void FluidSimData2D::BuildSpatialLookup(bool use_predicted_positions)
 {
-    m_cellLookup.clear();
-    m_startIndices.clear();
-    m_cellLookup.reserve(GetNodeCount());
-    m_startIndices.reserve(GetNodeCount());
+    m_lookupDirty = false;
+    m_cellLookup.resize(GetNodeCount() + lookup_padding);
+    m_nodeCellIds.resize(GetNodeCount());
 
-    // Build m_cellLookup
-    for( u32 node_index = 0; node_index < GetNodeCount(); node_index++ )
+    // Hashed cell ids are spread over one bucket per node, dense ids cover the whole grid
+    // and tiled ids cover the allocated tiles.
+    bool tiled = m_options.grid_mode == FluidSimGridMode2D::Tiled;
+    if( tiled )
     {
-        if( use_predicted_positions )
-        {
-            glm::uvec2 cell_coords = GetCellCoordinates(m_predictedPositions[node_index]);
-            m_cellLookup.push_back({ node_index, GetCellId(cell_coords) });
-        }
-        else
-        {
-            glm::uvec2 cell_coords = GetCellCoordinates(m_positions[node_index]);
-            m_cellLookup.push_back({ node_index, GetCellId(cell_coords) });
-        }
+        FillTiledCellIds(use_predicted_positions);
+        m_cellCount = m_tiles.GetTileCount() * cells_per_tile;
+    }
+    else
+    {
+        m_cellCount = m_options.grid_mode == FluidSimGridMode2D::Dense
+            ? u32_cast(m_rows * m_columns)
+            : GetNodeCount();
+    }
+
+    // The extra entry past the last offset is the always empty cell id m_cellCount.
+    m_cellOffsets.assign(m_cellCount + 2, 0);
+
+    // Padding has to index a real node (or at least not run off the streams), 0 is always safe.
+    std::fill(m_cellLookup.end() - lookup_padding, m_cellLookup.end(), 0);
+
+    if( !GetNodeCount() )
+        return;
+
+    u32 sort_ranges = FluidSimCore::GetSortRangeCount(GetNodeCount(), m_options.multithreaded);
+    if( !tiled )
+    {
+        ForEachRange(GetNodeCount(), sort_ranges, [&](u32 range_begin, u32 range_end, u32)
+            {
+                FillCellIds(use_predicted_positions, range_begin, range_end);
+            });
     }
 
-    // Sort the cell lookup
-    std::sort(m_cellLookup.begin(), m_cellLookup.end(), [](const CellLookup& left, const CellLookup& right)
+    FluidSimCore::SortByCell(m_nodeCellIds, m_cellCount, sort_ranges, m_cellOffsets,
+        std::span<u32>(m_cellLookup.data(), GetNodeCount()), m_rangeCellCounts);
+
+    if( use_predicted_positions && (m_options.simd_kernels || m_options.neighbour_lists || m_options.symmetric_pressure) )
+        FillLookupPositions();
+}
+
+void FluidSimData2D::UpdateSpatialLookup()
+{
+    if( m_lookupDirty )
+        BuildSpatialLookup(false);
+}
+
+void FluidSimData2D::FillLookupPositions()
+{
+    m_lookupPositionsX.resize(GetNodeCount() + lookup_padding);
+    m_lookupPositionsY.resize(GetNodeCount() + lookup_padding);
+
+    ForEachRange(u32_cast(m_cellLookup.size()), GetRangeCount(), [&](u32 range_begin, u32 range_end, u32)
         {
-            return left.cell_id < right.cell_id;
+            for( u32 idx = range_begin; idx < range_end; idx++ )
+            {
+                const glm::f32vec2& position = m_predictedPositions[m_cellLookup[idx]];
+                m_lookupPositionsX[idx] = position.x;
+                m_lookupPositionsY[idx] = position.y;
+            }
         });
+}
+
+void FluidSimData2D::FillTiledCellIds(bool use_predicted_positions)
+{
+    auto insert_tiles = [&]()
+        {
+            u32 occupied_count = 0;
+            m_tileOccupied.assign(m_tiles.GetTileCount(), 0);
+
+            // Nodes are kept in cell order, so long runs of nodes share a tile and only need one lookup.
+            glm::ivec2 last_tile_coords{ 0, 0 };
+            u32 tile_index = FluidSimTileMap2D::invalid_tile;
+            for( u32 node_index = 0; node_index < GetNodeCount(); node_index++ )
+            {
+                glm::ivec2 cell_coords = use_predicted_positions
+                    ? GetFiledCellCoordinates(m_predictedPositions[node_index])
+                    : GetFiledCellCoordinates(m_positions[node_index]);
+
+                glm::ivec2 tile_coords = cell_coords >> tile_size_shift;
+                if( tile_index == FluidSimTileMap2D::invalid_tile || tile_coords != last_tile_coords )
+                {
+                    last_tile_coords = tile_coords;
+                    tile_index = m_tiles.Insert(tile_coords);
+                    if( tile_index >= m_tileOccupied.size() )
+                        m_tileOccupied.resize(tile_index + 1, 0);
+
+                    if( !m_tileOccupied[tile_index] )
+                    {
+                        m_tileOccupied[tile_index] = 1;
+                        occupied_count++;
+                    }
+                }
 
-    m_startIndices.resize(GetNodeCount(), invalid_index);
-    for( u32 idx = 0; idx < GetNodeCount(); idx++ )
+                glm::ivec2 local = cell_coords & (tile_size - 1);
+                m_nodeCellIds[node_index] = tile_index * cells_per_tile + u32_cast(local.y * tile_size + local.x);
+            }
+
+            return occupied_count;
+        };
+
+    u32 occupied_count = insert_tiles();
+
+    // Tiles are never freed one by one, the ids of the remaining tiles would have to move anyway.
+    // Once fewer than half are in use start over with only the occupied ones.
+    if( m_tiles.GetTileCount() > min_compact_tile_count && occupied_count * 2 < m_tiles.GetTileCount() )
     {
-        u32 cell_id = m_cellLookup[idx].cell_id;
-        u32 prev_cell_id = idx == 0
-            ? invalid_index
-            : m_cellLookup[idx - 1].cell_id;
+        m_tiles.Clear();
+        insert_tiles();
+    }
+}
 
-        if( cell_id != prev_cell_id )
-            m_startIndices[cell_id] = idx;
+void FluidSimData2D::FillCellIds(bool use_predicted_positions, u32 range_begin, u32 range_end)
+{
+    for( u32 node_index = range_begin; node_index < range_end; node_index++ )
+    {
+        glm::ivec2 cell_coords = use_predicted_positions
+            ? GetFiledCellCoordinates(m_predictedPositions[node_index])
+            : GetFiledCellCoordinates(m_positions[node_index]);
+        m_nodeCellIds[node_index] = GetCellId(cell_coords);
     }
 }
 
-u32 FluidSimData2D::GetCellId(glm::ivec2 cell_coords) const
+glm::ivec2 FluidSimData2D::ClampToGrid(glm::ivec2 cell_coords) const
 {
-    static constexpr u32 prime0 = 929;
-    static constexpr u32 prime1 = 7127;
-    i32 cell_id = cell_coords.x * prime0 + cell_coords.y * prime1;
-    return cell_id % GetNodeCount();
+    return
+    {
+        std::clamp(cell_coords.x, 0, m_columns - 1),
+        std::clamp(cell_coords.y, 0, m_rows - 1)
+    };
 }
 
 void FluidSimData2D::HandleEdge(u64 node_idx)
+{
+    HandleDomainEdge(node_idx);
+
+    if( m_obstacles )
+        HandleObstacles(node_idx);
+}
+
+void FluidSimData2D::HandleDomainEdge(u64 node_idx)
 {
     glm::f32vec2& position = (glm::f32vec2&)m_positions[node_idx];
 
+    if( m_options.extent.x <= 0.f || m_options.extent.y <= 0.f )
+        return;
+
     if( m_options.should_bounce )
     {
         glm::f32vec2 velocity_mult{ 1.f, 1.f };
@@ -215,7 +1077,7 @@ void FluidSimData2D::HandleEdge(u64 node_idx)
             velocity_mult.y = -m_options.dampening_factor;
         }
 
-        m_nodeInfos[node_idx].velocity *= velocity_mult;
+        m_velocities[node_idx] *= velocity_mult;
     }
     else
     {
@@ -238,4 +1100,23 @@ void FluidSimData2D::HandleEdge(u64 node_idx)
             position.y -= m_options.extent.y;
         }
     }
-}
\ No newline at end of file
+}
+
+void FluidSimData2D::HandleObstacles(u64 node_idx)
+{
+    glm::f32vec2& position = (glm::f32vec2&)m_positions[node_idx];
+
+    glm::f32vec2 gradient;
+    f32 distance = m_obstacles->Sample(position, &gradient);
+    f32 gradient_length = glm::length(gradient);
+    if( distance >= 0.f || gradient_length <= 0.f )
+        return;
+
+    glm::f32vec2 normal = gradient / gradient_length;
+    position -= normal * distance;
+
+    glm::f32vec2& velocity = m_velocities[node_idx];
+    f32 normal_speed = glm::dot(velocity, normal);
+    if( normal_speed < 0.f )
+        velocity -= normal * (normal_speed * (1.f + m_options.dampening_factor));
+}
@@ -1,9 +1,49 @@
 #pragma once
+#include "FluidSimCore.h"
+#include "FluidSimKernels2D.h"
+#include "FluidSimTileMap2D.h"
+
+#include <span>
+
+enum class FluidSimGridMode2D
+{
+    // One cell per grid square of the bounded extent, no collisions.
+    Dense = 0,
+    // Cell coordinates hashed into one bucket per node, for domains without fixed bounds.
+    Hashed,
+    // Fixed size tiles of cells allocated where nodes are and found through a hash of the tile coordinates.
+    // No collisions and memory follows the occupied area, for very large or unbounded domains.
+    Tiled,
+};
+
+enum class FluidSimSolver2D
+{
+    // Explicit SPH, pressure forces from each node's density error. Needs short steps to stay stable.
+    Sph = 0,
+    // Position based fluids: nodes are moved to predicted positions which are then iteratively corrected
+    // to satisfy a density constraint, velocities are derived from the move. Stable over much longer steps.
+    PositionBased,
+    // Hybrid FLIP/PIC on a grid of grid_extent cells, see FluidSimGrid2D. Velocities are transferred to the grid,
+    // made divergence free there and the change transferred back. There is no neighbour search so it scales to
+    // far more nodes. Needs a bounded extent whose edges act as walls, and ignores sleeping.
+    Flip,
+};
+
+// Sleeping nodes are frozen, they keep their last density and don't move but awake neighbours still read them.
+// Deep sleep nodes have nothing awake within the smoothing radius either, so they can be skipped entirely.
+enum class FluidSimSleepState2D : u8
+{
+    Awake = 0,
+    Asleep,
+    DeepSleep,
+};
 
 struct FluidSimOptions2D
 {
+    // A zero extent leaves the domain unbounded, only usable with the Hashed and Tiled grid modes.
     glm::vec2 extent;
     glm::vec2 grid_extent;
+    FluidSimGridMode2D grid_mode;
 
     bool should_bounce;
     f32 dampening_factor;
@@ -11,6 +51,55 @@ struct FluidSimOptions2D
     f32 smoothing_radius;
     f32 target_density;
     f32 pressure_multiplier;
+
+    // Smoothing kernel and the precision it is evaluated in, see FluidSimKernels2D.h.
+    FluidSimKernel2D kernel;
+    FluidSimPrecision2D precision;
+
+    FluidSimSolver2D solver;
+    // Density constraint iterations per step of the position based solver, and the relaxation added to the
+    // constraint gradients so nodes with few neighbours don't receive huge corrections.
+    u32 pbf_iterations;
+    f32 pbf_relaxation;
+    // Share of the FLIP update in the grid solver's velocity transfer back to the nodes, the rest is PIC.
+    // Pure FLIP keeps the most detail but gets noisy, PIC is smooth but viscous.
+    f32 flip_ratio;
+    // Most conjugate gradient iterations of the grid solver's pressure solve, and the divergence it stops at
+    // relative to the divergence before the solve.
+    u32 flip_pressure_iterations;
+    f32 flip_pressure_tolerance;
+
+    bool multithreaded;
+
+    // Use the vectorised density and pressure kernels, the scalar kernels are kept as the reference path.
+    bool simd_kernels;
+
+    // Build a CSR neighbour list once per step and have every pass read it instead of searching the grid.
+    bool neighbour_lists;
+    // Extra radius kept in the neighbour lists so they can be reused over several steps, until any node
+    // has moved more than half the skin. 0 rebuilds the lists every step.
+    f32 neighbour_skin;
+
+    // Steps between permuting the node streams into cell order, 0 to never reorder.
+    u32 reorder_interval;
+
+    // Visit each neighbour pair once in the pressure pass and apply equal and opposite contributions,
+    // instead of evaluating every pair from both sides. Walks the cell lookup, so it is ignored with neighbour_lists,
+    // and in hashed mode, where far apart cells share a bucket and pairs can't be split between ranges by cell.
+    bool symmetric_pressure;
+
+    // Split each Simulate call into substeps short enough that no node travels more than
+    // cfl_factor * smoothing_radius, judged from the fastest speed and acceleration of the previous substep.
+    bool adaptive_time_step;
+    f32 cfl_factor;
+    // Most substeps per Simulate call. Once reached the remaining substeps are stretched to cover the whole delta time.
+    u32 max_substeps;
+
+    // Put cells to sleep once their mean kinetic energy per node has stayed under sleep_energy, along with every
+    // cell within the smoothing radius of them, for sleep_steps steps. Any energetic cell nearby wakes them again.
+    bool sleeping;
+    f32 sleep_energy;
+    u32 sleep_steps;
 };
 
 struct FluidNodeInfo2D
@@ -23,59 +112,273 @@ struct FluidNodeInfo2D
     glm::f32vec3 color;
 };
 
+// Stable reference to a node across reorders and removals. Ids are recycled once a node is removed,
+// the generation tells the new node apart from the one the handle was made for.
+struct FluidNodeHandle2D
+{
+    u32 id;
+    u32 generation;
+};
+
+struct FluidSimLookupCounters2D
+{
+    u32 candidate_count;
+    u32 collision_count;
+};
+
+struct FluidSimSnapshotHeader2D;
+class FluidSimObstacles2D;
+
 class FluidSimData2D
 {
 public:
     FluidSimData2D(FluidSimOptions2D options);
     ~FluidSimData2D() = default;
 
-    void InsertNode(FluidNodeInfo2D node, glm::f32vec2 position);
+    FluidNodeHandle2D InsertNode(FluidNodeInfo2D node, glm::f32vec2 position);
+    // Appends every node with one reservation per stream. When handles isn't empty it must be as long as nodes and
+    // receives the handle of each inserted node. Like removal it only marks the spatial lookup out of date.
+    void InsertNodes(std::span<const FluidNodeInfo2D> nodes, std::span<const glm::f32vec2> positions, std::span<FluidNodeHandle2D> handles = { });
+    // Removes each node in O(1) by moving the last node into its index. The spatial lookup is only marked out of date,
+    // the next step rebuilds it once however many batches were inserted or removed, see UpdateSpatialLookup.
+    // Handles of nodes that are already gone are skipped. Returns the number of nodes removed.
+    u32 RemoveNodes(std::span<const FluidNodeHandle2D> handles);
+    // Grows the capacity of every node stream, so inserting up to node_count nodes doesn't reallocate.
+    void ReserveNodes(u32 node_count);
     void MoveNodes(f64 delta_time);
+    // Moves every awake node to its predicted position, with the velocity that takes it there over delta_time.
+    void MoveNodesToPredicted(f64 delta_time);
+    // Reflects a predicted position that left a bouncing domain back inside, the distance past the wall scaled by
+    // the dampening factor. Unlike clamping, nodes that crossed at different points never land on the same one.
+    // Predicted positions inside an obstacle are pushed out to its surface.
+    void HandlePredictedEdge(u32 node_index);
+    // Nodes that end a move inside a built obstacle are pushed out along the field gradient and lose the velocity into
+    // it, scaled by the dampening factor like a wall bounce. Null removes the obstacles. Not owned, and not part of
+    // snapshots, so it has to outlive the data or be cleared first.
+    void SetObstacles(const FluidSimObstacles2D* obstacles);
 
     void ClearNodes();
 
-    using ForEachNodeFunc = std::function<void(FluidNodeInfo2D& node_info, const glm::f32vec2 position, u32 node_index)>;
-    using ForEachConstNodeFunc = std::function<void(const FluidNodeInfo2D& node_info, const glm::f32vec2 position, u32 node_index)>;
+    // Writes a header holding the step state of the given one, the node counts and the stream layout, followed
+    // by every node stream. See FluidSimSnapshot2D.h.
+    void WriteSnapshot(const FluidSimSnapshotHeader2D& state, std::vector<u8>& snapshot) const;
+    // Replaces every node with those of a snapshot ReadSnapshotHeader accepted, one copy per stream.
+    // Returns false, leaving no nodes, when its node ids or sleep states don't fit together.
+    bool ReadSnapshot(const FluidSimSnapshotHeader2D& header, std::span<const u8> snapshot);
+
+    // Permutes every node stream into the order of the current spatial lookup so that nodes in the
+    // same cell are next to each other in memory. Node indices change, node ids do not.
+    void ReorderNodes();
 
-    void ForEachNodeInCell(glm::ivec2 cell_coords, ForEachNodeFunc function);
-    void ForEachNodeInCell(glm::ivec2 cell_coords, ForEachConstNodeFunc function) const;
+    // Stable ids handed out on insertion, GetNodeIds()[node_index] is the id of the node currently at that index.
+    // Ids of removed nodes are reused, every live id is below GetNodeIdCapacity().
+    const std::vector<u32>& GetNodeIds() const;
+    // invalid_node_index for ids that aren't in use.
+    u32 GetNodeIndex(u32 node_id) const;
+    u32 GetNodeIdCapacity() const;
+    FluidNodeHandle2D GetNodeHandle(u32 node_index) const;
+    bool IsNodeAlive(FluidNodeHandle2D handle) const;
 
-    void ForEachNodeInCell(glm::f32vec2 sample_point, ForEachNodeFunc function);
-    void ForEachNodeInCell(glm::f32vec2 sample_point, ForEachConstNodeFunc function) const;
+    static constexpr u32 invalid_node_index = ~0u;
+
+    using ForEachNodeFunc = std::function<void(const glm::f32vec2 position, u32 node_index)>;
+
+    void ForEachNodeInCell(glm::ivec2 cell_coords, ForEachNodeFunc function) const;
+    void ForEachNodeInCell(glm::f32vec2 sample_point, ForEachNodeFunc function) const;
+
+    // Calls visitor(u32 node_index, const glm::f32vec2& position, f32 distance) for every node whose predicted
+    // position is within radius of the sample point. Templated so the visitor can be inlined into the hot loops.
+    // The returned counters describe the wasted work of the lookup: every node walked is a candidate,
+    // and in hashed mode candidates whose own cell differs from the walked cell are collisions.
+    template<typename Visitor>
+    FluidSimLookupCounters2D ForEachNodeInRadius(glm::f32vec2 sample_point, f32 radius, Visitor&& visitor) const;
+
+    // Calls visitor(u32 lookup_begin, u32 lookup_end) for every contiguous run of the cell lookup that may hold nodes
+    // within radius of the sample point. Nodes aren't distance tested, that is left to the visitor. In dense mode the
+    // cells of a grid row are adjacent in the lookup so each row of the search is a single span, in tiled mode
+    // each row within a tile is.
+    template<typename Visitor>
+    FluidSimLookupCounters2D ForEachSpanInRadius(glm::f32vec2 sample_point, f32 radius, Visitor&& visitor) const;
+    // Same as ForEachSpanInRadius over the cells [min_cell, max_cell] (inclusive).
+    template<typename Visitor>
+    FluidSimLookupCounters2D ForEachSpanInCells(glm::ivec2 min_cell, glm::ivec2 max_cell, Visitor&& visitor) const;
+
+    // Rebuilds the spatial lookup and the neighbour lists from the predicted positions, unless the skin still
+    // covers how far every node has moved since the last build. Returns true when the lists were rebuilt.
+    bool UpdateNeighbourLists();
+
+    // Same visitor as ForEachNodeInRadius, but walks the cached neighbour list of the node. The node itself is never listed.
+    template<typename Visitor>
+    FluidSimLookupCounters2D ForEachNeighbour(u32 node_index, f32 radius, Visitor&& visitor) const;
+
+    // CSR neighbour lists, the neighbours of a node are GetNeighbours()[offsets[node], offsets[node + 1]).
+    // Padded like the cell lookup.
+    const std::vector<u32>& GetNeighbourOffsets() const;
+    const std::vector<u32>& GetNeighbours() const;
+
+    // Updates which cells are asleep from the velocities of the nodes in the current spatial lookup,
+    // then the sleep state of every node. Called once per step after the lookup has been built.
+    void UpdateSleep();
+    // Keeps every cell overlapping the circle awake on the next UpdateSleep, e.g. where a force is applied.
+    void WakeRegion(glm::f32vec2 position, f32 radius);
+    bool IsNodeAwake(u32 node_index) const;
+    // Empty unless sleeping is enabled and UpdateSleep has run since nodes were last inserted.
+    const std::vector<FluidSimSleepState2D>& GetNodeSleepStates() const;
+    u32 GetAwakeNodeCount() const;
+
+    // Splits the nodes into contiguous ranges and calls the function once per range. When multithreaded
+    // the ranges are run on the JobDispatch workers, so the function must only write to nodes in its own range.
+    using ForEachRangeFunc = FluidSimCore::ForEachRangeFunc;
+    void ForEachNodeRange(ForEachRangeFunc function) const;
+    u32 GetRangeCount() const;
+
+    // Same as ForEachNodeRange but over [0, count) with an explicit number of ranges.
+    void ForEachRange(u32 count, u32 range_count, ForEachRangeFunc function) const;
+    // Ranges over the cell lookup that only start at cell boundaries, so all nodes of a cell are in the same range.
+    void ForEachCellRange(ForEachRangeFunc function) const;
 
     glm::ivec2 GetCellCoordinates(glm::f32vec2 position) const;
+    // The cell a node at the position is filed under, outside of a bounded grid that's the nearest edge cell.
+    glm::ivec2 GetFiledCellCoordinates(glm::f32vec2 position) const;
 
-    std::vector<FluidNodeInfo2D>& GetNodeInfos();
-    const std::vector<FluidNodeInfo2D>& GetNodeInfos() const;
+    // Node state is stored as one contiguous stream per field so that passes only pull
+    // the fields they actually use into cache.
+    std::vector<glm::f32vec2>& GetNodeVelocities();
+    const std::vector<glm::f32vec2>& GetNodeVelocities() const;
+    std::vector<f32>& GetNodeDensities();
+    const std::vector<f32>& GetNodeDensities() const;
+    std::vector<glm::f32vec3>& GetNodeColors();
+    const std::vector<glm::f32vec3>& GetNodeColors() const;
+    const std::vector<f32>& GetNodeMasses() const;
+    const std::vector<f32>& GetNodeRadii() const;
+
+    FluidNodeInfo2D GetNodeInfo(u32 node_index) const;
+
+    // Packs the streams back into FluidNodeInfo2D layout, destination must hold GetNodeCount() entries.
+    void WriteNodeInfos(FluidNodeInfo2D* destination) const;
 
     const std::vector<glm::f32vec4>& GetNodePositions() const;
+    std::vector<glm::f32vec2>& GetNodePredictedPositions();
     const std::vector<glm::f32vec2>& GetNodePredictedPositions() const;
 
+    // Node indices in cell order. Padded with FluidSimSimd::width valid indices past the node count
+    // so vector kernels can read whole batches off the end of a span and mask the extra lanes.
+    const std::vector<u32>& GetCellLookup() const;
+
+    // Predicted positions gathered into cell lookup order (and padded the same way) so kernels
+    // can load a span of neighbours contiguously. Only filled when simd_kernels, neighbour_lists
+    // or symmetric_pressure is enabled.
+    const std::vector<f32>& GetLookupPositionsX() const;
+    const std::vector<f32>& GetLookupPositionsY() const;
+
     u32 GetNodeCount() const;
     const FluidSimOptions2D& GetOptions() const;
 
-    void FillPredictedPositions();
+    // Positions lookahead_time ahead at the current velocities. The SPH passes only look a fixed short way ahead.
+    void FillPredictedPositions(f32 lookahead_time = 1.f / 120.f);
+    // Counting sort of the nodes by cell id, O(nodes + cells). When multithreaded each worker
+    // builds a histogram for its own node range so the scatter can run without atomics.
     void BuildSpatialLookup(bool use_predicted_positions = false);
+    // Builds the spatial lookup from the current positions if nodes were inserted or removed since it was last built.
+    // For anything that reads the lookup before the step has rebuilt it.
+    void UpdateSpatialLookup();
+    // Gathers the predicted positions into lookup order again, for passes that move them without changing cells.
+    void FillLookupPositions();
 private:
+    u32 AllocateNodeId();
+    // Marks the spatial lookup out of date and drops everything derived from node indices after nodes were inserted
+    // or removed.
+    void OnNodesChanged();
+    // Every option copied on its own, so the padding of the zeroed snapshot header stays zero. New options go here too.
+    void WriteSnapshotOptions(FluidSimOptions2D& options) const;
+
+    // Allocates a tile for every node that lacks one and fills the cell ids, serially since the tile map is shared.
+    // Rebuilds the tile map from scratch once most tiles have emptied.
+    void FillTiledCellIds(bool use_predicted_positions);
+    void FillCellIds(bool use_predicted_positions, u32 range_begin, u32 range_end);
+
+    bool NeighbourListsCoverMovement() const;
+    void BuildNeighbourLists();
+
+    // Coordinates of a non-empty cell. Colliding cells in hashed mode share a bucket, the first node's cell is used.
+    glm::ivec2 GetLookupCellCoordinates(u32 cell_id) const;
+
+    bool IsCellInGrid(glm::ivec2 cell_coords) const;
+    glm::ivec2 ClampToGrid(glm::ivec2 cell_coords) const;
     u32 GetCellId(glm::ivec2 cell_coords) const;
     void HandleEdge(u64 node_idx);
+    void HandleDomainEdge(u64 node_idx);
+    // One field sample per node, so the cost doesn't depend on how many outlines the obstacles were built from.
+    void HandleObstacles(u64 node_idx);
 private:
     FluidSimOptions2D m_options;
+    const FluidSimObstacles2D* m_obstacles{ nullptr };
 
     std::vector<glm::f32vec4> m_positions;
     std::vector<glm::f32vec2> m_predictedPositions;
-    std::vector<FluidNodeInfo2D> m_nodeInfos;
+    std::vector<glm::f32vec2> m_velocities;
+    std::vector<f32> m_radii;
+    std::vector<f32> m_densities;
+    std::vector<f32> m_masses;
+    std::vector<glm::f32vec3> m_colors;
+
+    std::vector<u32> m_nodeIds;
+    // Indexed by id.
+    std::vector<u32> m_nodeIndices;
+    std::vector<u32> m_nodeGenerations;
+    std::vector<u32> m_freeNodeIds;
+
+    // Node indices sorted by cell, the nodes of a cell are m_cellLookup[m_cellOffsets[id], m_cellOffsets[id + 1]).
+    std::vector<u32> m_cellLookup;
+    std::vector<u32> m_cellOffsets;
+    std::vector<u32> m_nodeCellIds;
+    // In tiled mode cells outside of any tile all map to cell id m_cellCount, which is always empty.
+    // m_cellOffsets has an extra entry for it.
+    u32 m_cellCount{ 0 };
 
-    struct CellLookup
-    {
-        u32 node_index;
-        u32 cell_id;
-    };
+    // Tiles of tile_size * tile_size cells, the cells of a tile are contiguous ids in row order.
+    FluidSimTileMap2D m_tiles;
+    std::vector<u8> m_tileOccupied;
 
-    std::vector<CellLookup> m_cellLookup;
-    static constexpr u32 invalid_index = u32_max;
-    std::vector<u32> m_startIndices;
+    std::vector<f32> m_lookupPositionsX;
+    std::vector<f32> m_lookupPositionsY;
+
+    std::vector<u32> m_neighbourOffsets;
+    std::vector<u32> m_neighbours;
+    // Predicted positions the lists were built from, to measure movement against the skin.
+    std::vector<glm::f32vec2> m_neighbourListPositions;
+    // Per range scratch for the parallel build and the movement check.
+    std::vector<std::vector<u32>> m_rangeNeighbours;
+    mutable std::vector<f32> m_rangeDisplacements;
+    bool m_neighbourListsValid{ false };
+    // Nodes were inserted or removed since the spatial lookup was built.
+    bool m_lookupDirty{ false };
+
+    // Per cell sleep tracking, indexed like m_cellOffsets.
+    std::vector<u8> m_cellEnergetic;
+    std::vector<u8> m_cellAsleep;
+    std::vector<u32> m_cellQuietSteps;
+    std::vector<FluidSimSleepState2D> m_nodeSleepStates;
+    // Circles to keep awake on the next UpdateSleep, xy position and z radius.
+    std::vector<glm::f32vec3> m_wakeRegions;
+    u32 m_awakeNodeCount{ 0 };
+
+    // Per range histograms for the parallel build, laid out [range][cell].
+    std::vector<u32> m_rangeCellCounts;
 
     i32 m_rows;
     i32 m_columns;
-};
\ No newline at end of file
+
+    static constexpr u32 lookup_padding = FluidSimCore::lookup_padding;
+    // Wide enough that most searches stay inside one tile per row, a tile row breaks a span of the lookup.
+    static constexpr i32 tile_size_shift = 4;
+    static constexpr i32 tile_size = 1 << tile_size_shift;
+    static constexpr u32 cells_per_tile = tile_size * tile_size;
+    // Tile maps this small are never worth compacting.
+    static constexpr u32 min_compact_tile_count = 64;
+};
+
+#ifndef INC_FLUIDSIM_DATA_2D_INL
+#define INC_FLUIDSIM_DATA_2D_INL
+#include "FluidSimData2D.inl"
+#endif
\ No newline at end of file
@@ -0,0 +1,213 @@
+#include "FluidSimData2D.h"
+
+inline bool FluidSimData2D::IsCellInGrid(glm::ivec2 cell_coords) const
+{
+    if( m_options.grid_mode != FluidSimGridMode2D::Dense )
+        return true;
+
+    return cell_coords.x >= 0 && cell_coords.x < m_columns
+        && cell_coords.y >= 0 && cell_coords.y < m_rows;
+}
+
+inline u32 FluidSimData2D::GetCellId(glm::ivec2 cell_coords) const
+{
+    if( m_options.grid_mode == FluidSimGridMode2D::Dense )
+        return u32_cast(cell_coords.y * m_columns + cell_coords.x);
+
+    if( m_options.grid_mode == FluidSimGridMode2D::Tiled )
+    {
+        // Arithmetic shifts and masks floor correctly for negative coordinates too.
+        u32 tile_index = m_tiles.Find(cell_coords >> tile_size_shift);
+        if( tile_index == FluidSimTileMap2D::invalid_tile )
+            return m_cellCount;
+
+        glm::ivec2 local = cell_coords & (tile_size - 1);
+        return tile_index * cells_per_tile + u32_cast(local.y * tile_size + local.x);
+    }
+
+    static constexpr u32 prime0 = 929;
+    static constexpr u32 prime1 = 7127;
+    i32 cell_id = cell_coords.x * prime0 + cell_coords.y * prime1;
+    return cell_id % GetNodeCount();
+}
+
+inline bool FluidSimData2D::IsNodeAwake(u32 node_index) const
+{
+    return m_nodeSleepStates.empty() || m_nodeSleepStates[node_index] == FluidSimSleepState2D::Awake;
+}
+
+template<typename Visitor>
+FluidSimLookupCounters2D FluidSimData2D::ForEachNodeInRadius(glm::f32vec2 sample_point, f32 radius, Visitor&& visitor) const
+{
+    FluidSimLookupCounters2D counters{ };
+    if( !m_cellCount )
+        return counters;
+
+    // Walking the tile rows looks each tile up once instead of once per cell.
+    if( m_options.grid_mode == FluidSimGridMode2D::Tiled )
+    {
+        return ForEachSpanInRadius(sample_point, radius, [&](u32 span_begin, u32 span_end)
+            {
+                for( u32 idx = span_begin; idx < span_end; idx++ )
+                {
+                    u32 node_index = m_cellLookup[idx];
+                    const glm::f32vec2& position = m_predictedPositions[node_index];
+
+                    f32 distance = glm::length(position - sample_point);
+                    if( distance <= radius )
+                        visitor(node_index, position, distance);
+                }
+            });
+    }
+
+    // Only the cells the bounds of the search circle overlap, no fixed +-range around the sample cell.
+    glm::ivec2 min_cell = GetCellCoordinates(sample_point - radius);
+    glm::ivec2 max_cell = GetCellCoordinates(sample_point + radius);
+
+    for( i32 cell_y = min_cell.y; cell_y <= max_cell.y; cell_y++ )
+    {
+        for( i32 cell_x = min_cell.x; cell_x <= max_cell.x; cell_x++ )
+        {
+            glm::ivec2 cell_coords{ cell_x, cell_y };
+            if( !IsCellInGrid(cell_coords) )
+                continue;
+
+            u32 cell_id = GetCellId(cell_coords);
+            u32 cell_begin = m_cellOffsets[cell_id];
+            u32 cell_end = m_cellOffsets[cell_id + 1];
+            counters.candidate_count += cell_end - cell_begin;
+
+            for( u32 idx = cell_begin; idx < cell_end; idx++ )
+            {
+                u32 node_index = m_cellLookup[idx];
+                const glm::f32vec2& position = m_predictedPositions[node_index];
+
+                f32 distance = glm::length(position - sample_point);
+                if( distance > radius )
+                {
+                    if( m_options.grid_mode == FluidSimGridMode2D::Hashed && GetCellCoordinates(position) != cell_coords )
+                        counters.collision_count++;
+
+                    continue;
+                }
+
+                visitor(node_index, position, distance);
+            }
+        }
+    }
+
+    return counters;
+}
+
+
+template<typename Visitor>
+FluidSimLookupCounters2D FluidSimData2D::ForEachSpanInRadius(glm::f32vec2 sample_point, f32 radius, Visitor&& visitor) const
+{
+    // Only the cells the bounds of the search circle overlap, no fixed +-range around the sample cell.
+    return ForEachSpanInCells(GetCellCoordinates(sample_point - radius), GetCellCoordinates(sample_point + radius), visitor);
+}
+
+template<typename Visitor>
+FluidSimLookupCounters2D FluidSimData2D::ForEachSpanInCells(glm::ivec2 min_cell, glm::ivec2 max_cell, Visitor&& visitor) const
+{
+    FluidSimLookupCounters2D counters{ };
+    if( !m_cellCount )
+        return counters;
+
+    if( m_options.grid_mode == FluidSimGridMode2D::Dense )
+    {
+        i32 first_column = std::max(min_cell.x, 0);
+        i32 last_column = std::min(max_cell.x, m_columns - 1);
+        if( first_column > last_column )
+            return counters;
+
+        for( i32 cell_y = std::max(min_cell.y, 0); cell_y <= std::min(max_cell.y, m_rows - 1); cell_y++ )
+        {
+            u32 span_begin = m_cellOffsets[GetCellId({ first_column, cell_y })];
+            u32 span_end = m_cellOffsets[GetCellId({ last_column, cell_y }) + 1];
+            if( span_begin == span_end )
+                continue;
+
+            counters.candidate_count += span_end - span_begin;
+            visitor(span_begin, span_end);
+        }
+
+        return counters;
+    }
+
+    if( m_options.grid_mode == FluidSimGridMode2D::Tiled )
+    {
+        // Each row of a tile is contiguous in the lookup, so the search is one span per tile row it overlaps.
+        glm::ivec2 min_tile = min_cell >> tile_size_shift;
+        glm::ivec2 max_tile = max_cell >> tile_size_shift;
+        for( i32 tile_y = min_tile.y; tile_y <= max_tile.y; tile_y++ )
+        {
+            for( i32 tile_x = min_tile.x; tile_x <= max_tile.x; tile_x++ )
+            {
+                u32 tile_index = m_tiles.Find({ tile_x, tile_y });
+                if( tile_index == FluidSimTileMap2D::invalid_tile )
+                    continue;
+
+                glm::ivec2 tile_origin = glm::ivec2{ tile_x, tile_y } * tile_size;
+                glm::ivec2 first_local = glm::max(min_cell - tile_origin, 0);
+                glm::ivec2 last_local = glm::min(max_cell - tile_origin, tile_size - 1);
+                u32 tile_first_cell = tile_index * cells_per_tile;
+
+                for( i32 local_y = first_local.y; local_y <= last_local.y; local_y++ )
+                {
+                    u32 row_first_cell = tile_first_cell + u32_cast(local_y * tile_size);
+                    u32 span_begin = m_cellOffsets[row_first_cell + u32_cast(first_local.x)];
+                    u32 span_end = m_cellOffsets[row_first_cell + u32_cast(last_local.x) + 1];
+                    if( span_begin == span_end )
+                        continue;
+
+                    counters.candidate_count += span_end - span_begin;
+                    visitor(span_begin, span_end);
+                }
+            }
+        }
+
+        return counters;
+    }
+
+    for( i32 cell_y = min_cell.y; cell_y <= max_cell.y; cell_y++ )
+    {
+        for( i32 cell_x = min_cell.x; cell_x <= max_cell.x; cell_x++ )
+        {
+            u32 cell_id = GetCellId({ cell_x, cell_y });
+            u32 span_begin = m_cellOffsets[cell_id];
+            u32 span_end = m_cellOffsets[cell_id + 1];
+            if( span_begin == span_end )
+                continue;
+
+            counters.candidate_count += span_end - span_begin;
+            visitor(span_begin, span_end);
+        }
+    }
+
+    return counters;
+}
+
+template<typename Visitor>
+FluidSimLookupCounters2D FluidSimData2D::ForEachNeighbour(u32 node_index, f32 radius, Visitor&& visitor) const
+{
+    FluidSimLookupCounters2D counters{ };
+    u32 list_begin = m_neighbourOffsets[node_index];
+    u32 list_end = m_neighbourOffsets[node_index + 1];
+    counters.candidate_count = list_end - list_begin;
+
+    const glm::f32vec2& sample_point = m_predictedPositions[node_index];
+    for( u32 idx = list_begin; idx < list_end; idx++ )
+    {
+        u32 neighbour_index = m_neighbours[idx];
+        const glm::f32vec2& position = m_predictedPositions[neighbour_index];
+
+        f32 distance = glm::length(position - sample_point);
+        if( distance > radius )
+            continue;
+
+        visitor(neighbour_index, position, distance);
+    }
+
+    return counters;
+}
\ No newline at end of file
@@ -0,0 +1,403 @@
+#include "FluidSimData3D.h"
+#include "sim_channels.h"
+
+FluidSimData3D::FluidSimData3D(FluidSimOptions3D options) :
+    m_options(options)
+{
+    glm::vec3 size = options.domain.size();
+    m_cells = glm::max(glm::ivec3(glm::ceil(size / options.grid_extent)), 1);
+}
+
+void FluidSimData3D::InsertNodes(std::span<const FluidNodeInfo3D> nodes, std::span<const glm::f32vec3> positions)
+{
+    FLUIDSIM_ASSERT(nodes.size() == positions.size(), "Every inserted node needs a position.");
+
+    u64 node_count = GetNodeCount() + nodes.size();
+    m_positions.reserve(node_count);
+    m_predictedX.reserve(node_count);
+    m_predictedY.reserve(node_count);
+    m_predictedZ.reserve(node_count);
+    m_velocities.reserve(node_count);
+    m_radii.reserve(node_count);
+    m_densities.reserve(node_count);
+    m_masses.reserve(node_count);
+    m_colors.reserve(node_count);
+    m_nodeIds.reserve(node_count);
+    m_nodeIndices.reserve(node_count);
+
+    for( u64 idx = 0; idx < nodes.size(); idx++ )
+    {
+        const glm::f32vec3& position = positions[idx];
+        m_positions.push_back(position);
+        m_predictedX.push_back(position.x);
+        m_predictedY.push_back(position.y);
+        m_predictedZ.push_back(position.z);
+        m_velocities.push_back(nodes[idx].velocity);
+        m_radii.push_back(nodes[idx].node_radius);
+        m_densities.push_back(nodes[idx].density);
+        m_masses.push_back(nodes[idx].mass);
+        m_colors.push_back(nodes[idx].color);
+
+        // Nodes are never removed one by one, so ids are simply handed out in insertion order.
+        u32 node_id = u32_cast(m_nodeIndices.size());
+        m_nodeIds.push_back(node_id);
+        m_nodeIndices.push_back(GetNodeCount() - 1);
+    }
+
+    m_neighbourListsValid = false;
+    BuildSpatialLookup();
+}
+
+void FluidSimData3D::ClearNodes()
+{
+    m_positions.clear();
+    m_predictedX.clear();
+    m_predictedY.clear();
+    m_predictedZ.clear();
+    m_velocities.clear();
+    m_radii.clear();
+    m_densities.clear();
+    m_masses.clear();
+    m_colors.clear();
+    m_nodeIds.clear();
+    m_nodeIndices.clear();
+    m_neighbourListsValid = false;
+    BuildSpatialLookup();
+}
+
+void FluidSimData3D::MoveNodes(f64 delta_time)
+{
+    f32 time = f32_cast(delta_time);
+    ForEachNodeRange([&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u32 node_idx = range_begin; node_idx < range_end; node_idx++ )
+            {
+                m_positions[node_idx] += m_velocities[node_idx] * time;
+                HandleEdge(node_idx);
+            }
+        });
+}
+
+void FluidSimData3D::ReorderNodes()
+{
+    if( m_cellLookup.size() != GetNodeCount() + lookup_padding )
+        BuildSpatialLookup();
+
+    // m_cellLookup holds node indices in cell order, which is exactly the gather order we want.
+    u32 range_count = GetRangeCount();
+    FluidSimCore::PermuteStream(m_positions, m_cellLookup, range_count);
+    FluidSimCore::PermuteStream(m_predictedX, m_cellLookup, range_count);
+    FluidSimCore::PermuteStream(m_predictedY, m_cellLookup, range_count);
+    FluidSimCore::PermuteStream(m_predictedZ, m_cellLookup, range_count);
+    FluidSimCore::PermuteStream(m_velocities, m_cellLookup, range_count);
+    FluidSimCore::PermuteStream(m_radii, m_cellLookup, range_count);
+    FluidSimCore::PermuteStream(m_densities, m_cellLookup, range_count);
+    FluidSimCore::PermuteStream(m_masses, m_cellLookup, range_count);
+    FluidSimCore::PermuteStream(m_colors, m_cellLookup, range_count);
+    FluidSimCore::PermuteStream(m_nodeIds, m_cellLookup, range_count);
+    FluidSimCore::PermuteStream(m_nodeCellIds, m_cellLookup, range_count);
+
+    // The lists hold node indices, which have all just changed.
+    m_neighbourListsValid = false;
+
+    ForEachNodeRange([&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u32 node_idx = range_begin; node_idx < range_end; node_idx++ )
+            {
+                m_cellLookup[node_idx] = node_idx;
+                m_nodeIndices[m_nodeIds[node_idx]] = node_idx;
+            }
+        });
+}
+
+const std::vector<u32>& FluidSimData3D::GetNodeIds() const
+{
+    return m_nodeIds;
+}
+
+u32 FluidSimData3D::GetNodeIndex(u32 node_id) const
+{
+    return m_nodeIndices[node_id];
+}
+
+void FluidSimData3D::FillPredictedPositions()
+{
+    constexpr f32 const_lookahead_dt = 1.f / 120.f;
+    ForEachNodeRange([&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u32 node_idx = range_begin; node_idx < range_end; node_idx++ )
+            {
+                glm::f32vec3 predicted = m_positions[node_idx] + m_velocities[node_idx] * const_lookahead_dt;
+                m_predictedX[node_idx] = predicted.x;
+                m_predictedY[node_idx] = predicted.y;
+                m_predictedZ[node_idx] = predicted.z;
+            }
+        });
+}
+
+void FluidSimData3D::BuildSpatialLookup()
+{
+    m_cellLookup.resize(GetNodeCount() + lookup_padding);
+    m_nodeCellIds.resize(GetNodeCount());
+    m_cellCount = u32_cast(m_cells.x * m_cells.y * m_cells.z);
+    m_cellOffsets.assign(m_cellCount + 2, 0);
+    std::fill(m_cellLookup.end() - lookup_padding, m_cellLookup.end(), 0);
+
+    if( !GetNodeCount() )
+        return;
+
+    u32 sort_ranges = FluidSimCore::GetSortRangeCount(GetNodeCount(), m_options.multithreaded);
+    FluidSimCore::ForEachRange(GetNodeCount(), sort_ranges, [&](u32 range_begin, u32 range_end, u32)
+        {
+            FillCellIds(range_begin, range_end);
+        });
+
+    FluidSimCore::SortByCell(m_nodeCellIds, m_cellCount, sort_ranges, m_cellOffsets,
+        std::span<u32>(m_cellLookup.data(), GetNodeCount()), m_rangeCellCounts);
+
+    FillLookupPositions();
+}
+
+bool FluidSimData3D::UpdateNeighbourLists()
+{
+    if( NeighbourListsCoverMovement() )
+        return false;
+
+    BuildSpatialLookup();
+    BuildNeighbourLists();
+    return true;
+}
+
+const std::vector<u32>& FluidSimData3D::GetNeighbourOffsets() const
+{
+    return m_neighbourOffsets;
+}
+
+const std::vector<u32>& FluidSimData3D::GetNeighbours() const
+{
+    return m_neighbours;
+}
+
+void FluidSimData3D::ForEachNodeRange(FluidSimCore::ForEachRangeFunc function) const
+{
+    FluidSimCore::ForEachRange(GetNodeCount(), GetRangeCount(), function);
+}
+
+u32 FluidSimData3D::GetRangeCount() const
+{
+    return FluidSimCore::GetRangeCount(GetNodeCount(), m_options.multithreaded);
+}
+
+glm::ivec3 FluidSimData3D::GetCellCoordinates(glm::f32vec3 position) const
+{
+    return glm::ivec3(glm::floor((position - m_options.domain.min) / m_options.grid_extent));
+}
+
+std::vector<glm::f32vec3>& FluidSimData3D::GetNodeVelocities()
+{
+    return m_velocities;
+}
+
+const std::vector<glm::f32vec3>& FluidSimData3D::GetNodeVelocities() const
+{
+    return m_velocities;
+}
+
+std::vector<f32>& FluidSimData3D::GetNodeDensities()
+{
+    return m_densities;
+}
+
+const std::vector<f32>& FluidSimData3D::GetNodeDensities() const
+{
+    return m_densities;
+}
+
+const std::vector<f32>& FluidSimData3D::GetNodeMasses() const
+{
+    return m_masses;
+}
+
+const std::vector<f32>& FluidSimData3D::GetNodeRadii() const
+{
+    return m_radii;
+}
+
+const std::vector<glm::f32vec3>& FluidSimData3D::GetNodeColors() const
+{
+    return m_colors;
+}
+
+const std::vector<glm::f32vec3>& FluidSimData3D::GetNodePositions() const
+{
+    return m_positions;
+}
+
+const std::vector<f32>& FluidSimData3D::GetPredictedPositionsX() const
+{
+    return m_predictedX;
+}
+
+const std::vector<f32>& FluidSimData3D::GetPredictedPositionsY() const
+{
+    return m_predictedY;
+}
+
+const std::vector<f32>& FluidSimData3D::GetPredictedPositionsZ() const
+{
+    return m_predictedZ;
+}
+
+const std::vector<u32>& FluidSimData3D::GetCellLookup() const
+{
+    return m_cellLookup;
+}
+
+const std::vector<f32>& FluidSimData3D::GetLookupPositionsX() const
+{
+    return m_lookupPositionsX;
+}
+
+const std::vector<f32>& FluidSimData3D::GetLookupPositionsY() const
+{
+    return m_lookupPositionsY;
+}
+
+const std::vector<f32>& FluidSimData3D::GetLookupPositionsZ() const
+{
+    return m_lookupPositionsZ;
+}
+
+u32 FluidSimData3D::GetNodeCount() const
+{
+    return u32_cast(m_positions.size());
+}
+
+const FluidSimOptions3D& FluidSimData3D::GetOptions() const
+{
+    return m_options;
+}
+
+void FluidSimData3D::FillCellIds(u32 range_begin, u32 range_end)
+{
+    for( u32 node_idx = range_begin; node_idx < range_end; node_idx++ )
+    {
+        // Nodes can be predicted slightly outside of the domain, keep them in the edge cells.
+        glm::ivec3 cell_coords = ClampToGrid(GetCellCoordinates(GetNodePredictedPosition(node_idx)));
+        m_nodeCellIds[node_idx] = GetCellId(cell_coords);
+    }
+}
+
+void FluidSimData3D::FillLookupPositions()
+{
+    m_lookupPositionsX.resize(GetNodeCount() + lookup_padding);
+    m_lookupPositionsY.resize(GetNodeCount() + lookup_padding);
+    m_lookupPositionsZ.resize(GetNodeCount() + lookup_padding);
+
+    FluidSimCore::ForEachRange(u32_cast(m_cellLookup.size()), GetRangeCount(), [&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u32 idx = range_begin; idx < range_end; idx++ )
+            {
+                u32 node_idx = m_cellLookup[idx];
+                m_lookupPositionsX[idx] = m_predictedX[node_idx];
+                m_lookupPositionsY[idx] = m_predictedY[node_idx];
+                m_lookupPositionsZ[idx] = m_predictedZ[node_idx];
+            }
+        });
+}
+
+bool FluidSimData3D::NeighbourListsCoverMovement() const
+{
+    if( !m_neighbourListsValid || m_options.neighbour_skin <= 0.f )
+        return false;
+
+    f32 half_skin = m_options.neighbour_skin * 0.5f;
+    f32 max_displacement = FluidSimCore::GetMaxDisplacementSquared(GetNodeCount(), GetRangeCount(), [&](u32 node_idx)
+        {
+            glm::f32vec3 moved = GetNodePredictedPosition(node_idx) - m_neighbourListPositions[node_idx];
+            return glm::dot(moved, moved);
+        }, m_rangeDisplacements);
+    return max_displacement <= half_skin * half_skin;
+}
+
+void FluidSimData3D::BuildNeighbourLists()
+{
+    using simd = FluidSimSimd;
+    f32 search_radius = m_options.smoothing_radius + std::max(m_options.neighbour_skin, 0.f);
+    simd::floats search_radius_squared = simd::Set(search_radius * search_radius);
+
+    FluidSimCore::BuildNeighbourLists(GetNodeCount(), GetRangeCount(), [&](u32 node_idx, std::vector<u32>& range_neighbours)
+        {
+            glm::f32vec3 node_position = GetNodePredictedPosition(node_idx);
+            simd::floats position_x = simd::Set(node_position.x);
+            simd::floats position_y = simd::Set(node_position.y);
+            simd::floats position_z = simd::Set(node_position.z);
+
+            ForEachSpanInRadius(node_position, search_radius, [&](u32 span_begin, u32 span_end)
+                {
+                    for( u32 idx = span_begin; idx < span_end; idx += simd::width )
+                    {
+                        simd::floats delta_x = simd::Sub(simd::Load(&m_lookupPositionsX[idx]), position_x);
+                        simd::floats delta_y = simd::Sub(simd::Load(&m_lookupPositionsY[idx]), position_y);
+                        simd::floats delta_z = simd::Sub(simd::Load(&m_lookupPositionsZ[idx]), position_z);
+                        simd::floats distance_squared = simd::Add(simd::Add(simd::Mul(delta_x, delta_x), simd::Mul(delta_y, delta_y)), simd::Mul(delta_z, delta_z));
+                        simd::mask in_radius = simd::And(simd::FirstLanes(span_end - idx), simd::LessEqual(distance_squared, search_radius_squared));
+
+                        for( u32 lanes = simd::MaskBits(in_radius); lanes; lanes &= lanes - 1 )
+                        {
+                            u32 node_index = m_cellLookup[idx + std::countr_zero(lanes)];
+                            if( node_index != node_idx )
+                                range_neighbours.push_back(node_index);
+                        }
+                    }
+                });
+        }, m_neighbourOffsets, m_neighbours, m_rangeNeighbours);
+
+    m_neighbourListPositions.resize(GetNodeCount());
+    ForEachNodeRange([&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u32 node_idx = range_begin; node_idx < range_end; node_idx++ )
+            {
+                m_neighbourListPositions[node_idx] = GetNodePredictedPosition(node_idx);
+            }
+        });
+    m_neighbourListsValid = true;
+}
+
+glm::ivec3 FluidSimData3D::ClampToGrid(glm::ivec3 cell_coords) const
+{
+    return glm::clamp(cell_coords, glm::ivec3(0), m_cells - 1);
+}
+
+void FluidSimData3D::HandleEdge(u32 node_idx)
+{
+    glm::f32vec3& position = m_positions[node_idx];
+    const glm::vec3& min = m_options.domain.min;
+    const glm::vec3& max = m_options.domain.max;
+
+    for( i32 axis = 0; axis < 3; axis++ )
+    {
+        if( m_options.should_bounce )
+        {
+            if( position[axis] < min[axis] )
+            {
+                position[axis] = 2.f * min[axis] - position[axis];
+                m_velocities[node_idx][axis] *= -m_options.dampening_factor;
+            }
+            else if( position[axis] >= max[axis] )
+            {
+                position[axis] = 2.f * max[axis] - position[axis];
+                m_velocities[node_idx][axis] *= -m_options.dampening_factor;
+            }
+        }
+        else
+        {
+            // Should not bounce, pass through walls.
+            f32 size = max[axis] - min[axis];
+            if( position[axis] < min[axis] )
+                position[axis] += size;
+            else if( position[axis] > max[axis] )
+                position[axis] -= size;
+        }
+    }
+}
@@ -0,0 +1,164 @@
+#pragma once
+#include "FluidSimCore.h"
+#include "data/aabb.h"
+
+#include <span>
+
+struct FluidSimOptions3D
+{
+    // Nodes are kept inside the domain, which a dense grid of cubic cells grid_extent across covers.
+    mtl::aabb3 domain;
+    f32 grid_extent;
+
+    bool should_bounce;
+    f32 dampening_factor;
+
+    f32 smoothing_radius;
+    f32 target_density;
+    f32 pressure_multiplier;
+
+    bool multithreaded;
+
+    // Same as FluidSimOptions2D, lists reused until any node has moved more than half the skin.
+    bool neighbour_lists;
+    f32 neighbour_skin;
+
+    // Steps between permuting the node streams into cell order, 0 to never reorder.
+    u32 reorder_interval;
+};
+
+struct FluidNodeInfo3D
+{
+    glm::f32vec3 velocity;
+    f32 node_radius;
+    f32 density;
+    f32 mass;
+
+    glm::f32vec3 color;
+};
+
+// Node streams and spatial lookup of FluidSim3D. The grid is always dense over the bounded domain, the cells of a
+// grid row are adjacent in the lookup so a search is one span per row of cells it overlaps in y and z.
+// Sorting, ranges, reordering and neighbour lists run on FluidSimCore, the same as FluidSimData2D.
+class FluidSimData3D
+{
+public:
+    FluidSimData3D(FluidSimOptions3D options);
+    ~FluidSimData3D() = default;
+
+    // Appends every node with one reservation per stream and rebuilds the spatial lookup once.
+    void InsertNodes(std::span<const FluidNodeInfo3D> nodes, std::span<const glm::f32vec3> positions);
+    void ClearNodes();
+
+    // Moves the nodes by their velocity and keeps them inside the domain.
+    void MoveNodes(f64 delta_time);
+
+    // Permutes every node stream into the order of the current spatial lookup, node ids do not change.
+    void ReorderNodes();
+
+    // Stable ids handed out on insertion, GetNodeIds()[node_index] is the id of the node currently at that index.
+    const std::vector<u32>& GetNodeIds() const;
+    u32 GetNodeIndex(u32 node_id) const;
+
+    void FillPredictedPositions();
+    // Counting sort of the nodes by the cell of their predicted position, see FluidSimCore::SortByCell.
+    void BuildSpatialLookup();
+    // Rebuilds the spatial lookup and the neighbour lists, unless the skin still covers how far every node
+    // has moved since the last build. Returns true when the lists were rebuilt.
+    bool UpdateNeighbourLists();
+
+    // Calls visitor(u32 lookup_begin, u32 lookup_end) for every run of the cell lookup that may hold nodes
+    // within radius of the sample point. Returns the number of nodes in those runs.
+    template<typename Visitor>
+    u32 ForEachSpanInRadius(glm::f32vec3 sample_point, f32 radius, Visitor&& visitor) const;
+
+    // CSR neighbour lists, the neighbours of a node are GetNeighbours()[offsets[node], offsets[node + 1]).
+    // Padded like the cell lookup.
+    const std::vector<u32>& GetNeighbourOffsets() const;
+    const std::vector<u32>& GetNeighbours() const;
+
+    void ForEachNodeRange(FluidSimCore::ForEachRangeFunc function) const;
+    u32 GetRangeCount() const;
+
+    glm::ivec3 GetCellCoordinates(glm::f32vec3 position) const;
+
+    std::vector<glm::f32vec3>& GetNodeVelocities();
+    const std::vector<glm::f32vec3>& GetNodeVelocities() const;
+    std::vector<f32>& GetNodeDensities();
+    const std::vector<f32>& GetNodeDensities() const;
+    const std::vector<f32>& GetNodeMasses() const;
+    const std::vector<f32>& GetNodeRadii() const;
+    const std::vector<glm::f32vec3>& GetNodeColors() const;
+    const std::vector<glm::f32vec3>& GetNodePositions() const;
+
+    // Predicted positions are planar so kernels can gather one axis of eight neighbours with a single instruction.
+    const std::vector<f32>& GetPredictedPositionsX() const;
+    const std::vector<f32>& GetPredictedPositionsY() const;
+    const std::vector<f32>& GetPredictedPositionsZ() const;
+    glm::f32vec3 GetNodePredictedPosition(u32 node_index) const;
+
+    // Node indices in cell order, padded with FluidSimSimd::width valid indices past the node count.
+    const std::vector<u32>& GetCellLookup() const;
+    // Predicted positions gathered into cell lookup order and padded the same way.
+    const std::vector<f32>& GetLookupPositionsX() const;
+    const std::vector<f32>& GetLookupPositionsY() const;
+    const std::vector<f32>& GetLookupPositionsZ() const;
+
+    u32 GetNodeCount() const;
+    const FluidSimOptions3D& GetOptions() const;
+private:
+    void FillCellIds(u32 range_begin, u32 range_end);
+    void FillLookupPositions();
+
+    bool NeighbourListsCoverMovement() const;
+    void BuildNeighbourLists();
+
+    glm::ivec3 ClampToGrid(glm::ivec3 cell_coords) const;
+    u32 GetCellId(glm::ivec3 cell_coords) const;
+    void HandleEdge(u32 node_idx);
+private:
+    FluidSimOptions3D m_options;
+
+    std::vector<glm::f32vec3> m_positions;
+    std::vector<f32> m_predictedX;
+    std::vector<f32> m_predictedY;
+    std::vector<f32> m_predictedZ;
+    std::vector<glm::f32vec3> m_velocities;
+    std::vector<f32> m_radii;
+    std::vector<f32> m_densities;
+    std::vector<f32> m_masses;
+    std::vector<glm::f32vec3> m_colors;
+
+    std::vector<u32> m_nodeIds;
+    // Indexed by id.
+    std::vector<u32> m_nodeIndices;
+
+    // Node indices sorted by cell, the nodes of a cell are m_cellLookup[m_cellOffsets[id], m_cellOffsets[id + 1]).
+    std::vector<u32> m_cellLookup;
+    std::vector<u32> m_cellOffsets;
+    std::vector<u32> m_nodeCellIds;
+    u32 m_cellCount{ 0 };
+    // Per range histograms for the parallel sort.
+    std::vector<u32> m_rangeCellCounts;
+
+    std::vector<f32> m_lookupPositionsX;
+    std::vector<f32> m_lookupPositionsY;
+    std::vector<f32> m_lookupPositionsZ;
+
+    std::vector<u32> m_neighbourOffsets;
+    std::vector<u32> m_neighbours;
+    // Predicted positions the lists were built from, to measure movement against the skin.
+    std::vector<glm::f32vec3> m_neighbourListPositions;
+    std::vector<std::vector<u32>> m_rangeNeighbours;
+    mutable std::vector<f32> m_rangeDisplacements;
+    bool m_neighbourListsValid{ false };
+
+    glm::ivec3 m_cells;
+
+    static constexpr u32 lookup_padding = FluidSimCore::lookup_padding;
+};
+
+#ifndef INC_FLUIDSIM_DATA_3D_INL
+#define INC_FLUIDSIM_DATA_3D_INL
+#include "FluidSimData3D.inl"
+#endif
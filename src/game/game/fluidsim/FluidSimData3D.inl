@@ -0,0 +1,40 @@
+#include "FluidSimData3D.h"
+
+inline u32 FluidSimData3D::GetCellId(glm::ivec3 cell_coords) const
+{
+    return u32_cast((cell_coords.z * m_cells.y + cell_coords.y) * m_cells.x + cell_coords.x);
+}
+
+inline glm::f32vec3 FluidSimData3D::GetNodePredictedPosition(u32 node_index) const
+{
+    return { m_predictedX[node_index], m_predictedY[node_index], m_predictedZ[node_index] };
+}
+
+template<typename Visitor>
+u32 FluidSimData3D::ForEachSpanInRadius(glm::f32vec3 sample_point, f32 radius, Visitor&& visitor) const
+{
+    if( !m_cellCount )
+        return 0;
+
+    glm::ivec3 min_cell = glm::max(GetCellCoordinates(sample_point - radius), 0);
+    glm::ivec3 max_cell = glm::min(GetCellCoordinates(sample_point + radius), m_cells - 1);
+    if( min_cell.x > max_cell.x )
+        return 0;
+
+    u32 candidate_count = 0;
+    for( i32 cell_z = min_cell.z; cell_z <= max_cell.z; cell_z++ )
+    {
+        for( i32 cell_y = min_cell.y; cell_y <= max_cell.y; cell_y++ )
+        {
+            u32 span_begin = m_cellOffsets[GetCellId({ min_cell.x, cell_y, cell_z })];
+            u32 span_end = m_cellOffsets[GetCellId({ max_cell.x, cell_y, cell_z }) + 1];
+            if( span_begin == span_end )
+                continue;
+
+            candidate_count += span_end - span_begin;
+            visitor(span_begin, span_end);
+        }
+    }
+
+    return candidate_count;
+}
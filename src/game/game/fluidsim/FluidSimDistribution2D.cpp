@@ -0,0 +1,127 @@
+#include "FluidSimDistribution2D.h"
+
+#include <random>
+
+namespace
+{
+
+f32 RandomUnit(std::minstd_rand& random)
+{
+    return f32_cast(random() - std::minstd_rand::min()) / f32_cast(std::minstd_rand::max() - std::minstd_rand::min());
+}
+
+FluidNodeInfo2D MakeNode(const FluidSimDistribution2D& distribution, glm::f32vec2 velocity)
+{
+    return
+    {
+        .velocity = velocity,
+        .node_radius = distribution.node_radius,
+        .density = 0.f,
+        .mass = 1.f,
+        .color = distribution.node_color
+    };
+}
+
+void DistributeNodesGrid(FluidSim2D& simulation, const FluidSimDistribution2D& distribution)
+{
+    const FluidSimOptions2D& options = simulation.GetOptions();
+    glm::vec2 centre{ options.extent.x / 2.f, options.extent.y / 2.f };
+    u32 side_length = u32_cast(std::ceil(std::sqrt(distribution.node_count)));
+
+    glm::vec2 offset
+    {
+        side_length * distribution.grid_spacing / 2.f,
+        side_length * distribution.grid_spacing / 2.f
+    };
+
+    for( u32 y = 0; y < side_length; y++ )
+    {
+        for( u32 x = 0; x < side_length; x++ )
+        {
+            if( (y * side_length) + x >= distribution.node_count )
+                break;
+
+            glm::vec2 local_position
+            {
+                x * distribution.grid_spacing,
+                y * distribution.grid_spacing
+            };
+
+            glm::f32vec2 position = centre - offset + local_position;
+            simulation.InsertNode(MakeNode(distribution, { 0.f, 0.f }), position);
+        }
+    }
+}
+
+void DistributeNodesCircular(FluidSim2D& simulation, const FluidSimDistribution2D& distribution, std::minstd_rand& random)
+{
+    const FluidSimOptions2D& options = simulation.GetOptions();
+    glm::vec2 centre{ options.extent.x / 2.f, options.extent.y / 2.f };
+
+    for( u32 idx = 0; idx < distribution.node_count; idx++ )
+    {
+        f32 rand_ang = RandomUnit(random) * 3.14159f * 2;
+        glm::vec2 rand_vec{ f32_cast(cos(rand_ang)), f32_cast(sin(rand_ang)) };
+
+        glm::f32vec2 position = centre + (rand_vec * distribution.circular_radius);
+        simulation.InsertNode(MakeNode(distribution, rand_vec * distribution.circular_velocity_scale), position);
+    }
+}
+
+void DistributeNodesPoint(FluidSim2D& simulation, const FluidSimDistribution2D& distribution, std::minstd_rand& random)
+{
+    const FluidSimOptions2D& options = simulation.GetOptions();
+    glm::vec2 centre{ options.extent.x / 2.f, options.extent.y / 2.f };
+
+    for( u32 idx = 0; idx < distribution.node_count; idx++ )
+    {
+        f32 rand_ang = RandomUnit(random) * 3.14159f * 2;
+        glm::vec2 rand_vec{ f32_cast(cos(rand_ang)), f32_cast(sin(rand_ang)) };
+
+        simulation.InsertNode(MakeNode(distribution, rand_vec * distribution.point_velocity_scale), centre);
+    }
+}
+
+void DistributeNodesRandom(FluidSim2D& simulation, const FluidSimDistribution2D& distribution, std::minstd_rand& random)
+{
+    const FluidSimOptions2D& options = simulation.GetOptions();
+    for( u32 idx = 0; idx < distribution.node_count; idx++ )
+    {
+        f32 rand0 = RandomUnit(random);
+        f32 rand1 = RandomUnit(random);
+
+        glm::f32vec2 position
+        {
+            options.extent.x * rand0,
+            options.extent.y * rand1
+        };
+
+        simulation.InsertNode(MakeNode(distribution, { 0.f, 0.f }), position);
+    }
+}
+
+} //
+
+void DistributeNodes(FluidSim2D& simulation, const FluidSimDistribution2D& distribution)
+{
+    // Our own generator rather than rand() so a seed gives the same nodes on every platform.
+    std::minstd_rand random(distribution.seed);
+
+    switch( distribution.technique )
+    {
+    case FluidSimDistributionTechnique2D::Grid:
+        DistributeNodesGrid(simulation, distribution);
+        break;
+    case FluidSimDistributionTechnique2D::Circular:
+        DistributeNodesCircular(simulation, distribution, random);
+        break;
+    case FluidSimDistributionTechnique2D::Point:
+        DistributeNodesPoint(simulation, distribution, random);
+        break;
+    case FluidSimDistributionTechnique2D::Random:
+        DistributeNodesRandom(simulation, distribution, random);
+        break;
+    }
+
+    simulation.FinishInserting();
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "FluidSim2D.h"
+
+enum class FluidSimDistributionTechnique2D
+{
+    Grid = 0,
+    Circular,
+    Point,
+    Random,
+};
+
+struct FluidSimDistribution2D
+{
+    FluidSimDistributionTechnique2D technique;
+    u32 node_count;
+    f32 node_radius;
+    glm::f32vec3 node_color;
+
+    // Grid
+    f32 grid_spacing;
+
+    // Circular
+    f32 circular_radius;
+    f32 circular_velocity_scale;
+
+    // Point
+    f32 point_velocity_scale;
+
+    // Circular, Point and Random, the same seed always gives the same nodes.
+    u32 seed;
+};
+
+// Inserts the nodes of the distribution, centred in the extent of the simulation, then finishes inserting.
+void DistributeNodes(FluidSim2D& simulation, const FluidSimDistribution2D& distribution);
@@ -0,0 +1,147 @@
+#include "FluidSimField2D.h"
+#include "FluidSimCore.h"
+#include "sim_channels.h"
+
+#include <numbers>
+
+FluidSimField2D::FluidSimField2D(const FluidSimFieldOptions2D& options) :
+    m_options(options)
+{
+    FLUIDSIM_ASSERT(options.resolution.x > 0 && options.resolution.y > 0, "The field needs at least one texel.");
+    FLUIDSIM_ASSERT(options.extent.x > 0.f && options.extent.y > 0.f, "The field needs to cover an area.");
+
+    m_texelSize = options.extent / glm::f32vec2(options.resolution);
+    m_inverseTexelSize = 1.f / m_texelSize;
+    m_splatRadius = std::max(options.splat_radius, glm::length(m_texelSize));
+    m_kernelScale = 3.f / (std::numbers::pi_v<f32> * m_splatRadius * m_splatRadius);
+
+    u32 texel_count = GetTexelCount();
+    m_densities.resize(texel_count);
+    m_velocities.resize(texel_count);
+    m_colors.resize(texel_count);
+
+    for( u32 idx = 0; idx < srgb_table_size; idx++ )
+    {
+        f32 linear = f32_cast(idx) / f32_cast(srgb_table_size - 1);
+        f32 encoded = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.f / 2.4f) - 0.055f;
+        m_srgbTable[idx] = u8_cast(encoded * 255.f + 0.5f);
+    }
+}
+
+void FluidSimField2D::Splat(std::span<const glm::f32vec4> positions, std::span<const FluidNodeInfo2D> infos)
+{
+    FLUIDSIM_ASSERT(positions.size() == infos.size(), "Every node needs a position and an info.");
+
+    u32 node_count = u32_cast(positions.size());
+    u32 texel_count = GetTexelCount();
+    u32 range_count = FluidSimCore::GetWorkerRangeCount(node_count, m_options.multithreaded);
+    m_rangeTexels.resize(u64_cast(range_count) * texel_count);
+
+    glm::ivec2 resolution = glm::ivec2(m_options.resolution);
+    f32 inverse_radius = 1.f / m_splatRadius;
+    glm::f32vec2 texel_radius = m_splatRadius * m_inverseTexelSize;
+    FluidSimCore::ForEachRange(node_count, range_count, [&](u32 range_begin, u32 range_end, u32 range_index)
+        {
+            Texel* range_texels = m_rangeTexels.data() + u64_cast(range_index) * texel_count;
+            std::fill(range_texels, range_texels + texel_count, Texel{ 0.f, { 0.f, 0.f }, { 0.f, 0.f, 0.f } });
+
+            for( u32 node_idx = range_begin; node_idx < range_end; node_idx++ )
+            {
+                // Texel centres sit half a texel in, so texel (x, y) is at lattice position (x, y).
+                glm::f32vec2 lattice_position = (glm::f32vec2(positions[node_idx]) - m_options.origin) * m_inverseTexelSize - 0.5f;
+                glm::ivec2 first = glm::max(glm::ivec2(glm::ceil(lattice_position - texel_radius)), glm::ivec2(0, 0));
+                glm::ivec2 last = glm::min(glm::ivec2(glm::floor(lattice_position + texel_radius)), resolution - 1);
+
+                const FluidNodeInfo2D& info = infos[node_idx];
+                f32 mass = info.mass * m_kernelScale;
+                for( i32 y = first.y; y <= last.y; y++ )
+                {
+                    for( i32 x = first.x; x <= last.x; x++ )
+                    {
+                        f32 distance = glm::length((glm::f32vec2(f32_cast(x), f32_cast(y)) - lattice_position) * m_texelSize);
+                        f32 weight = mass * (1.f - distance * inverse_radius);
+                        if( weight <= 0.f )
+                            continue;
+
+                        Texel& texel = range_texels[y * resolution.x + x];
+                        texel.density += weight;
+                        texel.momentum += info.velocity * weight;
+                        texel.color += info.color * weight;
+                    }
+                }
+            }
+        });
+
+    FluidSimCore::ForEachRange(texel_count, FluidSimCore::GetRangeCount(texel_count, m_options.multithreaded),
+        [&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u32 texel_idx = range_begin; texel_idx < range_end; texel_idx++ )
+            {
+                Texel sum{ 0.f, { 0.f, 0.f }, { 0.f, 0.f, 0.f } };
+                for( u32 range_idx = 0; range_idx < range_count; range_idx++ )
+                {
+                    const Texel& texel = m_rangeTexels[u64_cast(range_idx) * texel_count + texel_idx];
+                    sum.density += texel.density;
+                    sum.momentum += texel.momentum;
+                    sum.color += texel.color;
+                }
+
+                f32 inverse_density = sum.density > 0.f ? 1.f / sum.density : 0.f;
+                m_densities[texel_idx] = sum.density;
+                m_velocities[texel_idx] = sum.momentum * inverse_density;
+                m_colors[texel_idx] = sum.color * inverse_density;
+            }
+        });
+}
+
+void FluidSimField2D::Shade(const FluidSimFieldShadingOptions2D& shading, std::span<u8> pixels) const
+{
+    FLUIDSIM_ASSERT(pixels.size() == u64_cast(GetTexelCount()) * 4, "Shade needs 4 bytes per texel.");
+
+    u32 width = m_options.resolution.x;
+    u32 height = m_options.resolution.y;
+    f32 value_range = std::max(shading.max_value - shading.min_value, 1e-6f);
+    u32 range_count = std::min(FluidSimCore::GetRangeCount(GetTexelCount(), m_options.multithreaded), height);
+    FluidSimCore::ForEachRange(height, range_count, [&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u32 row = range_begin; row < range_end; row++ )
+            {
+                u8* row_pixels = pixels.data() + u64_cast(height - 1 - row) * width * 4;
+                for( u32 x = 0; x < width; x++ )
+                {
+                    u32 texel_idx = row * width + x;
+                    f32 density = m_densities[texel_idx];
+                    glm::f32vec3 color = shading.background_color;
+                    if( density > 0.f )
+                    {
+                        glm::f32vec3 fluid_color = m_colors[texel_idx];
+                        if( shading.shading != FluidSimFieldShading2D::NodeColor )
+                        {
+                            f32 value = shading.shading == FluidSimFieldShading2D::Density ? density : glm::length(m_velocities[texel_idx]);
+                            f32 t = glm::clamp((value - shading.min_value) / value_range, 0.f, 1.f);
+                            fluid_color = glm::mix(shading.min_color, shading.max_color, t);
+                        }
+
+                        f32 coverage = shading.surface_density > 0.f ? std::min(density / shading.surface_density, 1.f) : 1.f;
+                        color = glm::mix(shading.background_color, fluid_color, coverage);
+                    }
+
+                    glm::uvec3 table_idx = glm::uvec3(glm::clamp(color, 0.f, 1.f) * f32_cast(srgb_table_size - 1) + 0.5f);
+                    row_pixels[x * 4 + 0] = m_srgbTable[table_idx.r];
+                    row_pixels[x * 4 + 1] = m_srgbTable[table_idx.g];
+                    row_pixels[x * 4 + 2] = m_srgbTable[table_idx.b];
+                    row_pixels[x * 4 + 3] = 255;
+                }
+            }
+        });
+}
+
+const FluidSimFieldOptions2D& FluidSimField2D::GetOptions() const
+{
+    return m_options;
+}
+
+u32 FluidSimField2D::GetTexelCount() const
+{
+    return m_options.resolution.x * m_options.resolution.y;
+}
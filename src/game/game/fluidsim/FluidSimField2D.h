@@ -0,0 +1,86 @@
+#pragma once
+#include "FluidSimData2D.h"
+
+#include <array>
+#include <span>
+
+enum class FluidSimFieldShading2D : u32
+{
+    // Mass weighted average of the node colours, so whatever the debug colours painted shows through.
+    NodeColor = 0,
+    Density,
+    Speed,
+};
+
+struct FluidSimFieldOptions2D
+{
+    // Texels of the field. Shading and drawing it costs the same however many nodes there are.
+    glm::uvec2 resolution;
+    // Region of the simulation the field covers.
+    glm::f32vec2 origin;
+    glm::f32vec2 extent;
+    // Each node spreads its mass over a cone of this radius, never less than a texel.
+    f32 splat_radius;
+    bool multithreaded;
+};
+
+struct FluidSimFieldShadingOptions2D
+{
+    FluidSimFieldShading2D shading;
+    // Density or speed from min_value to max_value maps from min_color to max_color.
+    f32 min_value;
+    f32 max_value;
+    glm::f32vec3 min_color;
+    glm::f32vec3 max_color;
+    glm::f32vec3 background_color;
+    // Texels fade into the background below this density, 0 draws every texel a node reached at full strength.
+    f32 surface_density;
+};
+
+// Fixed resolution density and velocity field splatted from the nodes, for drawing the fluid as one texture instead
+// of a quad per node. Splatting is the only part that scales with the node count and runs without a window, so
+// the shaded pixels can also be written out headless, see fluidbench -field_image.
+class FluidSimField2D
+{
+public:
+    FluidSimField2D(const FluidSimFieldOptions2D& options);
+    ~FluidSimField2D() = default;
+
+    // Positions as FluidSim2D stores them and infos as WriteNodeInfos writes them, so either a simulation or a
+    // published FluidSimFrame2D can be splatted. Each worker range splats into a field of its own and those are
+    // then summed texel by texel, so nothing is written by two workers.
+    void Splat(std::span<const glm::f32vec4> positions, std::span<const FluidNodeInfo2D> infos);
+    // sRGB encoded R8G8B8A8 pixels, 4 bytes per texel, the colours being linear like the node colours are. The first
+    // row is the top of the region as images and textures expect.
+    void Shade(const FluidSimFieldShadingOptions2D& shading, std::span<u8> pixels) const;
+
+    const FluidSimFieldOptions2D& GetOptions() const;
+    u32 GetTexelCount() const;
+private:
+    // Sums of the mass weighted kernel, and of it times the velocity and colour.
+    struct Texel
+    {
+        f32 density;
+        glm::f32vec2 momentum;
+        glm::f32vec3 color;
+    };
+private:
+    static constexpr u32 srgb_table_size = 4096;
+
+    FluidSimFieldOptions2D m_options;
+    glm::f32vec2 m_texelSize;
+    glm::f32vec2 m_inverseTexelSize;
+    f32 m_splatRadius;
+    // Normalises the cone to integrate to 1, so the summed splats are a mass per area.
+    f32 m_kernelScale;
+
+    // Per texel, rows from the bottom of the region up.
+    std::vector<f32> m_densities;
+    std::vector<glm::f32vec2> m_velocities;
+    std::vector<glm::f32vec3> m_colors;
+    // Linear [0, 1] to sRGB bytes.
+    std::array<u8, srgb_table_size> m_srgbTable;
+
+    // Laid out [range][texel].
+    std::vector<Texel> m_rangeTexels;
+};
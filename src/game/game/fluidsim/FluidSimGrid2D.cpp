@@ -0,0 +1,597 @@
+#include "FluidSimGrid2D.h"
+#include "sim_channels.h"
+
+FluidSimGrid2D::FluidSimGrid2D(const FluidSimOptions2D& options) :
+    m_options(options)
+{
+    FLUIDSIM_ASSERT(options.extent.x > 0.f && options.extent.y > 0.f, "The grid solver needs a bounded extent.");
+
+    // At least two cells a side so every lattice has a pair of samples to interpolate between.
+    m_cells = glm::max(glm::ivec2(glm::ceil(options.extent / options.grid_extent)), glm::ivec2(2, 2));
+    m_cellSize = options.extent / glm::f32vec2(m_cells);
+    m_inverseCellSize = 1.f / m_cellSize;
+    m_uSize = m_cells + glm::ivec2(1, 0);
+    m_vSize = m_cells + glm::ivec2(0, 1);
+
+    u32 u_count = u32_cast(m_uSize.x * m_uSize.y);
+    u32 v_count = u32_cast(m_vSize.x * m_vSize.y);
+    u32 cell_count = u32_cast(m_cells.x * m_cells.y);
+    m_u.resize(u_count);
+    m_v.resize(v_count);
+    m_knownU.resize(u_count);
+    m_knownV.resize(v_count);
+    m_cellMasses.resize(cell_count);
+    m_pressure.resize(cell_count);
+    m_search.resize(cell_count);
+    m_searchProduct.resize(cell_count);
+
+    glm::ivec2 level_cells = m_cells;
+    glm::f32vec2 level_scale = m_inverseCellSize * m_inverseCellSize;
+    for( ;; )
+    {
+        FluidSimGridLevel2D& level = m_levels.emplace_back();
+        level.cells = level_cells;
+        level.scale = level_scale;
+
+        u32 level_count = u32_cast(level_cells.x * level_cells.y);
+        level.fluid_cells.resize(level_count);
+        level.diagonal.resize(level_count);
+        level.right_side.resize(level_count);
+        level.solution.resize(level_count);
+        level.scratch.resize(level_count);
+        for( u32 cell_idx = 0; cell_idx < level_count; cell_idx++ )
+        {
+            // Walls lie outside the grid, air neighbours count towards the diagonal at zero pressure.
+            i32 x = i32_cast(cell_idx % level_cells.x);
+            i32 y = i32_cast(cell_idx / level_cells.x);
+            level.diagonal[cell_idx] = level_scale.x * f32_cast((x > 0) + (x < level_cells.x - 1))
+                + level_scale.y * f32_cast((y > 0) + (y < level_cells.y - 1));
+        }
+
+        if( glm::min(level_cells.x, level_cells.y) < min_coarse_cells * 2 )
+            break;
+
+        level_cells = (level_cells + 1) / 2;
+        level_scale *= coarse_scale;
+    }
+}
+
+template<typename Function>
+glm::f64vec2 FluidSimGrid2D::ReduceCells(Function&& function)
+{
+    u32 cell_count = u32_cast(m_pressure.size());
+    u32 range_count = GetRangeCount(cell_count);
+    m_rangeReductions.resize(range_count);
+    ForEachRange(cell_count, range_count, [&](u32 range_begin, u32 range_end, u32 range_index)
+        {
+            m_rangeReductions[range_index] = function(range_begin, range_end);
+        });
+
+    glm::f64vec2 result{ 0.0, 0.0 };
+    for( const glm::f64vec2& reduction : m_rangeReductions )
+    {
+        result.x += reduction.x;
+        result.y = std::max(result.y, reduction.y);
+    }
+
+    return result;
+}
+
+void FluidSimGrid2D::TransferToGrid(const FluidSimData2D& data)
+{
+    u32 u_count = u32_cast(m_u.size());
+    u32 v_count = u32_cast(m_v.size());
+    u32 cell_count = u32_cast(m_cellMasses.size());
+    u32 range_count = GetSplatRangeCount(data.GetNodeCount());
+    m_rangeU.resize(u64_cast(range_count) * u_count);
+    m_rangeV.resize(u64_cast(range_count) * v_count);
+    m_rangeCellMasses.resize(u64_cast(range_count) * cell_count);
+    m_rangeFluidCells.resize(u64_cast(range_count) * cell_count);
+
+    const std::vector<glm::f32vec4>& positions = data.GetNodePositions();
+    const std::vector<glm::f32vec2>& velocities = data.GetNodeVelocities();
+    const std::vector<f32>& masses = data.GetNodeMasses();
+    ForEachRange(data.GetNodeCount(), range_count, [&](u32 range_begin, u32 range_end, u32 range_index)
+        {
+            glm::f32vec2* range_u = m_rangeU.data() + u64_cast(range_index) * u_count;
+            glm::f32vec2* range_v = m_rangeV.data() + u64_cast(range_index) * v_count;
+            f32* range_masses = m_rangeCellMasses.data() + u64_cast(range_index) * cell_count;
+            u8* range_fluid = m_rangeFluidCells.data() + u64_cast(range_index) * cell_count;
+            std::fill(range_u, range_u + u_count, glm::f32vec2(0.f, 0.f));
+            std::fill(range_v, range_v + v_count, glm::f32vec2(0.f, 0.f));
+            std::fill(range_masses, range_masses + cell_count, 0.f);
+            std::fill(range_fluid, range_fluid + cell_count, u8(0));
+
+            for( u32 node_idx = range_begin; node_idx < range_end; node_idx++ )
+            {
+                glm::f32vec2 lattice_position = glm::f32vec2(positions[node_idx]) * m_inverseCellSize;
+                f32 mass = masses[node_idx];
+                glm::f32vec2 momentum = velocities[node_idx] * mass;
+
+                FluidSimGridStencil2D u_stencil = GetStencil(lattice_position - glm::f32vec2(0.f, 0.5f), m_uSize);
+                FluidSimGridStencil2D v_stencil = GetStencil(lattice_position - glm::f32vec2(0.5f, 0.f), m_vSize);
+                FluidSimGridStencil2D cell_stencil = GetStencil(lattice_position - glm::f32vec2(0.5f, 0.5f), m_cells);
+                for( u32 idx = 0; idx < 4; idx++ )
+                {
+                    range_u[u_stencil.indices[idx]] += glm::f32vec2(momentum.x, mass) * u_stencil.weights[idx];
+                    range_v[v_stencil.indices[idx]] += glm::f32vec2(momentum.y, mass) * v_stencil.weights[idx];
+                    range_masses[cell_stencil.indices[idx]] += mass * cell_stencil.weights[idx];
+                }
+
+                glm::ivec2 cell = glm::clamp(glm::ivec2(glm::floor(lattice_position)), glm::ivec2(0, 0), m_cells - 1);
+                range_fluid[GetCellIndex(cell.x, cell.y)] = 1;
+            }
+        });
+
+    // Faces on the domain edges are walls, nothing flows through them.
+    auto gather_faces = [&](const std::vector<glm::f32vec2>& range_faces, std::vector<f32>& faces, std::vector<u8>& known,
+        glm::ivec2 lattice_size, bool vertical)
+        {
+            u32 face_count = u32_cast(faces.size());
+            ForEachRange(face_count, GetRangeCount(face_count),
+                [&](u32 range_begin, u32 range_end, u32)
+                {
+                    for( u32 face_idx = range_begin; face_idx < range_end; face_idx++ )
+                    {
+                        glm::f32vec2 sum{ 0.f, 0.f };
+                        for( u32 range_idx = 0; range_idx < range_count; range_idx++ )
+                        {
+                            sum += range_faces[u64_cast(range_idx) * face_count + face_idx];
+                        }
+
+                        i32 edge_coord = vertical ? i32_cast(face_idx % lattice_size.x) : i32_cast(face_idx / lattice_size.x);
+                        i32 edge_size = vertical ? lattice_size.x : lattice_size.y;
+                        bool wall = edge_coord == 0 || edge_coord == edge_size - 1;
+                        faces[face_idx] = sum.y > 0.f && !wall ? sum.x / sum.y : 0.f;
+                        known[face_idx] = sum.y > 0.f || wall ? 1 : 0;
+                    }
+                });
+        };
+
+    gather_faces(m_rangeU, m_u, m_knownU, m_uSize, true);
+    gather_faces(m_rangeV, m_v, m_knownV, m_vSize, false);
+
+    m_fluidCellCount = u32_cast(ReduceCells([&](u32 range_begin, u32 range_end)
+        {
+            f64 fluid_cells = 0.0;
+            for( u32 cell_idx = range_begin; cell_idx < range_end; cell_idx++ )
+            {
+                f32 mass = 0.f;
+                u8 fluid = 0;
+                for( u32 range_idx = 0; range_idx < range_count; range_idx++ )
+                {
+                    mass += m_rangeCellMasses[u64_cast(range_idx) * cell_count + cell_idx];
+                    fluid |= m_rangeFluidCells[u64_cast(range_idx) * cell_count + cell_idx];
+                }
+
+                m_cellMasses[cell_idx] = mass;
+                m_levels[0].fluid_cells[cell_idx] = fluid;
+                fluid_cells += fluid;
+            }
+
+            return glm::f64vec2(fluid_cells, 0.0);
+        }).x);
+
+    // Nodes near the surface interpolate from faces no node reached.
+    ExtrapolateVelocities(m_u, m_knownU, m_uSize);
+    ExtrapolateVelocities(m_v, m_knownV, m_vSize);
+
+    m_previousU = m_u;
+    m_previousV = m_v;
+}
+
+void FluidSimGrid2D::ExtrapolateVelocities(std::vector<f32>& velocities, std::vector<u8>& known, glm::ivec2 lattice_size)
+{
+    u32 face_count = u32_cast(velocities.size());
+    for( u32 layer = 0; layer < extrapolation_layers; layer++ )
+    {
+        // Only faces known before this layer are read, and only unknown ones are written.
+        m_extrapolateKnown = known;
+        ForEachRange(face_count, GetRangeCount(face_count),
+            [&](u32 range_begin, u32 range_end, u32)
+            {
+                for( u32 face_idx = range_begin; face_idx < range_end; face_idx++ )
+                {
+                    if( m_extrapolateKnown[face_idx] )
+                        continue;
+
+                    i32 x = i32_cast(face_idx % lattice_size.x);
+                    i32 y = i32_cast(face_idx / lattice_size.x);
+                    f32 sum = 0.f;
+                    u32 count = 0;
+                    auto gather = [&](i32 other_x, i32 other_y)
+                        {
+                            if( other_x < 0 || other_y < 0 || other_x >= lattice_size.x || other_y >= lattice_size.y )
+                                return;
+
+                            u32 other_idx = u32_cast(other_y * lattice_size.x + other_x);
+                            if( !m_extrapolateKnown[other_idx] )
+                                return;
+
+                            sum += velocities[other_idx];
+                            count++;
+                        };
+
+                    gather(x - 1, y);
+                    gather(x + 1, y);
+                    gather(x, y - 1);
+                    gather(x, y + 1);
+                    if( count )
+                    {
+                        velocities[face_idx] = sum / f32_cast(count);
+                        known[face_idx] = 1;
+                    }
+                }
+            });
+    }
+}
+
+void FluidSimGrid2D::Project()
+{
+    // With phi = pressure * delta_time / density the velocity update is -grad phi, so the new velocity is divergence
+    // free when laplacian phi = div u. Solved as A phi = -div u with A the negated laplacian over the fluid cells.
+    // The finest level's right side holds the residual and a V-cycle over the levels preconditions it into its solution.
+    FluidSimGridLevel2D& finest = m_levels[0];
+    f64 initial_divergence = ReduceCells([&](u32 range_begin, u32 range_end)
+        {
+            f64 max_divergence = 0.0;
+            for( u32 cell_idx = range_begin; cell_idx < range_end; cell_idx++ )
+            {
+                m_pressure[cell_idx] = 0.f;
+                if( !finest.fluid_cells[cell_idx] )
+                {
+                    finest.right_side[cell_idx] = 0.f;
+                    continue;
+                }
+
+                i32 x = i32_cast(cell_idx % m_cells.x);
+                i32 y = i32_cast(cell_idx / m_cells.x);
+                f32 divergence = (m_u[y * m_uSize.x + x + 1] - m_u[y * m_uSize.x + x]) * m_inverseCellSize.x
+                    + (m_v[(y + 1) * m_vSize.x + x] - m_v[y * m_vSize.x + x]) * m_inverseCellSize.y;
+                finest.right_side[cell_idx] = -divergence;
+                max_divergence = std::max(max_divergence, f64_cast(std::abs(divergence)));
+            }
+
+            return glm::f64vec2(0.0, max_divergence);
+        }).y;
+
+    CoarsenFluidCells();
+
+    u32 cell_count = u32_cast(m_pressure.size());
+    f64 tolerance = initial_divergence * m_options.flip_pressure_tolerance;
+    f64 max_residual = initial_divergence;
+    f64 residual_dot = 0.0;
+    m_pressureIterations = 0;
+    while( max_residual > tolerance && m_pressureIterations < m_options.flip_pressure_iterations )
+    {
+        VCycle(0);
+        f64 next_residual_dot = ReduceCells([&](u32 range_begin, u32 range_end)
+            {
+                f64 dot = 0.0;
+                for( u32 cell_idx = range_begin; cell_idx < range_end; cell_idx++ )
+                {
+                    dot += f64_cast(finest.right_side[cell_idx]) * finest.solution[cell_idx];
+                }
+
+                return glm::f64vec2(dot, 0.0);
+            }).x;
+
+        // The first search direction is the preconditioned residual itself.
+        f32 beta = m_pressureIterations ? f32_cast(next_residual_dot / residual_dot) : 0.f;
+        residual_dot = next_residual_dot;
+        ForEachRange(cell_count, GetRangeCount(cell_count), [&](u32 range_begin, u32 range_end, u32)
+            {
+                for( u32 cell_idx = range_begin; cell_idx < range_end; cell_idx++ )
+                {
+                    m_search[cell_idx] = finest.solution[cell_idx] + beta * m_search[cell_idx];
+                }
+            });
+
+        f64 search_dot = ReduceCells([&](u32 range_begin, u32 range_end)
+            {
+                f64 dot = 0.0;
+                for( u32 cell_idx = range_begin; cell_idx < range_end; cell_idx++ )
+                {
+                    f32 product = finest.fluid_cells[cell_idx] ? ApplyLaplacian(finest, m_search, cell_idx) : 0.f;
+                    m_searchProduct[cell_idx] = product;
+                    dot += f64_cast(m_search[cell_idx]) * product;
+                }
+
+                return glm::f64vec2(dot, 0.0);
+            }).x;
+
+        if( search_dot <= 0.0 )
+            break;
+
+        f32 alpha = f32_cast(residual_dot / search_dot);
+        max_residual = ReduceCells([&](u32 range_begin, u32 range_end)
+            {
+                f64 max_abs = 0.0;
+                for( u32 cell_idx = range_begin; cell_idx < range_end; cell_idx++ )
+                {
+                    m_pressure[cell_idx] += alpha * m_search[cell_idx];
+                    finest.right_side[cell_idx] -= alpha * m_searchProduct[cell_idx];
+                    max_abs = std::max(max_abs, f64_cast(std::abs(finest.right_side[cell_idx])));
+                }
+
+                return glm::f64vec2(0.0, max_abs);
+            }).y;
+
+        m_pressureIterations++;
+    }
+
+    m_pressureResidual = initial_divergence > 0.0 ? f32_cast(max_residual / initial_divergence) : 0.f;
+    ApplyPressureGradient();
+}
+
+void FluidSimGrid2D::CoarsenFluidCells()
+{
+    for( u64 level_idx = 1; level_idx < m_levels.size(); level_idx++ )
+    {
+        const FluidSimGridLevel2D& fine = m_levels[level_idx - 1];
+        FluidSimGridLevel2D& coarse = m_levels[level_idx];
+        u32 cell_count = u32_cast(coarse.fluid_cells.size());
+        ForEachRange(cell_count, GetRangeCount(cell_count), [&](u32 range_begin, u32 range_end, u32)
+            {
+                for( u32 cell_idx = range_begin; cell_idx < range_end; cell_idx++ )
+                {
+                    // Fluid only when every fine cell is, so air boundaries never get coarser than they are.
+                    glm::ivec2 base = glm::ivec2(i32_cast(cell_idx % coarse.cells.x), i32_cast(cell_idx / coarse.cells.x)) * 2;
+                    glm::ivec2 end = glm::min(base + 2, fine.cells);
+                    u8 fluid = 1;
+                    for( i32 y = base.y; y < end.y; y++ )
+                    {
+                        for( i32 x = base.x; x < end.x; x++ )
+                        {
+                            fluid &= fine.fluid_cells[y * fine.cells.x + x];
+                        }
+                    }
+
+                    coarse.fluid_cells[cell_idx] = fluid;
+                }
+            });
+    }
+}
+
+void FluidSimGrid2D::VCycle(u32 level_idx)
+{
+    FluidSimGridLevel2D& level = m_levels[level_idx];
+    if( level_idx + 1 == m_levels.size() )
+    {
+        Smooth(level, coarsest_iterations, true);
+        return;
+    }
+
+    // The same sweeps before and after keep the preconditioner symmetric, as conjugate gradient needs.
+    Smooth(level, smoothing_iterations, true);
+
+    FluidSimGridLevel2D& coarse = m_levels[level_idx + 1];
+    u32 coarse_count = u32_cast(coarse.fluid_cells.size());
+    ForEachRange(coarse_count, GetRangeCount(coarse_count), [&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u32 cell_idx = range_begin; cell_idx < range_end; cell_idx++ )
+            {
+                if( !coarse.fluid_cells[cell_idx] )
+                {
+                    coarse.right_side[cell_idx] = 0.f;
+                    continue;
+                }
+
+                glm::ivec2 base = glm::ivec2(i32_cast(cell_idx % coarse.cells.x), i32_cast(cell_idx / coarse.cells.x)) * 2;
+                glm::ivec2 end = glm::min(base + 2, level.cells);
+                f32 residual = 0.f;
+                for( i32 y = base.y; y < end.y; y++ )
+                {
+                    for( i32 x = base.x; x < end.x; x++ )
+                    {
+                        u32 fine_idx = u32_cast(y * level.cells.x + x);
+                        residual += level.right_side[fine_idx] - ApplyLaplacian(level, level.solution, fine_idx);
+                    }
+                }
+
+                coarse.right_side[cell_idx] = residual * 0.25f;
+            }
+        });
+
+    VCycle(level_idx + 1);
+
+    u32 cell_count = u32_cast(level.fluid_cells.size());
+    ForEachRange(cell_count, GetRangeCount(cell_count), [&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u32 cell_idx = range_begin; cell_idx < range_end; cell_idx++ )
+            {
+                if( !level.fluid_cells[cell_idx] )
+                    continue;
+
+                i32 x = i32_cast(cell_idx % level.cells.x);
+                i32 y = i32_cast(cell_idx / level.cells.x);
+                level.solution[cell_idx] += coarse.solution[(y / 2) * coarse.cells.x + x / 2];
+            }
+        });
+
+    Smooth(level, smoothing_iterations, false);
+}
+
+void FluidSimGrid2D::Smooth(FluidSimGridLevel2D& level, u32 iterations, bool from_zero)
+{
+    u32 cell_count = u32_cast(level.fluid_cells.size());
+    for( u32 iteration = 0; iteration < iterations; iteration++ )
+    {
+        // Damped Jacobi, every cell reads the previous sweep's values so the ranges can run in parallel.
+        bool zero_solution = from_zero && iteration == 0;
+        ForEachRange(cell_count, GetRangeCount(cell_count), [&](u32 range_begin, u32 range_end, u32)
+            {
+                for( u32 cell_idx = range_begin; cell_idx < range_end; cell_idx++ )
+                {
+                    if( !level.fluid_cells[cell_idx] )
+                    {
+                        level.scratch[cell_idx] = 0.f;
+                        continue;
+                    }
+
+                    f32 solution = zero_solution ? 0.f : level.solution[cell_idx];
+                    f32 residual = level.right_side[cell_idx] - (zero_solution ? 0.f : ApplyLaplacian(level, level.solution, cell_idx));
+                    level.scratch[cell_idx] = solution + jacobi_weight * residual / level.diagonal[cell_idx];
+                }
+            });
+
+        level.solution.swap(level.scratch);
+    }
+}
+
+f32 FluidSimGrid2D::ApplyLaplacian(const FluidSimGridLevel2D& level, const std::vector<f32>& values, u32 cell_idx)
+{
+    // Values outside the fluid are zero, so air neighbours drop out.
+    i32 x = i32_cast(cell_idx % level.cells.x);
+    i32 y = i32_cast(cell_idx / level.cells.x);
+    f32 neighbours_x = (x > 0 ? values[cell_idx - 1] : 0.f) + (x < level.cells.x - 1 ? values[cell_idx + 1] : 0.f);
+    f32 neighbours_y = (y > 0 ? values[cell_idx - level.cells.x] : 0.f) + (y < level.cells.y - 1 ? values[cell_idx + level.cells.x] : 0.f);
+    return level.diagonal[cell_idx] * values[cell_idx] - level.scale.x * neighbours_x - level.scale.y * neighbours_y;
+}
+
+void FluidSimGrid2D::ApplyPressureGradient()
+{
+    // Faces between two air cells keep their extrapolated velocity, wall faces stay at zero.
+    u32 u_count = u32_cast(m_u.size());
+    ForEachRange(u_count, GetRangeCount(u_count),
+        [&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u32 face_idx = range_begin; face_idx < range_end; face_idx++ )
+            {
+                i32 x = i32_cast(face_idx % m_uSize.x);
+                i32 y = i32_cast(face_idx / m_uSize.x);
+                if( x == 0 || x == m_cells.x || (!IsFluid(x - 1, y) && !IsFluid(x, y)) )
+                    continue;
+
+                m_u[face_idx] -= (m_pressure[GetCellIndex(x, y)] - m_pressure[GetCellIndex(x - 1, y)]) * m_inverseCellSize.x;
+            }
+        });
+
+    u32 v_count = u32_cast(m_v.size());
+    ForEachRange(v_count, GetRangeCount(v_count),
+        [&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u32 face_idx = range_begin; face_idx < range_end; face_idx++ )
+            {
+                i32 x = i32_cast(face_idx % m_vSize.x);
+                i32 y = i32_cast(face_idx / m_vSize.x);
+                if( y == 0 || y == m_cells.y || (!IsFluid(x, y - 1) && !IsFluid(x, y)) )
+                    continue;
+
+                m_v[face_idx] -= (m_pressure[GetCellIndex(x, y)] - m_pressure[GetCellIndex(x, y - 1)]) * m_inverseCellSize.y;
+            }
+        });
+}
+
+void FluidSimGrid2D::TransferToNodes(FluidSimData2D& data) const
+{
+    const std::vector<glm::f32vec4>& positions = data.GetNodePositions();
+    std::vector<glm::f32vec2>& velocities = data.GetNodeVelocities();
+    std::vector<f32>& densities = data.GetNodeDensities();
+    f32 flip_ratio = m_options.flip_ratio;
+    f32 inverse_cell_area = m_inverseCellSize.x * m_inverseCellSize.y;
+    data.ForEachNodeRange([&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u32 node_idx = range_begin; node_idx < range_end; node_idx++ )
+            {
+                glm::f32vec2 lattice_position = glm::f32vec2(positions[node_idx]) * m_inverseCellSize;
+                FluidSimGridStencil2D u_stencil = GetStencil(lattice_position - glm::f32vec2(0.f, 0.5f), m_uSize);
+                FluidSimGridStencil2D v_stencil = GetStencil(lattice_position - glm::f32vec2(0.5f, 0.f), m_vSize);
+                FluidSimGridStencil2D cell_stencil = GetStencil(lattice_position - glm::f32vec2(0.5f, 0.5f), m_cells);
+
+                glm::f32vec2 grid_velocity{ Sample(m_u, u_stencil), Sample(m_v, v_stencil) };
+                glm::f32vec2 previous_velocity{ Sample(m_previousU, u_stencil), Sample(m_previousV, v_stencil) };
+                velocities[node_idx] = grid_velocity + (velocities[node_idx] - previous_velocity) * flip_ratio;
+                densities[node_idx] = Sample(m_cellMasses, cell_stencil) * inverse_cell_area;
+            }
+        });
+}
+
+glm::ivec2 FluidSimGrid2D::GetCellCount() const
+{
+    return m_cells;
+}
+
+glm::f32vec2 FluidSimGrid2D::GetCellSize() const
+{
+    return m_cellSize;
+}
+
+u32 FluidSimGrid2D::GetFluidCellCount() const
+{
+    return m_fluidCellCount;
+}
+
+u32 FluidSimGrid2D::GetPressureIterations() const
+{
+    return m_pressureIterations;
+}
+
+f32 FluidSimGrid2D::GetPressureResidual() const
+{
+    return m_pressureResidual;
+}
+
+FluidSimGridStencil2D FluidSimGrid2D::GetStencil(glm::f32vec2 lattice_position, glm::ivec2 lattice_size)
+{
+    glm::f32vec2 clamped = glm::clamp(lattice_position, glm::f32vec2(0.f, 0.f), glm::f32vec2(lattice_size - 1));
+    glm::ivec2 base = glm::min(glm::ivec2(clamped), lattice_size - 2);
+    glm::f32vec2 fraction = clamped - glm::f32vec2(base);
+
+    u32 index = u32_cast(base.y * lattice_size.x + base.x);
+    u32 row = u32_cast(lattice_size.x);
+    return
+    {
+        { index, index + 1, index + row, index + row + 1 },
+        {
+            (1.f - fraction.x) * (1.f - fraction.y),
+            fraction.x * (1.f - fraction.y),
+            (1.f - fraction.x) * fraction.y,
+            fraction.x * fraction.y,
+        },
+    };
+}
+
+void FluidSimGrid2D::ForEachRange(u32 count, u32 range_count, const FluidSimCore::ForEachRangeFunc& function) const
+{
+    if( m_options.multithreaded )
+    {
+        FluidSimCore::ForEachRange(count, range_count, function);
+        return;
+    }
+
+    // The same boundaries FluidSimCore::ForEachRange gives each range.
+    for( u32 range_idx = 0; range_idx < range_count; range_idx++ )
+    {
+        u32 range_begin = u32_cast((u64_cast(count) * range_idx) / range_count);
+        u32 range_end = u32_cast((u64_cast(count) * (range_idx + 1)) / range_count);
+        function(range_begin, range_end, range_idx);
+    }
+}
+
+u32 FluidSimGrid2D::GetRangeCount(u32 count)
+{
+    return std::max(1u, (count + min_range_size - 1) / min_range_size);
+}
+
+u32 FluidSimGrid2D::GetSplatRangeCount(u32 node_count)
+{
+    u32 wanted_ranges = (node_count + FluidSimCore::min_range_size - 1) / FluidSimCore::min_range_size;
+    return std::max(1u, std::min(splat_ranges, wanted_ranges));
+}
+
+u32 FluidSimGrid2D::GetCellIndex(i32 x, i32 y) const
+{
+    return u32_cast(y * m_cells.x + x);
+}
+
+bool FluidSimGrid2D::IsFluid(i32 x, i32 y) const
+{
+    return m_levels[0].fluid_cells[GetCellIndex(x, y)] != 0;
+}
+
+f32 FluidSimGrid2D::Sample(const std::vector<f32>& values, const FluidSimGridStencil2D& stencil)
+{
+    return values[stencil.indices[0]] * stencil.weights[0] + values[stencil.indices[1]] * stencil.weights[1]
+        + values[stencil.indices[2]] * stencil.weights[2] + values[stencil.indices[3]] * stencil.weights[3];
+}
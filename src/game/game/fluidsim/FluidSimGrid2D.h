@@ -0,0 +1,134 @@
+#pragma once
+#include "FluidSimData2D.h"
+
+// Bilinear weights of a sample on a lattice of samples one cell apart, see FluidSimGrid2D::GetStencil.
+struct FluidSimGridStencil2D
+{
+    u32 indices[4];
+    f32 weights[4];
+};
+
+// One level of the multigrid preconditioner, the first being the grid itself and each further one half as many
+// cells a side.
+struct FluidSimGridLevel2D
+{
+    glm::ivec2 cells;
+    // Weight of a neighbour in the negated laplacian, the inverse cell size squared on the finest level.
+    glm::f32vec2 scale;
+    std::vector<u8> fluid_cells;
+    std::vector<f32> diagonal;
+    std::vector<f32> right_side;
+    std::vector<f32> solution;
+    // Jacobi sweeps write here and swap it with the solution.
+    std::vector<f32> scratch;
+};
+
+// Marker and cell grid of the FLIP solver, see FluidSimSolver2D::Flip. Covers the extent with cells as close to
+// grid_extent as divide it evenly. Velocities live on the cell faces, u on the vertical faces and v on the horizontal
+// ones, pressure at the cell centres. Cells holding a node are fluid, the rest are air and the domain edges are walls.
+class FluidSimGrid2D
+{
+public:
+    FluidSimGrid2D(const FluidSimOptions2D& options);
+    ~FluidSimGrid2D() = default;
+
+    // Mass weighted average of the node velocities on every face, and the mass around every cell centre.
+    // The nodes are split into up to splat_ranges ranges, each splatting into a grid of its own, and those are then
+    // summed face by face in range order so nothing is written by two workers and the sums don't depend on the
+    // worker count. Faces no node reached take the average of their neighbours, extrapolation_layers deep.
+    void TransferToGrid(const FluidSimData2D& data);
+    // Solves for the pressure that leaves every fluid cell divergence free with a conjugate gradient preconditioned by a
+    // multigrid V-cycle, air cells being at zero pressure, then subtracts its gradient from the face velocities.
+    void Project();
+    // Blends each node's velocity between the grid velocity (PIC) and its own plus the change the projection made
+    // to the grid velocity (FLIP) by flip_ratio. Densities are sampled from the splatted mass.
+    void TransferToNodes(FluidSimData2D& data) const;
+
+    glm::ivec2 GetCellCount() const;
+    glm::f32vec2 GetCellSize() const;
+    u32 GetFluidCellCount() const;
+    // Conjugate gradient iterations of the last Project, and the largest divergence it left relative to the initial one.
+    u32 GetPressureIterations() const;
+    f32 GetPressureResidual() const;
+
+    // Lattice coordinates are in cells, the first sample at 0. Samples outside the lattice are clamped to its edge.
+    static FluidSimGridStencil2D GetStencil(glm::f32vec2 lattice_position, glm::ivec2 lattice_size);
+private:
+    void ExtrapolateVelocities(std::vector<f32>& velocities, std::vector<u8>& known, glm::ivec2 lattice_size);
+    void ApplyPressureGradient();
+
+    // A coarse cell is fluid only when all of the cells it covers are, so no level reaches into the air.
+    void CoarsenFluidCells();
+    // Approximately solves the level's right side into its solution, starting from zero. Damped Jacobi sweeps before
+    // and after the correction from the next level, the coarsest level is only swept.
+    void VCycle(u32 level_idx);
+    void Smooth(FluidSimGridLevel2D& level, u32 iterations, bool from_zero);
+    static f32 ApplyLaplacian(const FluidSimGridLevel2D& level, const std::vector<f32>& values, u32 cell_idx);
+
+    // Runs function(range_begin, range_end) over ranges of the cells and combines the glm::f64vec2 each returns,
+    // summing x and taking the largest y. Combined in range order so the result doesn't depend on the scheduling.
+    template<typename Function>
+    glm::f64vec2 ReduceCells(Function&& function);
+
+    // Like FluidSimCore::ForEachRange, but runs the ranges one after the other when single threaded rather than
+    // merging them into one, so passes that sum per range give the same result either way.
+    void ForEachRange(u32 count, u32 range_count, const FluidSimCore::ForEachRangeFunc& function) const;
+    // Ranges to split count cells or faces into. Each costs a handful of operations, far less than a node does.
+    // Only depends on the count, never on the workers, as the reductions are summed per range.
+    static u32 GetRangeCount(u32 count);
+    // Ranges the nodes are splatted in, see TransferToGrid.
+    static u32 GetSplatRangeCount(u32 node_count);
+    u32 GetCellIndex(i32 x, i32 y) const;
+    bool IsFluid(i32 x, i32 y) const;
+    static f32 Sample(const std::vector<f32>& values, const FluidSimGridStencil2D& stencil);
+private:
+    static constexpr u32 extrapolation_layers = 2;
+    static constexpr u32 min_range_size = 16384;
+    // Each splat range keeps a copy of the grid, so there are only ever a few of them.
+    static constexpr u32 splat_ranges = 8;
+    static constexpr u32 smoothing_iterations = 2;
+    static constexpr u32 coarsest_iterations = 32;
+    // Levels stop once a side would drop below this.
+    static constexpr i32 min_coarse_cells = 8;
+    // Neighbour weight of a level relative to the one above, its cells being twice the size.
+    static constexpr f32 coarse_scale = 0.25f;
+    static constexpr f32 jacobi_weight = 0.8f;
+
+    FluidSimOptions2D m_options;
+    glm::ivec2 m_cells;
+    glm::f32vec2 m_cellSize;
+    glm::f32vec2 m_inverseCellSize;
+    // Faces of the u and v lattices.
+    glm::ivec2 m_uSize;
+    glm::ivec2 m_vSize;
+
+    std::vector<f32> m_u;
+    std::vector<f32> m_v;
+    // Face velocities before the projection, the FLIP update is the difference.
+    std::vector<f32> m_previousU;
+    std::vector<f32> m_previousV;
+    // Faces with a velocity, either splatted, on a wall or extrapolated.
+    std::vector<u8> m_knownU;
+    std::vector<u8> m_knownV;
+    std::vector<u8> m_extrapolateKnown;
+
+    std::vector<f32> m_cellMasses;
+    u32 m_fluidCellCount{ 0 };
+
+    // Conjugate gradient state, zero outside the fluid cells. The residual is the finest level's right side and the
+    // preconditioned residual its solution.
+    std::vector<f32> m_pressure;
+    std::vector<f32> m_search;
+    std::vector<f32> m_searchProduct;
+    std::vector<FluidSimGridLevel2D> m_levels;
+    u32 m_pressureIterations{ 0 };
+    f32 m_pressureResidual{ 0.f };
+
+    // Per splat range grids, laid out [range][face] or [range][cell]. Faces hold the weighted momentum in x and
+    // the weight in y.
+    std::vector<glm::f32vec2> m_rangeU;
+    std::vector<glm::f32vec2> m_rangeV;
+    std::vector<f32> m_rangeCellMasses;
+    std::vector<u8> m_rangeFluidCells;
+    std::vector<glm::f64vec2> m_rangeReductions;
+};
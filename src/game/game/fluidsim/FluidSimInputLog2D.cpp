@@ -0,0 +1,185 @@
+#include "FluidSimInputLog2D.h"
+#include "system/compression.h"
+#include "threading/JobDispatcher.h"
+
+#include <fstream>
+
+namespace
+{
+
+template<typename T>
+void AppendBytes(std::vector<u8>& destination, const std::vector<T>& source)
+{
+    const u8* bytes = reinterpret_cast<const u8*>(source.data());
+    destination.insert(destination.end(), bytes, bytes + source.size() * sizeof(T));
+}
+
+template<typename T>
+const u8* ReadBytes(const u8* source, std::vector<T>& destination, u64 count)
+{
+    destination.resize(count);
+    memcpy(destination.data(), source, count * sizeof(T));
+    return source + count * sizeof(T);
+}
+
+} //
+
+void FluidSimInputLog2D::Begin(const FluidSim2D& simulation, u32 checksum_interval)
+{
+    m_snapshot = simulation.SaveSnapshot();
+    m_initialChecksum = simulation.CalculateChecksum();
+    m_checksumInterval = checksum_interval;
+    m_workerCount = u32_cast(JobDispatch::get_worker_count());
+    m_simulateCount = 0;
+    m_commands.clear();
+    m_forces.clear();
+    m_debugs.clear();
+}
+
+void FluidSimInputLog2D::RecordSimulate(const FluidSim2D& simulation, f64 delta_time, const std::vector<FluidSimExternalForce2D>& external_forces)
+{
+    FluidSimInputCommand2D command{ };
+    command.type = FluidSimInputCommandType2D::Simulate;
+    command.first = u32_cast(m_forces.size());
+    command.count = u32_cast(external_forces.size());
+    command.delta_time = delta_time;
+    if( m_checksumInterval && ++m_simulateCount % m_checksumInterval == 0 )
+        command.checksum = simulation.CalculateChecksum();
+
+    m_commands.push_back(command);
+    m_forces.insert(m_forces.end(), external_forces.begin(), external_forces.end());
+}
+
+void FluidSimInputLog2D::RecordApplyDebug(const std::vector<FluidSimExternalDebug2D>& external_debug)
+{
+    FluidSimInputCommand2D command{ };
+    command.type = FluidSimInputCommandType2D::ApplyDebug;
+    command.first = u32_cast(m_debugs.size());
+    command.count = u32_cast(external_debug.size());
+
+    m_commands.push_back(command);
+    m_debugs.insert(m_debugs.end(), external_debug.begin(), external_debug.end());
+}
+
+bool FluidSimInputLog2D::Save(const char* filename) const
+{
+    std::vector<u8> raw;
+    AppendBytes(raw, m_snapshot);
+    AppendBytes(raw, m_commands);
+    AppendBytes(raw, m_forces);
+    AppendBytes(raw, m_debugs);
+
+    // Consecutive frames mostly repeat the same forces, so the log deflates to a fraction of its size.
+    std::vector<u8> compressed = sys::zlib_compress(raw, 5);
+
+    FluidSimInputLogHeader2D header{ };
+    header.magic = FluidSimInputLogHeader2D::magic_value;
+    header.version = FluidSimInputLogHeader2D::current_version;
+    header.command_count = GetCommandCount();
+    header.force_count = u32_cast(m_forces.size());
+    header.debug_count = u32_cast(m_debugs.size());
+    header.checksum_interval = m_checksumInterval;
+    header.worker_count = m_workerCount;
+    header.snapshot_size = m_snapshot.size();
+    header.initial_checksum = m_initialChecksum;
+    header.raw_size = raw.size();
+    header.compressed_size = compressed.size();
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if( !file.is_open() )
+        return false;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(compressed.data()), compressed.size());
+    return file.good();
+}
+
+bool FluidSimInputLog2D::Load(const char* filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if( !file.is_open() )
+        return false;
+
+    FluidSimInputLogHeader2D header;
+    if( !file.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || header.magic != FluidSimInputLogHeader2D::magic_value
+        || header.version != FluidSimInputLogHeader2D::current_version )
+        return false;
+
+    u64 expected_size = header.snapshot_size
+        + u64_cast(header.command_count) * sizeof(FluidSimInputCommand2D)
+        + u64_cast(header.force_count) * sizeof(FluidSimExternalForce2D)
+        + u64_cast(header.debug_count) * sizeof(FluidSimExternalDebug2D);
+    if( header.raw_size != expected_size )
+        return false;
+
+    std::vector<u8> compressed(header.compressed_size);
+    if( !file.read(reinterpret_cast<char*>(compressed.data()), compressed.size()) )
+        return false;
+
+    std::vector<u8> raw(header.raw_size);
+    if( !sys::zlib_decompress(compressed, raw) )
+        return false;
+
+    const u8* read = raw.data();
+    read = ReadBytes(read, m_snapshot, header.snapshot_size);
+    read = ReadBytes(read, m_commands, header.command_count);
+    read = ReadBytes(read, m_forces, header.force_count);
+    read = ReadBytes(read, m_debugs, header.debug_count);
+    m_initialChecksum = header.initial_checksum;
+    m_checksumInterval = header.checksum_interval;
+    m_workerCount = header.worker_count;
+    m_simulateCount = 0;
+
+    for( const FluidSimInputCommand2D& command : m_commands )
+    {
+        u64 argument_count = command.type == FluidSimInputCommandType2D::Simulate ? m_forces.size() : m_debugs.size();
+        if( u64_cast(command.first) + command.count > argument_count )
+        {
+            m_commands.clear();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+const std::vector<u8>& FluidSimInputLog2D::GetSnapshot() const
+{
+    return m_snapshot;
+}
+
+u64 FluidSimInputLog2D::GetInitialChecksum() const
+{
+    return m_initialChecksum;
+}
+
+u32 FluidSimInputLog2D::GetWorkerCount() const
+{
+    return m_workerCount;
+}
+
+u32 FluidSimInputLog2D::GetCommandCount() const
+{
+    return u32_cast(m_commands.size());
+}
+
+const FluidSimInputCommand2D& FluidSimInputLog2D::GetCommand(u32 command_idx) const
+{
+    return m_commands[command_idx];
+}
+
+bool FluidSimInputLog2D::Replay(FluidSim2D& simulation, u32 command_idx) const
+{
+    const FluidSimInputCommand2D& command = m_commands[command_idx];
+    if( command.type == FluidSimInputCommandType2D::ApplyDebug )
+    {
+        m_replayDebugs.assign(m_debugs.begin() + command.first, m_debugs.begin() + command.first + command.count);
+        simulation.ApplyDebug(m_replayDebugs);
+        return true;
+    }
+
+    m_replayForces.assign(m_forces.begin() + command.first, m_forces.begin() + command.first + command.count);
+    simulation.Simulate(command.delta_time, m_replayForces);
+    return !command.checksum || simulation.CalculateChecksum() == command.checksum;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "FluidSim2D.h"
+
+#include <span>
+
+// Everything that drove a simulation, so a run can be replayed exactly: a snapshot of the state it started from
+// followed by every Simulate and ApplyDebug call with its arguments. Every checksum_interval Simulate calls the
+// checksum of the state after the call is kept too, so a replay can tell where it first diverges.
+// Nodes inserted or removed while recording aren't logged.
+enum class FluidSimInputCommandType2D : u32
+{
+    Simulate = 0,
+    ApplyDebug,
+};
+
+struct FluidSimInputCommand2D
+{
+    FluidSimInputCommandType2D type;
+    // Range of the log's forces for Simulate, of its debugs for ApplyDebug.
+    u32 first;
+    u32 count;
+    f64 delta_time;
+    // CalculateChecksum after the command, 0 when it wasn't taken.
+    u64 checksum;
+};
+
+struct FluidSimInputLogHeader2D
+{
+    static constexpr u32 magic_value = 0x32504E49; // "INP2"
+    static constexpr u32 current_version = 1;
+
+    u32 magic;
+    u32 version;
+    u32 command_count;
+    u32 force_count;
+    u32 debug_count;
+    u32 checksum_interval;
+    // For reference only, every solver gives the same results on any worker count.
+    u32 worker_count;
+    u32 reserved;
+    u64 snapshot_size;
+    u64 initial_checksum;
+    // The snapshot, commands, forces and debugs follow deflated as one block.
+    u64 raw_size;
+    u64 compressed_size;
+};
+
+class FluidSimInputLog2D
+{
+public:
+    // Drops anything logged so far and starts again from the current state of the simulation.
+    void Begin(const FluidSim2D& simulation, u32 checksum_interval);
+    // Called by FluidSim2D for every call while the log is set on it, see FluidSim2D::SetInputLog.
+    void RecordSimulate(const FluidSim2D& simulation, f64 delta_time, const std::vector<FluidSimExternalForce2D>& external_forces);
+    void RecordApplyDebug(const std::vector<FluidSimExternalDebug2D>& external_debug);
+
+    bool Save(const char* filename) const;
+    bool Load(const char* filename);
+
+    // State the log starts from, load it into a simulation created with its options before replaying.
+    const std::vector<u8>& GetSnapshot() const;
+    u64 GetInitialChecksum() const;
+    // JobDispatch workers while recording.
+    u32 GetWorkerCount() const;
+    u32 GetCommandCount() const;
+    const FluidSimInputCommand2D& GetCommand(u32 command_idx) const;
+
+    // Repeats one command on the simulation. False when the command has a checksum and the state no longer matches it.
+    bool Replay(FluidSim2D& simulation, u32 command_idx) const;
+private:
+    std::vector<u8> m_snapshot;
+    u64 m_initialChecksum{ 0 };
+    u32 m_checksumInterval{ 0 };
+    u32 m_workerCount{ 0 };
+    u32 m_simulateCount{ 0 };
+
+    std::vector<FluidSimInputCommand2D> m_commands;
+    std::vector<FluidSimExternalForce2D> m_forces;
+    std::vector<FluidSimExternalDebug2D> m_debugs;
+
+    // Scratch for Replay, the simulation takes its arguments as vectors.
+    mutable std::vector<FluidSimExternalForce2D> m_replayForces;
+    mutable std::vector<FluidSimExternalDebug2D> m_replayDebugs;
+};
@@ -0,0 +1,245 @@
+#pragma once
+#include "FluidSimSimd.h"
+
+// Smoothing kernels and scalar precision of the FluidSim2D passes. Both are compile time policies: the passes are
+// instantiated once per combination and FluidSim2D picks the instantiation its options ask for when constructed,
+// so the inner loops never branch on either.
+//
+// Every kernel is a shape over distance d in [0, r] times a normalisation of coefficient / (pi * r^power) that makes
+// it integrate to 1 over the circle. The slope is the derivative of the normalised kernel with respect to d.
+enum class FluidSimKernel2D
+{
+    // (r - d)^2, a spiky kernel squared rather than cubed. Sharp peak so nodes keep their spacing under pressure.
+    Spiky = 0,
+    // (r^2 - d^2)^3, smooth everywhere but its gradient vanishes at d = 0 so close nodes can clump.
+    Poly6,
+    // The M4 cubic B-spline with support r.
+    CubicSpline,
+    // Wendland C2, (1 - q)^4 (1 + 4q) with q = d / r. Smooth and free of the pairing instability.
+    Wendland,
+};
+
+enum class FluidSimPrecision2D
+{
+    // Everything in f32, the vectorised kernels can be used.
+    F32 = 0,
+    // Node state stays f32, distances, kernels and sums are evaluated in f64 by the scalar kernels.
+    F64,
+};
+
+struct FluidSimKernelConstants2D
+{
+    f32 radius;
+    f32 radius_squared;
+    f32 inverse_radius;
+    // Normalisation of the kernel, density_coefficient / (pi * r^density_power)
+    f32 density_scale;
+    // Normalisation of its slope, gradient_coefficient / (pi * r^gradient_power)
+    f32 gradient_scale;
+};
+
+struct FluidSimSpikyKernel2D
+{
+    static constexpr f32 density_coefficient = 6.f;
+    static constexpr i32 density_power = 4;
+    static constexpr f32 gradient_coefficient = 12.f;
+    static constexpr i32 gradient_power = 4;
+
+    template<typename T>
+    static T Value(T distance, const FluidSimKernelConstants2D& kernel)
+    {
+        T radius = kernel.radius;
+        return (radius - distance) * (radius - distance) * T(kernel.density_scale);
+    }
+
+    template<typename T>
+    static T Slope(T distance, const FluidSimKernelConstants2D& kernel)
+    {
+        return (distance - T(kernel.radius)) * T(kernel.gradient_scale);
+    }
+
+    // Unnormalised shape, the vectorised density sums it and applies density_scale once.
+    static FluidSimSimd::floats ShapeSimd(FluidSimSimd::floats distance, const FluidSimKernelConstants2D& kernel)
+    {
+        using simd = FluidSimSimd;
+        simd::floats falloff = simd::Sub(simd::Set(kernel.radius), distance);
+        return simd::Mul(falloff, falloff);
+    }
+
+    static FluidSimSimd::floats SlopeSimd(FluidSimSimd::floats distance, const FluidSimKernelConstants2D& kernel)
+    {
+        using simd = FluidSimSimd;
+        return simd::Mul(simd::Sub(distance, simd::Set(kernel.radius)), simd::Set(kernel.gradient_scale));
+    }
+};
+
+struct FluidSimPoly6Kernel2D
+{
+    static constexpr f32 density_coefficient = 4.f;
+    static constexpr i32 density_power = 8;
+    static constexpr f32 gradient_coefficient = 24.f;
+    static constexpr i32 gradient_power = 8;
+
+    template<typename T>
+    static T Value(T distance, const FluidSimKernelConstants2D& kernel)
+    {
+        T falloff = T(kernel.radius_squared) - distance * distance;
+        return falloff * falloff * falloff * T(kernel.density_scale);
+    }
+
+    template<typename T>
+    static T Slope(T distance, const FluidSimKernelConstants2D& kernel)
+    {
+        T falloff = T(kernel.radius_squared) - distance * distance;
+        return -distance * falloff * falloff * T(kernel.gradient_scale);
+    }
+
+    static FluidSimSimd::floats ShapeSimd(FluidSimSimd::floats distance, const FluidSimKernelConstants2D& kernel)
+    {
+        using simd = FluidSimSimd;
+        simd::floats falloff = simd::Sub(simd::Set(kernel.radius_squared), simd::Mul(distance, distance));
+        return simd::Mul(simd::Mul(falloff, falloff), falloff);
+    }
+
+    static FluidSimSimd::floats SlopeSimd(FluidSimSimd::floats distance, const FluidSimKernelConstants2D& kernel)
+    {
+        using simd = FluidSimSimd;
+        simd::floats falloff = simd::Sub(simd::Set(kernel.radius_squared), simd::Mul(distance, distance));
+        return simd::Mul(simd::Mul(simd::Sub(simd::Set(0.f), distance), simd::Mul(falloff, falloff)), simd::Set(kernel.gradient_scale));
+    }
+};
+
+struct FluidSimCubicSplineKernel2D
+{
+    static constexpr f32 density_coefficient = 40.f / 7.f;
+    static constexpr i32 density_power = 2;
+    static constexpr f32 gradient_coefficient = 40.f / 7.f;
+    static constexpr i32 gradient_power = 3;
+
+    // 2(1 - q)^3 - 8(1/2 - q)^3, the inner term only while q < 1/2. Written with max so neither needs a branch.
+    template<typename T>
+    static T Value(T distance, const FluidSimKernelConstants2D& kernel)
+    {
+        T q = distance * T(kernel.inverse_radius);
+        T outer = T(1) - q;
+        T inner = std::max(T(0.5) - q, T(0));
+        return (T(2) * outer * outer * outer - T(8) * inner * inner * inner) * T(kernel.density_scale);
+    }
+
+    template<typename T>
+    static T Slope(T distance, const FluidSimKernelConstants2D& kernel)
+    {
+        T q = distance * T(kernel.inverse_radius);
+        T outer = T(1) - q;
+        T inner = std::max(T(0.5) - q, T(0));
+        return (T(24) * inner * inner - T(6) * outer * outer) * T(kernel.gradient_scale);
+    }
+
+    static FluidSimSimd::floats ShapeSimd(FluidSimSimd::floats distance, const FluidSimKernelConstants2D& kernel)
+    {
+        using simd = FluidSimSimd;
+        simd::floats q = simd::Mul(distance, simd::Set(kernel.inverse_radius));
+        simd::floats outer = simd::Sub(simd::Set(1.f), q);
+        simd::floats inner = simd::Max(simd::Sub(simd::Set(0.5f), q), simd::Set(0.f));
+        return simd::Sub(
+            simd::Mul(simd::Set(2.f), simd::Mul(simd::Mul(outer, outer), outer)),
+            simd::Mul(simd::Set(8.f), simd::Mul(simd::Mul(inner, inner), inner)));
+    }
+
+    static FluidSimSimd::floats SlopeSimd(FluidSimSimd::floats distance, const FluidSimKernelConstants2D& kernel)
+    {
+        using simd = FluidSimSimd;
+        simd::floats q = simd::Mul(distance, simd::Set(kernel.inverse_radius));
+        simd::floats outer = simd::Sub(simd::Set(1.f), q);
+        simd::floats inner = simd::Max(simd::Sub(simd::Set(0.5f), q), simd::Set(0.f));
+        simd::floats shape = simd::Sub(
+            simd::Mul(simd::Set(24.f), simd::Mul(inner, inner)),
+            simd::Mul(simd::Set(6.f), simd::Mul(outer, outer)));
+        return simd::Mul(shape, simd::Set(kernel.gradient_scale));
+    }
+};
+
+struct FluidSimWendlandKernel2D
+{
+    static constexpr f32 density_coefficient = 7.f;
+    static constexpr i32 density_power = 2;
+    static constexpr f32 gradient_coefficient = 7.f;
+    static constexpr i32 gradient_power = 3;
+
+    template<typename T>
+    static T Value(T distance, const FluidSimKernelConstants2D& kernel)
+    {
+        T q = distance * T(kernel.inverse_radius);
+        T outer = T(1) - q;
+        T outer_squared = outer * outer;
+        return outer_squared * outer_squared * (T(1) + T(4) * q) * T(kernel.density_scale);
+    }
+
+    template<typename T>
+    static T Slope(T distance, const FluidSimKernelConstants2D& kernel)
+    {
+        T q = distance * T(kernel.inverse_radius);
+        T outer = T(1) - q;
+        return T(-20) * q * outer * outer * outer * T(kernel.gradient_scale);
+    }
+
+    static FluidSimSimd::floats ShapeSimd(FluidSimSimd::floats distance, const FluidSimKernelConstants2D& kernel)
+    {
+        using simd = FluidSimSimd;
+        simd::floats q = simd::Mul(distance, simd::Set(kernel.inverse_radius));
+        simd::floats outer = simd::Sub(simd::Set(1.f), q);
+        simd::floats outer_squared = simd::Mul(outer, outer);
+        return simd::Mul(simd::Mul(outer_squared, outer_squared), simd::Add(simd::Set(1.f), simd::Mul(simd::Set(4.f), q)));
+    }
+
+    static FluidSimSimd::floats SlopeSimd(FluidSimSimd::floats distance, const FluidSimKernelConstants2D& kernel)
+    {
+        using simd = FluidSimSimd;
+        simd::floats q = simd::Mul(distance, simd::Set(kernel.inverse_radius));
+        simd::floats outer = simd::Sub(simd::Set(1.f), q);
+        simd::floats shape = simd::Mul(simd::Mul(simd::Set(-20.f), q), simd::Mul(simd::Mul(outer, outer), outer));
+        return simd::Mul(shape, simd::Set(kernel.gradient_scale));
+    }
+};
+
+template<typename Kernel>
+FluidSimKernelConstants2D MakeKernelConstants2D(f32 radius)
+{
+    auto radius_power = [radius](i32 power)
+        {
+            f32 result = radius;
+            for( i32 idx = 1; idx < power; idx++ )
+            {
+                result *= radius;
+            }
+            return result;
+        };
+
+    return
+    {
+        .radius = radius,
+        .radius_squared = radius * radius,
+        .inverse_radius = 1.f / radius,
+        .density_scale = Kernel::density_coefficient / (glm::pi<f32>() * radius_power(Kernel::density_power)),
+        .gradient_scale = Kernel::gradient_coefficient / (glm::pi<f32>() * radius_power(Kernel::gradient_power)),
+    };
+}
+
+struct FluidSimF32Precision2D
+{
+    using scalar = f32;
+    using vec2 = glm::f32vec2;
+    static constexpr bool vectorised = true;
+
+    // The lookups already measured the distance in f32.
+    static scalar Distance(const glm::f32vec2&, const glm::f32vec2&, f32 distance) { return distance; }
+};
+
+struct FluidSimF64Precision2D
+{
+    using scalar = f64;
+    using vec2 = glm::f64vec2;
+    static constexpr bool vectorised = false;
+
+    static scalar Distance(const glm::f32vec2& from, const glm::f32vec2& to, f32) { return glm::length(vec2(to) - vec2(from)); }
+};
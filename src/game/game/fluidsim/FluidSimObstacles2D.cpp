@@ -0,0 +1,154 @@
+#include "FluidSimObstacles2D.h"
+#include "FluidSimCore.h"
+#include "sim_channels.h"
+#include "data/mesh.h"
+
+FluidSimObstacles2D::FluidSimObstacles2D(glm::f32vec2 origin, glm::f32vec2 extent, f32 cell_size) :
+    m_origin(origin),
+    m_cellSize(cell_size)
+{
+    FLUIDSIM_ASSERT(cell_size > 0.f, "The obstacle field needs a positive cell size.");
+    FLUIDSIM_ASSERT(extent.x > 0.f && extent.y > 0.f, "The obstacle field needs to cover an area.");
+
+    m_inverseCellSize = 1.f / cell_size;
+    m_samples = glm::max(glm::ivec2(glm::ceil(extent * m_inverseCellSize)) + 1, glm::ivec2(2, 2));
+}
+
+void FluidSimObstacles2D::AddPolygon(std::span<const glm::f32vec2> points)
+{
+    if( points.size() < 3 )
+        return;
+
+    m_outlines.push_back({ u32_cast(m_points.size()), u32_cast(points.size()), true, 0.f });
+    m_points.insert(m_points.end(), points.begin(), points.end());
+}
+
+void FluidSimObstacles2D::AddPolyline(std::span<const glm::f32vec2> points, f32 thickness)
+{
+    if( points.size() < 2 )
+        return;
+
+    m_outlines.push_back({ u32_cast(m_points.size()), u32_cast(points.size()), false, std::max(thickness, 0.f) * 0.5f });
+    m_points.insert(m_points.end(), points.begin(), points.end());
+}
+
+void FluidSimObstacles2D::AddMeshOutline(const mtl::mesh& mesh)
+{
+    std::vector<glm::f32vec2> points;
+    for( u32 submesh_idx = 0; submesh_idx < u32_cast(mesh.get_submesh_count()); submesh_idx++ )
+    {
+        const mtl::submesh& submesh = mesh.get_submesh(submesh_idx);
+        if( submesh.get_vertex_count() < 3 )
+            continue;
+
+        const std::vector<glm::vec4>& vertices = submesh.get_channel(0);
+        points.clear();
+        for( const glm::vec4& vertex : vertices )
+            points.emplace_back(vertex.x, vertex.y);
+
+        AddPolygon(points);
+    }
+}
+
+void FluidSimObstacles2D::Build(bool multithreaded)
+{
+    m_distances.resize(u64_cast(m_samples.x) * m_samples.y);
+
+    u32 row_count = u32_cast(m_samples.y);
+    u32 range_count = std::min(FluidSimCore::GetRangeCount(u32_cast(m_distances.size()), multithreaded), row_count);
+    FluidSimCore::ForEachRange(row_count, range_count, [&](u32 range_begin, u32 range_end, u32)
+        {
+            for( u32 y = range_begin; y < range_end; y++ )
+            {
+                for( i32 x = 0; x < m_samples.x; x++ )
+                {
+                    glm::f32vec2 position = m_origin + glm::f32vec2(f32_cast(x), f32_cast(y)) * m_cellSize;
+                    m_distances[u64_cast(y) * m_samples.x + x] = CalculateDistance(position);
+                }
+            }
+        });
+}
+
+f32 FluidSimObstacles2D::Sample(glm::f32vec2 position, glm::f32vec2* gradient) const
+{
+    FLUIDSIM_ASSERT(IsBuilt(), "Obstacles have to be built before they are sampled.");
+
+    glm::f32vec2 lattice_position = glm::clamp((position - m_origin) * m_inverseCellSize, glm::f32vec2(0.f, 0.f), glm::f32vec2(m_samples - 1));
+    glm::ivec2 cell = glm::min(glm::ivec2(lattice_position), m_samples - 2);
+    glm::f32vec2 t = lattice_position - glm::f32vec2(cell);
+
+    const f32* row = m_distances.data() + u64_cast(cell.y) * m_samples.x + cell.x;
+    f32 d00 = row[0];
+    f32 d10 = row[1];
+    f32 d01 = row[m_samples.x];
+    f32 d11 = row[m_samples.x + 1];
+
+    if( gradient )
+    {
+        gradient->x = ((1.f - t.y) * (d10 - d00) + t.y * (d11 - d01)) * m_inverseCellSize;
+        gradient->y = ((1.f - t.x) * (d01 - d00) + t.x * (d11 - d10)) * m_inverseCellSize;
+    }
+
+    return glm::mix(glm::mix(d00, d10, t.x), glm::mix(d01, d11, t.x), t.y);
+}
+
+bool FluidSimObstacles2D::IsBuilt() const
+{
+    return !m_distances.empty();
+}
+
+glm::ivec2 FluidSimObstacles2D::GetSampleCount() const
+{
+    return m_samples;
+}
+
+u32 FluidSimObstacles2D::GetSegmentCount() const
+{
+    u32 segment_count = 0;
+    for( const Outline& outline : m_outlines )
+        segment_count += outline.closed ? outline.point_count : outline.point_count - 1;
+
+    return segment_count;
+}
+
+f32 FluidSimObstacles2D::CalculateDistance(glm::f32vec2 position) const
+{
+    f32 distance = std::numeric_limits<f32>::max();
+    for( const Outline& outline : m_outlines )
+    {
+        const glm::f32vec2* points = m_points.data() + outline.first_point;
+        u32 segment_count = outline.closed ? outline.point_count : outline.point_count - 1;
+
+        f32 outline_distance_squared = std::numeric_limits<f32>::max();
+        bool inside = false;
+        for( u32 segment_idx = 0; segment_idx < segment_count; segment_idx++ )
+        {
+            glm::f32vec2 a = points[segment_idx];
+            glm::f32vec2 b = points[(segment_idx + 1) % outline.point_count];
+
+            glm::f32vec2 segment = b - a;
+            f32 length_squared = glm::dot(segment, segment);
+            f32 t = length_squared > 0.f ? glm::clamp(glm::dot(position - a, segment) / length_squared, 0.f, 1.f) : 0.f;
+            glm::f32vec2 offset = position - (a + segment * t);
+            outline_distance_squared = std::min(outline_distance_squared, glm::dot(offset, offset));
+
+            // Crossing number, counting the edges a ray towards +x crosses.
+            if( outline.closed && (a.y > position.y) != (b.y > position.y) )
+            {
+                f32 crossing_x = a.x + (position.y - a.y) / (b.y - a.y) * segment.x;
+                if( position.x < crossing_x )
+                    inside = !inside;
+            }
+        }
+
+        f32 outline_distance = std::sqrt(outline_distance_squared);
+        if( outline.closed )
+            outline_distance = inside ? -outline_distance : outline_distance;
+        else
+            outline_distance -= outline.half_thickness;
+
+        distance = std::min(distance, outline_distance);
+    }
+
+    return distance;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "FluidSimData2D.h"
+
+#include <span>
+
+namespace mtl
+{
+class mesh;
+}
+
+// Static obstacles baked into a signed distance field on a regular lattice, negative inside. Outlines are only
+// walked by Build, so a node's collision query is one bilinear sample however many segments the scene has.
+// Lattice samples sit at origin + cell_size * (x, y), covering the extent.
+class FluidSimObstacles2D
+{
+public:
+    FluidSimObstacles2D(glm::f32vec2 origin, glm::f32vec2 extent, f32 cell_size);
+    ~FluidSimObstacles2D() = default;
+
+    // Closed outline, the last point joining the first. Everything enclosed is solid.
+    void AddPolygon(std::span<const glm::f32vec2> points);
+    // Open outline, solid within thickness / 2 of it.
+    void AddPolyline(std::span<const glm::f32vec2> points, f32 thickness);
+    // Each submesh's vertices, x and y of the first channel, in order as a closed polygon. Submeshes with fewer than
+    // three vertices are skipped.
+    void AddMeshOutline(const mtl::mesh& mesh);
+
+    // Distance from every lattice sample to the nearest outline, O(samples * segments). The outlines are unioned,
+    // the field being the smallest distance of any of them. Nothing collides until this is called.
+    void Build(bool multithreaded);
+
+    // Bilinear distance at the position, and when gradient isn't null the gradient of that bilinear patch, which
+    // points away from the nearest surface. Positions outside the lattice sample its edge.
+    f32 Sample(glm::f32vec2 position, glm::f32vec2* gradient = nullptr) const;
+
+    bool IsBuilt() const;
+    glm::ivec2 GetSampleCount() const;
+    u32 GetSegmentCount() const;
+private:
+    struct Outline
+    {
+        u32 first_point;
+        u32 point_count;
+        bool closed;
+        f32 half_thickness;
+    };
+
+    f32 CalculateDistance(glm::f32vec2 position) const;
+private:
+    glm::f32vec2 m_origin;
+    f32 m_cellSize;
+    f32 m_inverseCellSize;
+    glm::ivec2 m_samples;
+
+    std::vector<glm::f32vec2> m_points;
+    std::vector<Outline> m_outlines;
+
+    // Rows from the origin up.
+    std::vector<f32> m_distances;
+};
@@ -0,0 +1,58 @@
+#include "FluidSimRunner2D.h"
+#include "threading/threading.h"
+
+FluidSimRunner2D::FluidSimRunner2D()
+{
+    m_thread = request_thread("FluidSim", [this](){ ThreadLoop(); });
+}
+
+FluidSimRunner2D::~FluidSimRunner2D()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_condition.notify_all();
+    m_thread.join();
+}
+
+void FluidSimRunner2D::Kick(std::function<void()> work)
+{
+    Wait();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_work = std::move(work);
+        m_busy = true;
+    }
+    m_condition.notify_all();
+}
+
+void FluidSimRunner2D::Wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait(lock, [&](){ return !m_busy; });
+}
+
+void FluidSimRunner2D::ThreadLoop()
+{
+    while( true )
+    {
+        std::function<void()> work;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [&](){ return m_busy || m_quit; });
+            if( !m_busy )
+                return;
+
+            work = std::move(m_work);
+        }
+
+        work();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_busy = false;
+        }
+        m_condition.notify_all();
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Runs work for a simulation on a thread of its own so that it overlaps whatever the caller does next,
+// e.g. rendering the frame the simulation published last (see FluidSim2D::Publish). One piece of work
+// is in flight at a time.
+class FluidSimRunner2D
+{
+public:
+    FluidSimRunner2D();
+    ~FluidSimRunner2D();
+
+    DELETE_COPY(FluidSimRunner2D);
+    DELETE_MOVE(FluidSimRunner2D);
+
+    // Waits for the previous work then starts this one. Nothing the work touches may be used until Wait returns.
+    void Kick(std::function<void()> work);
+    void Wait();
+private:
+    void ThreadLoop();
+private:
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::function<void()> m_work;
+    bool m_busy{ false };
+    bool m_quit{ false };
+};
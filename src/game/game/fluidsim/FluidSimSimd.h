@@ -0,0 +1,175 @@
+#pragma once
+
+#include <bit>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FLUIDSIM_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FLUIDSIM_SIMD_SSE2
+#endif
+
+// Thin wrapper over the widest float vector the target was compiled for (AVX2, SSE2, or a single scalar lane).
+// Kernels are written once against these functions and process FluidSimSimd::width neighbours per iteration.
+// GatherInterleaved reads base[index * 2], one component of an interleaved vec2 stream.
+// MaskedLoad and MaskedStore leave the memory of inactive lanes untouched, other threads may own it.
+struct FluidSimSimd
+{
+#if defined(FLUIDSIM_SIMD_AVX2)
+    using floats = __m256;
+    using indices = __m256i;
+    using mask = __m256;
+    static constexpr u32 width = 8;
+
+    static floats Set(f32 value) { return _mm256_set1_ps(value); }
+    static floats Load(const f32* source) { return _mm256_loadu_ps(source); }
+    static void Store(f32* destination, floats a) { _mm256_storeu_ps(destination, a); }
+    static floats MaskedLoad(const f32* source, mask m) { return _mm256_maskload_ps(source, _mm256_castps_si256(m)); }
+    static void MaskedStore(f32* destination, mask m, floats a) { _mm256_maskstore_ps(destination, _mm256_castps_si256(m), a); }
+    static indices LoadIndices(const u32* source) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source)); }
+    static floats Gather(const f32* base, indices index) { return _mm256_i32gather_ps(base, index, 4); }
+    static floats GatherInterleaved(const f32* base, indices index) { return _mm256_i32gather_ps(base, index, 8); }
+
+    static floats Add(floats a, floats b) { return _mm256_add_ps(a, b); }
+    static floats Sub(floats a, floats b) { return _mm256_sub_ps(a, b); }
+    static floats Mul(floats a, floats b) { return _mm256_mul_ps(a, b); }
+    static floats Div(floats a, floats b) { return _mm256_div_ps(a, b); }
+    static floats Sqrt(floats a) { return _mm256_sqrt_ps(a); }
+    static floats Max(floats a, floats b) { return _mm256_max_ps(a, b); }
+
+    static mask LessEqual(floats a, floats b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    static mask Greater(floats a, floats b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static mask IndexEquals(indices a, u32 value) { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, _mm256_set1_epi32(i32_cast(value)))); }
+    static mask FirstLanes(u32 count)
+    {
+        __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        return _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(i32_cast(std::min(count, width))), lanes));
+    }
+
+    static mask And(mask a, mask b) { return _mm256_and_ps(a, b); }
+    // b and not a
+    static mask AndNot(mask a, mask b) { return _mm256_andnot_ps(a, b); }
+    static floats Select(mask m, floats a) { return _mm256_and_ps(m, a); }
+    static u32 MaskBits(mask m) { return u32_cast(_mm256_movemask_ps(m)); }
+    static u32 MaskCount(mask m) { return u32_cast(std::popcount(MaskBits(m))); }
+
+    static f32 Sum(floats a)
+    {
+        __m128 half = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+        __m128 quarter = _mm_add_ps(half, _mm_movehl_ps(half, half));
+        return _mm_cvtss_f32(_mm_add_ss(quarter, _mm_shuffle_ps(quarter, quarter, 1)));
+    }
+#elif defined(FLUIDSIM_SIMD_SSE2)
+    using floats = __m128;
+    using indices = __m128i;
+    using mask = __m128;
+    static constexpr u32 width = 4;
+
+    static floats Set(f32 value) { return _mm_set1_ps(value); }
+    static floats Load(const f32* source) { return _mm_loadu_ps(source); }
+    static void Store(f32* destination, floats a) { _mm_storeu_ps(destination, a); }
+    // No masked moves before AVX, full masks take a plain load or store and the rest go lane by lane.
+    static floats MaskedLoad(const f32* source, mask m)
+    {
+        if( MaskBits(m) == (1u << width) - 1 )
+            return Load(source);
+
+        alignas(16) f32 lanes[width]{ };
+        for( u32 bits = MaskBits(m); bits; bits &= bits - 1 )
+        {
+            lanes[std::countr_zero(bits)] = source[std::countr_zero(bits)];
+        }
+        return _mm_load_ps(lanes);
+    }
+    static void MaskedStore(f32* destination, mask m, floats a)
+    {
+        if( MaskBits(m) == (1u << width) - 1 )
+            return Store(destination, a);
+
+        alignas(16) f32 lanes[width];
+        _mm_store_ps(lanes, a);
+        for( u32 bits = MaskBits(m); bits; bits &= bits - 1 )
+        {
+            destination[std::countr_zero(bits)] = lanes[std::countr_zero(bits)];
+        }
+    }
+    static indices LoadIndices(const u32* source) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source)); }
+    static floats Gather(const f32* base, indices index)
+    {
+        alignas(16) u32 lanes[width];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), index);
+        return _mm_setr_ps(base[lanes[0]], base[lanes[1]], base[lanes[2]], base[lanes[3]]);
+    }
+    static floats GatherInterleaved(const f32* base, indices index)
+    {
+        alignas(16) u32 lanes[width];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), index);
+        return _mm_setr_ps(base[lanes[0] * 2], base[lanes[1] * 2], base[lanes[2] * 2], base[lanes[3] * 2]);
+    }
+
+    static floats Add(floats a, floats b) { return _mm_add_ps(a, b); }
+    static floats Sub(floats a, floats b) { return _mm_sub_ps(a, b); }
+    static floats Mul(floats a, floats b) { return _mm_mul_ps(a, b); }
+    static floats Div(floats a, floats b) { return _mm_div_ps(a, b); }
+    static floats Sqrt(floats a) { return _mm_sqrt_ps(a); }
+    static floats Max(floats a, floats b) { return _mm_max_ps(a, b); }
+
+    static mask LessEqual(floats a, floats b) { return _mm_cmple_ps(a, b); }
+    static mask Greater(floats a, floats b) { return _mm_cmpgt_ps(a, b); }
+    static mask IndexEquals(indices a, u32 value) { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, _mm_set1_epi32(i32_cast(value)))); }
+    static mask FirstLanes(u32 count)
+    {
+        __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+        return _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_set1_epi32(i32_cast(std::min(count, width))), lanes));
+    }
+
+    static mask And(mask a, mask b) { return _mm_and_ps(a, b); }
+    // b and not a
+    static mask AndNot(mask a, mask b) { return _mm_andnot_ps(a, b); }
+    static floats Select(mask m, floats a) { return _mm_and_ps(m, a); }
+    static u32 MaskBits(mask m) { return u32_cast(_mm_movemask_ps(m)); }
+    static u32 MaskCount(mask m) { return u32_cast(std::popcount(MaskBits(m))); }
+
+    static f32 Sum(floats a)
+    {
+        __m128 half = _mm_add_ps(a, _mm_movehl_ps(a, a));
+        return _mm_cvtss_f32(_mm_add_ss(half, _mm_shuffle_ps(half, half, 1)));
+    }
+#else
+    using floats = f32;
+    using indices = u32;
+    using mask = bool;
+    static constexpr u32 width = 1;
+
+    static floats Set(f32 value) { return value; }
+    static floats Load(const f32* source) { return *source; }
+    static void Store(f32* destination, floats a) { *destination = a; }
+    static floats MaskedLoad(const f32* source, mask m) { return m ? *source : 0.f; }
+    static void MaskedStore(f32* destination, mask m, floats a) { if( m ) *destination = a; }
+    static indices LoadIndices(const u32* source) { return *source; }
+    static floats Gather(const f32* base, indices index) { return base[index]; }
+    static floats GatherInterleaved(const f32* base, indices index) { return base[index * 2]; }
+
+    static floats Add(floats a, floats b) { return a + b; }
+    static floats Sub(floats a, floats b) { return a - b; }
+    static floats Mul(floats a, floats b) { return a * b; }
+    static floats Div(floats a, floats b) { return a / b; }
+    static floats Sqrt(floats a) { return std::sqrt(a); }
+    static floats Max(floats a, floats b) { return std::max(a, b); }
+
+    static mask LessEqual(floats a, floats b) { return a <= b; }
+    static mask Greater(floats a, floats b) { return a > b; }
+    static mask IndexEquals(indices a, u32 value) { return a == value; }
+    static mask FirstLanes(u32 count) { return count > 0; }
+
+    static mask And(mask a, mask b) { return a && b; }
+    // b and not a
+    static mask AndNot(mask a, mask b) { return !a && b; }
+    static floats Select(mask m, floats a) { return m ? a : 0.f; }
+    static u32 MaskBits(mask m) { return m ? 1 : 0; }
+    static u32 MaskCount(mask m) { return m ? 1 : 0; }
+
+    static f32 Sum(floats a) { return a; }
+#endif
+};
@@ -0,0 +1,94 @@
+#include "FluidSimSnapshot2D.h"
+
+#include <fstream>
+
+namespace
+{
+
+struct ExpectedStream
+{
+    u32 element_size;
+    // Elements per node, or per node id for id indexed streams. Free ids only need to fit in the id capacity.
+    // Optional per node streams are either empty or per node, the rest are checked when they are adopted.
+    enum { PerNode, PerNodeId, UpToNodeId, PerNodeOrEmpty, Any } length;
+};
+
+constexpr ExpectedStream expected_streams[u32_cast(FluidSimSnapshotStream2D::Count)] =
+{
+    { sizeof(glm::f32vec4), ExpectedStream::PerNode },
+    { sizeof(glm::f32vec2), ExpectedStream::PerNode },
+    { sizeof(glm::f32vec2), ExpectedStream::PerNode },
+    { sizeof(f32), ExpectedStream::PerNode },
+    { sizeof(f32), ExpectedStream::PerNode },
+    { sizeof(f32), ExpectedStream::PerNode },
+    { sizeof(glm::f32vec3), ExpectedStream::PerNode },
+    { sizeof(u32), ExpectedStream::PerNode },
+    { sizeof(u32), ExpectedStream::PerNodeId },
+    { sizeof(u32), ExpectedStream::UpToNodeId },
+    { sizeof(FluidSimSleepState2D), ExpectedStream::PerNodeOrEmpty },
+    { sizeof(u32), ExpectedStream::Any },
+    { sizeof(glm::ivec2), ExpectedStream::Any },
+};
+
+} //
+
+const FluidSimSnapshotHeader2D* ReadSnapshotHeader(std::span<const u8> snapshot)
+{
+    if( snapshot.size() < sizeof(FluidSimSnapshotHeader2D) )
+        return nullptr;
+
+    const FluidSimSnapshotHeader2D* header = reinterpret_cast<const FluidSimSnapshotHeader2D*>(snapshot.data());
+    if( header->magic != FluidSimSnapshotHeader2D::magic_value
+        || header->version != FluidSimSnapshotHeader2D::current_version
+        || header->header_size != sizeof(FluidSimSnapshotHeader2D)
+        || header->stream_count != u32_cast(FluidSimSnapshotStream2D::Count)
+        || header->total_size > snapshot.size()
+        || header->node_count > header->node_id_capacity )
+        return nullptr;
+
+    for( u32 idx = 0; idx < header->stream_count; idx++ )
+    {
+        const FluidSimSnapshotStreamInfo2D& stream = header->streams[idx];
+        const ExpectedStream& expected = expected_streams[idx];
+        if( stream.element_size != expected.element_size || stream.offset % FluidSimSnapshotHeader2D::stream_alignment )
+            return nullptr;
+
+        bool length_matches = expected.length == ExpectedStream::PerNode ? stream.element_count == header->node_count
+            : expected.length == ExpectedStream::PerNodeId ? stream.element_count == header->node_id_capacity
+            : expected.length == ExpectedStream::UpToNodeId ? stream.element_count <= header->node_id_capacity
+            : expected.length == ExpectedStream::PerNodeOrEmpty ? stream.element_count == header->node_count || stream.element_count == 0
+            : true;
+        if( !length_matches )
+            return nullptr;
+
+        if( stream.offset < sizeof(FluidSimSnapshotHeader2D) || stream.offset > header->total_size
+            || u64_cast(stream.element_count) * stream.element_size > header->total_size - stream.offset )
+            return nullptr;
+    }
+
+    return header;
+}
+
+std::vector<u8> LoadSnapshotFile(const char* filename)
+{
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if( !file.is_open() )
+        return { };
+
+    std::vector<u8> snapshot(u64_cast(file.tellg()));
+    file.seekg(0);
+    if( !file.read(reinterpret_cast<char*>(snapshot.data()), snapshot.size()) )
+        return { };
+
+    return snapshot;
+}
+
+bool SaveSnapshotFile(const char* filename, std::span<const u8> snapshot)
+{
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if( !file.is_open() )
+        return false;
+
+    file.write(reinterpret_cast<const char*>(snapshot.data()), snapshot.size());
+    return file.good();
+}
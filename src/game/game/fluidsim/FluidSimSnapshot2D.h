@@ -0,0 +1,70 @@
+#pragma once
+#include "FluidSimData2D.h"
+
+#include <span>
+
+// A snapshot is a versioned binary image of a simulation: a fixed size header holding the options, followed by
+// every node stream at a stream_alignment aligned offset from the start of the snapshot. A snapshot file can be
+// read (or mapped) as one block and adopted with a single copy per stream, nothing is parsed node by node.
+// Elements are stored in their in-memory layout, so snapshots only move between builds for the same architecture.
+enum class FluidSimSnapshotStream2D : u32
+{
+    Positions = 0,
+    PredictedPositions,
+    Velocities,
+    Radii,
+    Densities,
+    Masses,
+    Colors,
+    NodeIds,
+    // Indexed by node id, one per id up to the id capacity.
+    NodeGenerations,
+    FreeNodeIds,
+    // Sleep tracking, empty unless sleeping is enabled. Quiet steps are indexed by cell id, which in tiled mode
+    // depends on the order the tiles were allocated in, so the tile coordinates are kept in that order.
+    NodeSleepStates,
+    CellQuietSteps,
+    TileCoordinates,
+    Count,
+};
+
+struct FluidSimSnapshotStreamInfo2D
+{
+    // Bytes from the start of the snapshot.
+    u64 offset;
+    u32 element_size;
+    u32 element_count;
+};
+
+// Written member by member into zeroed storage, so the padding is zero and equal simulations save equal bytes.
+struct FluidSimSnapshotHeader2D
+{
+    static constexpr u32 magic_value = 0x32535346; // "FSS2"
+    static constexpr u32 current_version = 5;
+    static constexpr u64 stream_alignment = 64;
+
+    u32 magic;
+    u32 version;
+    u32 header_size;
+    u32 stream_count;
+    u64 total_size;
+
+    u32 node_count;
+    u32 node_id_capacity;
+    FluidSimOptions2D options;
+
+    // State FluidSim2D carries between steps, so a loaded snapshot steps on exactly like the saved simulation would.
+    u32 steps_since_reorder;
+    f32 max_speed;
+    f32 max_acceleration;
+
+    FluidSimSnapshotStreamInfo2D streams[u32_cast(FluidSimSnapshotStream2D::Count)];
+};
+
+// The header of the snapshot when it is one this build can load: the magic, version and element sizes match
+// and every stream has the expected length and lies within the snapshot. Null otherwise.
+const FluidSimSnapshotHeader2D* ReadSnapshotHeader(std::span<const u8> snapshot);
+
+// Reads the whole file in one go, empty if it couldn't be read.
+std::vector<u8> LoadSnapshotFile(const char* filename);
+bool SaveSnapshotFile(const char* filename, std::span<const u8> snapshot);
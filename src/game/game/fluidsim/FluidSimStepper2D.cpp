@@ -0,0 +1,118 @@
+#include "FluidSimStepper2D.h"
+
+FluidSimStepper2D::FluidSimStepper2D(FluidSimStepperOptions2D options) :
+    m_options(options)
+{ }
+
+u32 FluidSimStepper2D::Advance(
+    FluidSim2D& simulation,
+    f64 frame_time,
+    const std::vector<FluidSimExternalForce2D>& external_forces)
+{
+    m_accumulator += frame_time;
+
+    u32 step_count = u32_cast(m_accumulator / m_options.step_time);
+    if( step_count > m_options.max_steps )
+    {
+        f64 dropped_time = (step_count - m_options.max_steps) * m_options.step_time;
+        m_droppedTime += dropped_time;
+        m_accumulator -= dropped_time;
+        step_count = m_options.max_steps;
+    }
+
+    // An adaptive simulation may split a step into several substeps, those count against max_steps
+    // too so the cost of a frame stays bounded. Whole steps that no longer fit are dropped.
+    u32 steps_run = 0;
+    u32 substeps_run = 0;
+    while( steps_run < step_count && substeps_run < m_options.max_steps )
+    {
+        CapturePreviousPositions(simulation);
+        simulation.Simulate(m_options.step_time, external_forces);
+        m_accumulator -= m_options.step_time;
+
+        steps_run++;
+        substeps_run += simulation.GetStats().substep_count;
+    }
+
+    if( steps_run < step_count )
+    {
+        f64 dropped_time = (step_count - steps_run) * m_options.step_time;
+        m_droppedTime += dropped_time;
+        m_accumulator -= dropped_time;
+    }
+
+    m_lastStepCount = steps_run;
+    return steps_run;
+}
+
+f32 FluidSimStepper2D::GetInterpolationAlpha() const
+{
+    return std::clamp(f32_cast(m_accumulator / m_options.step_time), 0.f, 1.f);
+}
+
+void FluidSimStepper2D::WriteInterpolatedPositions(const FluidSim2D& simulation, glm::f32vec4* destination) const
+{
+    const std::vector<glm::f32vec4>& positions = simulation.GetNodePositions();
+
+    // Nodes that wrapped around the edges snap to their new position rather than sweeping across the domain.
+    glm::f32vec2 max_travel = simulation.GetOptions().extent / 2.f;
+    f32 alpha = GetInterpolationAlpha();
+    for( u32 node_idx = 0; node_idx < simulation.GetNodeCount(); node_idx++ )
+    {
+        const glm::f32vec4& current = positions[node_idx];
+        FluidNodeHandle2D handle = simulation.GetNodeHandle(node_idx);
+        if( handle.id >= m_previousGenerations.size() || m_previousGenerations[handle.id] != handle.generation )
+        {
+            destination[node_idx] = current;
+            continue;
+        }
+
+        const glm::f32vec4& previous = m_previousPositions[handle.id];
+        glm::f32vec2 travel = glm::abs(glm::f32vec2(current) - glm::f32vec2(previous));
+        destination[node_idx] = travel.x > max_travel.x || travel.y > max_travel.y
+            ? current
+            : glm::mix(previous, current, alpha);
+    }
+}
+
+void FluidSimStepper2D::SetOptions(FluidSimStepperOptions2D options)
+{
+    m_options = options;
+}
+
+const FluidSimStepperOptions2D& FluidSimStepper2D::GetOptions() const
+{
+    return m_options;
+}
+
+u32 FluidSimStepper2D::GetLastStepCount() const
+{
+    return m_lastStepCount;
+}
+
+f64 FluidSimStepper2D::GetDroppedTime() const
+{
+    return m_droppedTime;
+}
+
+void FluidSimStepper2D::Reset()
+{
+    m_accumulator = 0.0;
+    m_droppedTime = 0.0;
+    m_lastStepCount = 0;
+    m_previousPositions.clear();
+    m_previousGenerations.clear();
+}
+
+void FluidSimStepper2D::CapturePreviousPositions(const FluidSim2D& simulation)
+{
+    const std::vector<glm::f32vec4>& positions = simulation.GetNodePositions();
+    m_previousPositions.resize(simulation.GetNodeIdCapacity());
+    m_previousGenerations.assign(simulation.GetNodeIdCapacity(), ~0u);
+    for( u32 node_idx = 0; node_idx < simulation.GetNodeCount(); node_idx++ )
+    {
+        FluidNodeHandle2D handle = simulation.GetNodeHandle(node_idx);
+        m_previousPositions[handle.id] = positions[node_idx];
+        m_previousGenerations[handle.id] = handle.generation;
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "FluidSim2D.h"
+
+struct FluidSimStepperOptions2D
+{
+    // Length of every simulation step, in seconds.
+    f64 step_time;
+    // Most steps run by a single Advance, counting each substep of an adaptive simulation. Time past
+    // that is dropped so one slow frame can't make the next frame run even more steps.
+    u32 max_steps;
+};
+
+// Runs a FluidSim2D at a fixed step size regardless of how long frames take. Frame time is
+// accumulated and consumed in whole steps, the left over fraction is used to blend the positions
+// before and after the last step so rendering stays smooth when the step and frame rates differ.
+class FluidSimStepper2D
+{
+public:
+    FluidSimStepper2D(FluidSimStepperOptions2D options);
+    ~FluidSimStepper2D() = default;
+
+    // Returns how many steps were run.
+    u32 Advance(
+        FluidSim2D& simulation,
+        f64 frame_time,
+        const std::vector<FluidSimExternalForce2D>& external_forces = { });
+
+    // How far the accumulated time is into the next step, in [0, 1).
+    f32 GetInterpolationAlpha() const;
+
+    // Positions blended between the previous and current step, destination must hold GetNodeCount() entries.
+    void WriteInterpolatedPositions(const FluidSim2D& simulation, glm::f32vec4* destination) const;
+
+    void SetOptions(FluidSimStepperOptions2D options);
+    const FluidSimStepperOptions2D& GetOptions() const;
+
+    u32 GetLastStepCount() const;
+    // Total time dropped by hitting max_steps since the last reset.
+    f64 GetDroppedTime() const;
+
+    // Forget the accumulated time and the previous positions, e.g. when the simulation is recreated.
+    void Reset();
+private:
+    void CapturePreviousPositions(const FluidSim2D& simulation);
+private:
+    FluidSimStepperOptions2D m_options;
+    f64 m_accumulator{ 0.0 };
+    f64 m_droppedTime{ 0.0 };
+    u32 m_lastStepCount{ 0 };
+
+    // Positions before the last step, indexed by node id as the simulation may reorder nodes during a step.
+    // Along with the generation of each id, nodes inserted since then have nothing to interpolate from.
+    std::vector<glm::f32vec4> m_previousPositions;
+    std::vector<u32> m_previousGenerations;
+};
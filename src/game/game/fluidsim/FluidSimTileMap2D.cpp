@@ -0,0 +1,65 @@
+#include "FluidSimTileMap2D.h"
+
+#include <bit>
+
+u32 FluidSimTileMap2D::Insert(glm::ivec2 tile_coords)
+{
+    if( (m_tileCoordinates.size() + 1) * 2 > m_keys.size() )
+        Grow();
+
+    u64 key = PackCoordinates(tile_coords);
+    u64 mask = m_keys.size() - 1;
+    for( u64 slot = GetSlot(key); ; slot = (slot + 1) & mask )
+    {
+        if( m_tileIndices[slot] == invalid_tile )
+        {
+            u32 tile_index = u32_cast(m_tileCoordinates.size());
+            m_keys[slot] = key;
+            m_tileIndices[slot] = tile_index;
+            m_tileCoordinates.push_back(tile_coords);
+            return tile_index;
+        }
+
+        if( m_keys[slot] == key )
+            return m_tileIndices[slot];
+    }
+}
+
+glm::ivec2 FluidSimTileMap2D::GetTileCoordinates(u32 tile_index) const
+{
+    return m_tileCoordinates[tile_index];
+}
+
+u32 FluidSimTileMap2D::GetTileCount() const
+{
+    return u32_cast(m_tileCoordinates.size());
+}
+
+void FluidSimTileMap2D::Clear()
+{
+    std::fill(m_tileIndices.begin(), m_tileIndices.end(), invalid_tile);
+    m_tileCoordinates.clear();
+}
+
+void FluidSimTileMap2D::Grow()
+{
+    u64 capacity = std::max<u64>(64, m_keys.size() * 2);
+    m_keys.assign(capacity, 0);
+    m_tileIndices.assign(capacity, invalid_tile);
+    m_slotShift = 64 - u32_cast(std::countr_zero(capacity));
+
+    // Tile indices are kept, only the slots move.
+    u64 mask = capacity - 1;
+    for( u32 tile_index = 0; tile_index < GetTileCount(); tile_index++ )
+    {
+        u64 key = PackCoordinates(m_tileCoordinates[tile_index]);
+        u64 slot = GetSlot(key);
+        while( m_tileIndices[slot] != invalid_tile )
+        {
+            slot = (slot + 1) & mask;
+        }
+
+        m_keys[slot] = key;
+        m_tileIndices[slot] = tile_index;
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "glm.hpp"
+
+// Open addressing hash map from tile coordinates to dense tile indices, handed out in insertion order.
+// Used by the tiled grid to find the storage of a tile without reserving space for the whole domain.
+class FluidSimTileMap2D
+{
+public:
+    static constexpr u32 invalid_tile = ~0u;
+
+    FluidSimTileMap2D() = default;
+    ~FluidSimTileMap2D() = default;
+
+    // Returns the index of the tile, or invalid_tile if it was never inserted.
+    u32 Find(glm::ivec2 tile_coords) const;
+    // Returns the index of the tile, giving it the next free index if it's new.
+    u32 Insert(glm::ivec2 tile_coords);
+
+    glm::ivec2 GetTileCoordinates(u32 tile_index) const;
+    u32 GetTileCount() const;
+
+    void Clear();
+private:
+    static u64 PackCoordinates(glm::ivec2 tile_coords);
+    u64 GetSlot(u64 key) const;
+    void Grow();
+private:
+    // Slots are empty when their tile index is invalid_tile. Capacity is a power of two kept at most half full.
+    std::vector<u64> m_keys;
+    std::vector<u32> m_tileIndices;
+    std::vector<glm::ivec2> m_tileCoordinates;
+    u32 m_slotShift{ 64 };
+};
+
+inline u64 FluidSimTileMap2D::PackCoordinates(glm::ivec2 tile_coords)
+{
+    return (u64_cast(u32_cast(tile_coords.x)) << 32) | u32_cast(tile_coords.y);
+}
+
+inline u64 FluidSimTileMap2D::GetSlot(u64 key) const
+{
+    // Fibonacci hashing, the top bits of the product depend on both coordinates.
+    return (key * 0x9e3779b97f4a7c15ull) >> m_slotShift;
+}
+
+inline u32 FluidSimTileMap2D::Find(glm::ivec2 tile_coords) const
+{
+    if( m_keys.empty() )
+        return invalid_tile;
+
+    u64 key = PackCoordinates(tile_coords);
+    u64 mask = m_keys.size() - 1;
+    for( u64 slot = GetSlot(key); ; slot = (slot + 1) & mask )
+    {
+        if( m_tileIndices[slot] == invalid_tile )
+            return invalid_tile;
+
+        if( m_keys[slot] == key )
+            return m_tileIndices[slot];
+    }
+}
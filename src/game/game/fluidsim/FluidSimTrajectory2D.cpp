@@ -0,0 +1,266 @@
+#include "FluidSimTrajectory2D.h"
+#include "system/compression.h"
+#include "threading/threading.h"
+
+namespace
+{
+
+constexpr f32 quantised_max = 65535.f;
+
+// Bytes per node in a packed frame: id, quantised x and y, velocity x and y.
+constexpr u64 packed_node_size = sizeof(u32) + sizeof(u16) * 2 + sizeof(f32) * 2;
+
+// Planar streams of a packed frame of node_count nodes, in the order they are stored. Each starts at a multiple
+// of its element size, so they can be written in place.
+struct PackedStreams
+{
+    u32* node_ids;
+    u16* quantised_x;
+    u16* quantised_y;
+    f32* velocities_x;
+    f32* velocities_y;
+};
+
+PackedStreams GetPackedStreams(u8* packed, u64 node_count)
+{
+    PackedStreams streams{ };
+    streams.node_ids = reinterpret_cast<u32*>(packed);
+    streams.quantised_x = reinterpret_cast<u16*>(streams.node_ids + node_count);
+    streams.quantised_y = streams.quantised_x + node_count;
+    streams.velocities_x = reinterpret_cast<f32*>(streams.quantised_y + node_count);
+    streams.velocities_y = streams.velocities_x + node_count;
+    return streams;
+}
+
+f64 GetSecondsSince(sys::moment start)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(sys::now() - start).count() / 1e9;
+}
+
+} //
+
+FluidSimTrajectoryWriter2D::FluidSimTrajectoryWriter2D(FluidSimTrajectoryOptions2D options) :
+    m_options(options)
+{
+    m_options.step_interval = std::max(m_options.step_interval, 1u);
+    m_options.buffer_count = std::max(m_options.buffer_count, 1u);
+}
+
+FluidSimTrajectoryWriter2D::~FluidSimTrajectoryWriter2D()
+{
+    Close();
+}
+
+bool FluidSimTrajectoryWriter2D::Open(const char* filename, const FluidSim2D& simulation)
+{
+    Close();
+
+    m_file.open(filename, std::ios::binary | std::ios::trunc);
+    if( !m_file.is_open() )
+        return false;
+
+    m_extent = simulation.GetOptions().extent;
+    FluidSimTrajectoryHeader2D header{ };
+    header.magic = FluidSimTrajectoryHeader2D::magic_value;
+    header.version = FluidSimTrajectoryHeader2D::current_version;
+    header.step_interval = m_options.step_interval;
+    header.extent = m_extent;
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Sized up front so Record is only ever a copy, unless nodes are inserted after opening.
+    u32 node_count = simulation.GetNodeCount();
+    m_frames.resize(m_options.buffer_count);
+    m_freeFrames.clear();
+    for( u32 idx = 0; idx < m_options.buffer_count; idx++ )
+    {
+        m_frames[idx].positions.reserve(node_count);
+        m_frames[idx].velocities.reserve(node_count);
+        m_frames[idx].node_ids.reserve(node_count);
+        m_freeFrames.push_back(idx);
+    }
+    m_packed.reserve(node_count * packed_node_size);
+
+    m_stepCount = 0;
+    m_stats = { };
+    m_quit = false;
+    m_thread = request_thread("FluidSimTrajectory", [this](){ ThreadLoop(); });
+    return true;
+}
+
+void FluidSimTrajectoryWriter2D::Record(const FluidSim2D& simulation)
+{
+    if( !m_thread.joinable() || ++m_stepCount % m_options.step_interval )
+        return;
+
+    sys::moment record_start = sys::now();
+    u32 frame_idx;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if( m_freeFrames.empty() )
+        {
+            m_stats.dropped_frames++;
+            return;
+        }
+
+        frame_idx = m_freeFrames.back();
+        m_freeFrames.pop_back();
+    }
+
+    Frame& frame = m_frames[frame_idx];
+    frame.step = m_stepCount;
+    frame.positions.assign(simulation.GetNodePositions().begin(), simulation.GetNodePositions().end());
+    frame.velocities.assign(simulation.GetNodeVelocities().begin(), simulation.GetNodeVelocities().end());
+    frame.node_ids.assign(simulation.GetNodeIds().begin(), simulation.GetNodeIds().end());
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queuedFrames.push_back(frame_idx);
+        m_stats.recorded_frames++;
+        m_stats.record_time += GetSecondsSince(record_start);
+    }
+    m_condition.notify_all();
+}
+
+void FluidSimTrajectoryWriter2D::Close()
+{
+    if( !m_thread.joinable() )
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_condition.notify_all();
+    m_thread.join();
+    m_file.close();
+}
+
+FluidSimTrajectoryStats2D FluidSimTrajectoryWriter2D::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void FluidSimTrajectoryWriter2D::ThreadLoop()
+{
+    while( true )
+    {
+        u32 frame_idx;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [&](){ return !m_queuedFrames.empty() || m_quit; });
+
+            // Everything queued is written before quitting.
+            if( m_queuedFrames.empty() )
+                return;
+
+            frame_idx = m_queuedFrames.front();
+            m_queuedFrames.pop_front();
+        }
+
+        WriteFrame(m_frames[frame_idx]);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_freeFrames.push_back(frame_idx);
+        }
+    }
+}
+
+void FluidSimTrajectoryWriter2D::WriteFrame(const Frame& frame)
+{
+    sys::moment write_start = sys::now();
+    u64 node_count = frame.positions.size();
+
+    FluidSimTrajectoryFrameHeader2D header{ };
+    header.step = frame.step;
+    header.node_count = u32_cast(node_count);
+    header.origin = { 0.f, 0.f };
+    header.size = m_extent;
+    if( m_extent.x <= 0.f || m_extent.y <= 0.f )
+    {
+        glm::f32vec2 min_position{ std::numeric_limits<f32>::max() };
+        glm::f32vec2 max_position{ std::numeric_limits<f32>::lowest() };
+        for( const glm::f32vec4& position : frame.positions )
+        {
+            min_position = glm::min(min_position, glm::f32vec2(position));
+            max_position = glm::max(max_position, glm::f32vec2(position));
+        }
+
+        header.origin = node_count ? min_position : glm::f32vec2{ 0.f, 0.f };
+        header.size = node_count ? max_position - min_position : glm::f32vec2{ 0.f, 0.f };
+    }
+    header.size = glm::max(header.size, glm::f32vec2{ 1e-6f });
+
+    m_packed.resize(node_count * packed_node_size);
+    PackedStreams streams = GetPackedStreams(m_packed.data(), node_count);
+    memcpy(streams.node_ids, frame.node_ids.data(), node_count * sizeof(u32));
+    for( u64 node_idx = 0; node_idx < node_count; node_idx++ )
+    {
+        glm::f32vec2 unit = glm::clamp((glm::f32vec2(frame.positions[node_idx]) - header.origin) / header.size, 0.f, 1.f);
+        streams.quantised_x[node_idx] = u16(unit.x * quantised_max + 0.5f);
+        streams.quantised_y[node_idx] = u16(unit.y * quantised_max + 0.5f);
+        streams.velocities_x[node_idx] = frame.velocities[node_idx].x;
+        streams.velocities_y[node_idx] = frame.velocities[node_idx].y;
+    }
+
+    std::vector<u8> compressed = sys::zlib_compress(m_packed, m_options.compression_level);
+    header.compressed_size = u32_cast(compressed.size());
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_file.write(reinterpret_cast<const char*>(compressed.data()), compressed.size());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.written_frames++;
+    m_stats.raw_bytes += node_count * (sizeof(glm::f32vec4) + sizeof(glm::f32vec2) + sizeof(u32));
+    m_stats.written_bytes += sizeof(header) + compressed.size();
+    m_stats.write_time += GetSecondsSince(write_start);
+}
+
+bool FluidSimTrajectoryReader2D::Open(const char* filename)
+{
+    m_file.open(filename, std::ios::binary);
+    if( !m_file.is_open() )
+        return false;
+
+    m_file.read(reinterpret_cast<char*>(&m_header), sizeof(m_header));
+    return m_file.good()
+        && m_header.magic == FluidSimTrajectoryHeader2D::magic_value
+        && m_header.version == FluidSimTrajectoryHeader2D::current_version;
+}
+
+bool FluidSimTrajectoryReader2D::ReadFrame(FluidSimTrajectoryFrame2D& frame)
+{
+    FluidSimTrajectoryFrameHeader2D header;
+    if( !m_file.read(reinterpret_cast<char*>(&header), sizeof(header)) )
+        return false;
+
+    m_compressed.resize(header.compressed_size);
+    if( !m_file.read(reinterpret_cast<char*>(m_compressed.data()), m_compressed.size()) )
+        return false;
+
+    u64 node_count = header.node_count;
+    m_packed.resize(node_count * packed_node_size);
+    if( !sys::zlib_decompress(m_compressed, m_packed) )
+        return false;
+
+    frame.step = header.step;
+    frame.positions.resize(node_count);
+    frame.velocities.resize(node_count);
+    frame.node_ids.resize(node_count);
+
+    PackedStreams streams = GetPackedStreams(m_packed.data(), node_count);
+    memcpy(frame.node_ids.data(), streams.node_ids, node_count * sizeof(u32));
+    for( u64 node_idx = 0; node_idx < node_count; node_idx++ )
+    {
+        glm::f32vec2 quantised{ streams.quantised_x[node_idx], streams.quantised_y[node_idx] };
+        frame.positions[node_idx] = header.origin + quantised / quantised_max * header.size;
+        frame.velocities[node_idx] = { streams.velocities_x[node_idx], streams.velocities_y[node_idx] };
+    }
+
+    return true;
+}
+
+const FluidSimTrajectoryHeader2D& FluidSimTrajectoryReader2D::GetHeader() const
+{
+    return m_header;
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include "FluidSim2D.h"
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <thread>
+
+// A trajectory file is a header followed by one zlib compressed frame per recorded step. Positions are quantised to
+// 16 bits per axis relative to the extent of the domain, or to the bounds of the frame when the domain is unbounded.
+// Velocities and node ids are kept exact. Each field is stored planar (every x, then every y) as that compresses best.
+struct FluidSimTrajectoryHeader2D
+{
+    static constexpr u32 magic_value = 0x32525446; // "FTR2"
+    static constexpr u32 current_version = 1;
+
+    u32 magic;
+    u32 version;
+    u32 step_interval;
+    u32 reserved;
+    glm::f32vec2 extent;
+};
+
+struct FluidSimTrajectoryFrameHeader2D
+{
+    // Steps recorded since the writer was opened, the first frame is step step_interval.
+    u64 step;
+    u32 node_count;
+    u32 compressed_size;
+    // A quantised coordinate q decodes to origin + q / 65535 * size.
+    glm::f32vec2 origin;
+    glm::f32vec2 size;
+};
+
+struct FluidSimTrajectoryOptions2D
+{
+    // Record copies the nodes once every step_interval calls.
+    u32 step_interval;
+    // Frames that can be waiting for the writer thread. Record drops the frame rather than wait when they all are.
+    u32 buffer_count;
+    // Deflate level, see sys::zlib_compress.
+    i32 compression_level;
+};
+
+struct FluidSimTrajectoryStats2D
+{
+    u32 recorded_frames;
+    u32 dropped_frames;
+    u32 written_frames;
+    // Size of the recorded node state in memory, against what ended up in the file.
+    u64 raw_bytes;
+    u64 written_bytes;
+    // Seconds spent copying in Record on the simulation thread, and quantising, compressing and writing on the writer thread.
+    f64 record_time;
+    f64 write_time;
+};
+
+// Writes a trajectory from a ring of preallocated frames, so the thread stepping the simulation only pays for a copy
+// of the node streams. Quantising, compressing and writing happen on a thread of the writer's own.
+class FluidSimTrajectoryWriter2D
+{
+public:
+    FluidSimTrajectoryWriter2D(FluidSimTrajectoryOptions2D options);
+    ~FluidSimTrajectoryWriter2D();
+
+    DELETE_COPY(FluidSimTrajectoryWriter2D);
+    DELETE_MOVE(FluidSimTrajectoryWriter2D);
+
+    // Creates the file and sizes the frames for the current node count. False if the file can't be created.
+    bool Open(const char* filename, const FluidSim2D& simulation);
+    // Called once after every step, by the thread stepping the simulation.
+    void Record(const FluidSim2D& simulation);
+    // Writes every frame still waiting then closes the file.
+    void Close();
+
+    FluidSimTrajectoryStats2D GetStats() const;
+private:
+    struct Frame
+    {
+        u64 step;
+        std::vector<glm::f32vec4> positions;
+        std::vector<glm::f32vec2> velocities;
+        std::vector<u32> node_ids;
+    };
+
+    void ThreadLoop();
+    void WriteFrame(const Frame& frame);
+private:
+    FluidSimTrajectoryOptions2D m_options;
+    glm::f32vec2 m_extent{ 0.f, 0.f };
+    std::ofstream m_file;
+    u64 m_stepCount{ 0 };
+
+    std::vector<Frame> m_frames;
+    std::vector<u32> m_freeFrames;
+    std::deque<u32> m_queuedFrames;
+    // Writer thread scratch, kept so that frames after the first don't allocate.
+    std::vector<u8> m_packed;
+
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_quit{ false };
+    FluidSimTrajectoryStats2D m_stats{ };
+};
+
+struct FluidSimTrajectoryFrame2D
+{
+    u64 step;
+    std::vector<glm::f32vec2> positions;
+    std::vector<glm::f32vec2> velocities;
+    std::vector<u32> node_ids;
+};
+
+// Reads back what FluidSimTrajectoryWriter2D wrote, one frame at a time.
+class FluidSimTrajectoryReader2D
+{
+public:
+    bool Open(const char* filename);
+    // Decodes the next frame into frame, reusing its storage. False at the end of the file or on a corrupt frame.
+    bool ReadFrame(FluidSimTrajectoryFrame2D& frame);
+
+    const FluidSimTrajectoryHeader2D& GetHeader() const;
+private:
+    std::ifstream m_file;
+    FluidSimTrajectoryHeader2D m_header{ };
+    std::vector<u8> m_compressed;
+    std::vector<u8> m_packed;
+};
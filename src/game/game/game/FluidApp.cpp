@@ -7,6 +7,22 @@
 #include "gfx_core/driver.h"
 #include "gfx_fw/program_mgr.h"
 
+#include "threading/JobDispatcher.h"
+#include "fluidsim/FluidSimSnapshot2D.h"
+
+namespace
+{
+
+// Matches the Field buffer of fluid_field_2d.frag.
+struct FieldView2D
+{
+    glm::f32vec2 origin;
+    glm::f32vec2 extent;
+    glm::f32vec4 background_color;
+};
+
+} //
+
 void FluidApp::on_event(Event& e)
 {
     Input::register_event(e);
@@ -35,6 +51,9 @@ void FluidApp::setup_update_graph(fw::scaffold_update_node& parent)
         {
             get_window().process_events();
 
+            // The simulation and everything it owns stay untouched until the step kicked last frame is done.
+            m_runner.Wait();
+
             m_imGui->begin_frame();
             update_simulation_debug();
             m_imGui->end_frame();
@@ -44,6 +63,9 @@ void FluidApp::setup_update_graph(fw::scaffold_update_node& parent)
             update_movement();
             render_simulation();
 
+            // All of our dispatches have been waited on by now, so nothing is still holding a counter. An async step
+            // may still be running, but it only uses the *_and_wait calls which don't take one from the pool.
+            JobDispatch::reset_counters();
             Input::tick();
         }));
 }
@@ -61,6 +83,8 @@ void FluidApp::setup_shutdown_graph(fw::scaffold_shutdown_node& parent)
 
 void FluidApp::initialise_app()
 {
+    JobDispatch::initialize();
+
     // Need to initialise our program stuff.
     gfx::program_mgr::initialise("C:\\Users\\Jake\\Documents\\Projects\\UnnamedGame\\src\\game\\shaderdev\\compiled\\");
     gfx::program_mgr::load("fluid_viz_basic_2d.fxcp");
@@ -71,13 +95,35 @@ void FluidApp::initialise_app()
     {
         m_programTable[idx] = m_descriptorPool.allocate();
     }
+}
+
+bool FluidApp::load_field_program()
+{
+    // The field program is only loaded once the field view is first turned on, so a missing one only costs that view.
+    if( m_fieldProgram || m_fieldProgramMissing )
+        return m_fieldProgram != nullptr;
 
+    if( !gfx::program_mgr::try_load("fluid_field_2d.fxcp") )
+    {
+        m_fieldProgramMissing = true;
+        return false;
+    }
+    m_fieldProgram = const_cast<gfx::program*>(gfx::program_mgr::find_program(dt::hash_string32("fluid_field_2d")));
+
+    m_fieldDescriptorPool.initialise(m_fieldProgram->get_pass(0).get_descriptor_table(gfx::DESCRIPTOR_TABLE_PER_FRAME), GFX_RI_FRAMES_IN_FLIGHT);
+    for( u32 idx = 0; idx < GFX_RI_FRAMES_IN_FLIGHT; idx++ )
+    {
+        m_fieldTable[idx] = m_fieldDescriptorPool.allocate();
+    }
+    return true;
 }
 
 void FluidApp::shutdown_app()
 {
     gfx::driver::wait_idle();
     GFX_CALL(destroy_descriptor_pool, &m_descriptorPool);
+    if( m_fieldProgram )
+        GFX_CALL(destroy_descriptor_pool, &m_fieldDescriptorPool);
     gfx::program_mgr::shutdown();
 }
 
@@ -86,13 +132,35 @@ void FluidApp::initialise_simulation()
     FluidSimOptions2D options{ };
     options.extent = glm::f32vec2(m_simWidth, m_simHeight);
     options.grid_extent = glm::f32vec2(m_smoothingRadius, m_smoothingRadius);
+    options.grid_mode = m_gridMode;
     options.should_bounce = m_boundryBounce;
     options.dampening_factor = m_dampeningFactor;
     options.smoothing_radius = m_smoothingRadius;
     options.target_density = m_targetDensity;
     options.pressure_multiplier = m_pressureMultiplier;
+    options.kernel = m_kernel;
+    options.precision = m_doublePrecision ? FluidSimPrecision2D::F64 : FluidSimPrecision2D::F32;
+    options.solver = m_solver;
+    options.pbf_iterations = m_pbfIterations;
+    options.pbf_relaxation = m_pbfRelaxation;
+    options.flip_ratio = m_flipRatio;
+    options.flip_pressure_iterations = m_flipPressureIterations;
+    options.flip_pressure_tolerance = m_flipPressureTolerance;
+    options.multithreaded = m_multithreaded;
+    options.simd_kernels = m_simdKernels;
+    options.neighbour_lists = m_neighbourLists;
+    options.neighbour_skin = m_neighbourSkin;
+    options.reorder_interval = m_reorderInterval;
+    options.symmetric_pressure = m_symmetricPressure;
+    options.adaptive_time_step = m_adaptiveTimeStep;
+    options.cfl_factor = m_cflFactor;
+    options.max_substeps = m_maxSubsteps;
+    options.sleeping = m_sleeping;
+    options.sleep_energy = m_sleepEnergy;
+    options.sleep_steps = m_sleepSteps;
 
     m_simulation = std::make_unique<FluidSim2D>(options);
+    m_stepper.Reset();
     m_viewport = Viewport2D({ 1200, 1200 }, { 0, 0 }, { m_simWidth, m_simHeight });
 
 
@@ -147,22 +215,143 @@ void FluidApp::initialise_simulation()
         m_programTable[idx]->write();
     }
 
+    if( m_fieldProgram )
+        initialise_field();
     distribute_nodes();
 }
 
-void FluidApp::update_simulation()
+void FluidApp::initialise_field()
+{
+    m_field = std::make_unique<FluidSimField2D>(get_field_options());
+
+    glm::uvec2 resolution = m_field->GetOptions().resolution;
+    u64 texel_count = m_field->GetTexelCount();
+    gfx::memory_info fieldBufMemInfo = gfx::memory_info::create_as_buffer(sizeof(FieldView2D), gfx::format::R32G32B32A32_SFLOAT, gfx::MEMORY_TYPE_CPU_VISIBLE, gfx::BUFFER_USAGE_STORAGE);
+    gfx::memory_info stagingBufMemInfo = gfx::memory_info::create_as_buffer(texel_count * 4, gfx::format::R8G8B8A8_SRGB, gfx::MEMORY_TYPE_CPU_VISIBLE, gfx::BUFFER_USAGE_TRANSFER_SRC);
+    gfx::memory_info textureMemInfo = gfx::memory_info::create_as_texture(texel_count, gfx::format::R8G8B8A8_SRGB, gfx::MEMORY_TYPE_GPU_ONLY, gfx::TEXTURE_USAGE_TRANSFER_DST | gfx::TEXTURE_USAGE_SAMPLED);
+    gfx::texture_info textureInfo(u16_cast(resolution.x), u16_cast(resolution.y), 1, 1);
+
+    FieldView2D field_view
+    {
+        .origin = m_field->GetOptions().origin,
+        .extent = m_field->GetOptions().extent,
+        .background_color = { 0.f, 0.f, 0.f, 1.f },
+    };
+
+    for( u32 idx = 0; idx < GFX_RI_FRAMES_IN_FLIGHT; idx++ )
+    {
+        m_fieldBuffers[idx] = new gfx::buffer;
+        *m_fieldBuffers[idx] = gfx::buffer::create(fieldBufMemInfo);
+        m_fieldBuffers[idx]->map();
+        memcpy(m_fieldBuffers[idx]->get_mapped(), &field_view, sizeof(FieldView2D));
+
+        // The field is shaded straight into the staging buffer, then copied into the texture on the GPU.
+        m_fieldStagingBuffers[idx] = new gfx::buffer;
+        *m_fieldStagingBuffers[idx] = gfx::buffer::create(stagingBufMemInfo);
+        m_fieldStagingBuffers[idx]->map();
+
+        m_fieldTextures[idx] = gfx::texture::create(textureMemInfo, textureInfo, gfx::RESOURCE_VIEW_2D);
+        m_fieldTextureViews[idx] = m_fieldTextures[idx].create_view(gfx::format::R8G8B8A8_SRGB, gfx::RESOURCE_VIEW_2D, { 0, 1, 0, 1 });
+        m_fieldSamplers[idx] = m_fieldTextureViews[idx].create_sampler();
+
+        m_fieldTable[idx]->set_buffer(dt::hash_string32("g_viewport"), m_viewportBuffers[idx]);
+        m_fieldTable[idx]->set_buffer(dt::hash_string32("g_field"), m_fieldBuffers[idx]);
+        m_fieldTable[idx]->set_image(dt::hash_string32("in_field"), &m_fieldSamplers[idx]);
+    }
+}
+
+void FluidApp::shutdown_field()
+{
+    if( !m_field )
+        return;
+
+    for( u32 idx = 0; idx < GFX_RI_FRAMES_IN_FLIGHT; idx++ )
+    {
+        gfx::texture_sampler::destroy(&m_fieldSamplers[idx]);
+        gfx::texture_view::destroy(&m_fieldTextureViews[idx]);
+        gfx::texture::destroy(&m_fieldTextures[idx]);
+
+        m_fieldStagingBuffers[idx]->unmap();
+        gfx::buffer::destroy(m_fieldStagingBuffers[idx]);
+        delete m_fieldStagingBuffers[idx];
+        m_fieldStagingBuffers[idx] = nullptr;
+
+        m_fieldBuffers[idx]->unmap();
+        gfx::buffer::destroy(m_fieldBuffers[idx]);
+        delete m_fieldBuffers[idx];
+        m_fieldBuffers[idx] = nullptr;
+    }
+
+    m_field.reset();
+}
+
+FluidSimFieldOptions2D FluidApp::get_field_options() const
 {
-    if( !m_simPaused )
+    // field_resolution texels along the longer side of the domain.
+    f32 longest = std::max(m_simWidth, m_simHeight);
+    glm::f32vec2 extent{ m_simWidth, m_simHeight };
+    return
+    {
+        .resolution = glm::max(glm::uvec2(extent / longest * f32_cast(m_fieldResolution) + 0.5f), glm::uvec2(1, 1)),
+        .origin = { 0.f, 0.f },
+        .extent = extent,
+        .splat_radius = m_fieldRadius,
+        .multithreaded = m_multithreaded,
+    };
+}
+
+FluidSimFieldShadingOptions2D FluidApp::get_field_shading() const
+{
+    FluidSimFieldShadingOptions2D shading
+    {
+        .shading = FluidSimFieldShading2D::NodeColor,
+        .background_color = { 0.f, 0.f, 0.f },
+        .surface_density = m_fieldSurfaceDensity,
+    };
+
+    // The density and velocity views shade the field itself, the others show the colours they gave the nodes.
+    if( m_visualiseType == VisualiseType::DensityView )
+    {
+        shading.shading = FluidSimFieldShading2D::Density;
+        shading.min_value = m_minDensityDisplay;
+        shading.max_value = m_maxDensityDisplay;
+        shading.min_color = m_densityMinColor;
+        shading.max_color = m_densityMaxColor;
+    }
+    else if( m_visualiseType == VisualiseType::VelocityView )
     {
-        FluidSimExternalForce2D gravity{ FluidSimExternalForceType2D::GravityForce };
-        gravity.asGravityForce.acceleration = m_gravityValue;
+        shading.shading = FluidSimFieldShading2D::Speed;
+        shading.min_value = m_minVelocityDisplay;
+        shading.max_value = m_maxVelocityDisplay;
+        shading.min_color = m_velocityMinColor;
+        shading.max_color = m_velocityMaxColor;
+    }
 
-        std::vector<FluidSimExternalForce2D> forces;
-        forces.push_back(gravity);
+    return shading;
+}
 
-        m_simulation->Simulate(fw::Time::delta_time(), forces);
+void FluidApp::update_simulation()
+{
+    FluidSimExternalForce2D gravity{ FluidSimExternalForceType2D::GravityForce };
+    gravity.asGravityForce.acceleration = m_gravityValue;
+
+    std::vector<FluidSimExternalForce2D> forces;
+    forces.push_back(gravity);
+
+    bool push = Input::get_mouse_button_down(0);
+    bool pull = Input::get_mouse_button_down(1);
+    if( (push || pull) && !ImGui::GetIO().WantCaptureMouse )
+    {
+        FluidSimExternalForce2D point{ FluidSimExternalForceType2D::PointForce };
+        point.asPointForce.position = m_mouseWorldPosition;
+        point.asPointForce.radius = m_mouseForceRadius;
+        point.asPointForce.force = push ? m_mouseForce : -m_mouseForce;
+        forces.push_back(point);
     }
 
+    if( m_fixedStep )
+        m_stepper.SetOptions({ .step_time = 1.0 / m_stepRate, .max_steps = m_maxStepsPerFrame });
+
     // Debug affects
     std::vector<FluidSimExternalDebug2D> debugs;
     if( m_visualiseType == VisualiseType::FlatColor )
@@ -208,7 +397,38 @@ void FluidApp::update_simulation()
         debugs.push_back(set_color);
     }
 
-    m_simulation->ApplyDebug(debugs);
+    // Everything the step needs is captured by value, the settings can change while it runs.
+    auto step = [this, forces = std::move(forces), debugs = std::move(debugs), delta_time = fw::Time::delta_time(),
+        paused = m_simPaused, fixed_step = m_fixedStep, publish = m_asyncSimulation]()
+        {
+            if( !paused )
+            {
+                if( fixed_step )
+                    m_stepper.Advance(*m_simulation, delta_time, forces);
+                else
+                    m_simulation->Simulate(delta_time, forces);
+            }
+
+            m_simulation->ApplyDebug(debugs);
+
+            if( publish )
+            {
+                FluidSimFrame2D& frame = m_simulation->BeginPublish();
+                if( fixed_step )
+                    m_stepper.WriteInterpolatedPositions(*m_simulation, frame.positions.data());
+                m_simulation->EndPublish();
+            }
+        };
+
+    if( !m_asyncSimulation )
+    {
+        step();
+        return;
+    }
+
+    // Render what the last step published while this one runs.
+    m_renderFrame = &m_simulation->Acquire();
+    m_runner.Kick(std::move(step));
 }
 
 void FluidApp::update_simulation_debug()
@@ -229,12 +449,36 @@ void FluidApp::update_simulation_debug()
 
     ImGui::LabelText("Delta Time", "%.2fs %.2fms %.2fus", delta_time, delta_time * 1e3, delta_time * 1e6);
     ImGui::LabelText("FPS", "%.2f", 1.0 / delta_time);
+
+    const FluidSimStats2D& sim_stats = m_simulation->GetStats();
+    f64 neighbour_visits = f64_cast(std::max(sim_stats.neighbour_count, u64(1)) * 2);
+    ImGui::LabelText("Step Time", "%.2fms", sim_stats.step_time * 1e3);
+    ImGui::LabelText("Neighbour Search", "%.2fms (%s)", sim_stats.neighbour_search_time * 1e3, sim_stats.neighbour_lists_rebuilt ? "rebuilt" : "reused");
+    ImGui::LabelText("Density Pass", "%.2fms", sim_stats.density_pass_time * 1e3);
+    ImGui::LabelText("Pressure Pass", "%.2fms", sim_stats.pressure_pass_time * 1e3);
+    if( m_solver == FluidSimSolver2D::Flip )
+        ImGui::LabelText("Pressure Solve", "%u iterations (residual %.5f)", sim_stats.pressure_iterations, sim_stats.pressure_residual);
+    ImGui::LabelText("Active Nodes", "%u / %u", sim_stats.awake_node_count, m_simulation->GetNodeCount());
+    ImGui::LabelText("Neighbours", "%llu", sim_stats.neighbour_count);
+    ImGui::LabelText("Lookup Candidates", "%llu", sim_stats.candidate_count);
+    ImGui::LabelText("Hash Collisions", "%llu", sim_stats.collision_count);
+    ImGui::LabelText("Cost Per Neighbour", "%.2fns", (sim_stats.density_pass_time + sim_stats.pressure_pass_time) * 1e9 / neighbour_visits);
+    ImGui::LabelText("Substeps", "%u (last %.2fms, max speed %.2f, max accel %.2f)", sim_stats.substep_count, sim_stats.time_step * 1e3, sim_stats.max_speed, sim_stats.max_acceleration);
+    if( m_fixedStep )
+        ImGui::LabelText("Steps", "%u (%.2fs dropped)", m_stepper.GetLastStepCount(), m_stepper.GetDroppedTime());
     ImGui::End();
 
     ImGui::Begin("Options");
 
     ImGui::SliderFloat("Gravity", &m_gravityValue, 0.f, 20.f);
     ImGui::Checkbox("Paused?", &m_simPaused);
+    ImGui::Checkbox("Fixed Step?", &m_fixedStep);
+    ImGui::Checkbox("Async Simulation?", &m_asyncSimulation);
+    if( m_fixedStep )
+    {
+        ImGui::SliderFloat("Step Rate", &m_stepRate, 10.f, 480.f);
+        ImGui::DragInt("Max Steps Per Frame", (int*)&m_maxStepsPerFrame, 1.f, 1, 32);
+    }
 
     if( ImGui::Button("Reset Simulation") )
     {
@@ -243,6 +487,18 @@ void FluidApp::update_simulation_debug()
         initialise_simulation();
     }
 
+    ImGui::InputText("Snapshot", m_snapshotPath, sizeof(m_snapshotPath));
+    if( ImGui::Button("Save Snapshot") )
+        save_snapshot();
+    ImGui::SameLine();
+    if( ImGui::Button("Load Snapshot") )
+        load_snapshot();
+
+    ImGui::InputText("Input Log", m_inputLogPath, sizeof(m_inputLogPath));
+    bool recording_input = m_recordingInput;
+    if( ImGui::Checkbox("Record Input?", &recording_input) )
+        set_recording_input(recording_input);
+
     ImGui::Checkbox("Show Node Setup", &show_dist_debug);
     ImGui::Checkbox("Display Controls", &show_controls);
     ImGui::Checkbox("Display Visualisers", &show_visual);
@@ -284,6 +540,23 @@ void FluidApp::update_simulation_debug()
             ImGui::ColorEdit3("Min Color", &m_velocityMinColor.x);
             ImGui::ColorEdit3("Max Color", &m_velocityMaxColor.x);
         }
+
+        // Draws the nodes splatted into one texture instead of a quad each, the resolution applies on the next reset.
+        if( ImGui::Checkbox("Field View?", &m_fieldView) && m_fieldView && !m_field )
+        {
+            m_fieldView = load_field_program();
+            if( m_fieldView )
+                initialise_field();
+        }
+        if( m_fieldProgramMissing )
+            ImGui::TextDisabled("fluid_field_2d.fxcp is missing, compile it with shaderdev.");
+        if( m_fieldView )
+        {
+            ImGui::DragInt("Field Resolution", (int*)&m_fieldResolution, 1.f, 16, 2048);
+            if( ImGui::SliderFloat("Field Radius", &m_fieldRadius, 0.05f, 2.f * m_smoothingRadius) )
+                m_field = std::make_unique<FluidSimField2D>(get_field_options());
+            ImGui::SliderFloat("Field Surface Density", &m_fieldSurfaceDensity, 0.f, 20.f);
+        }
         ImGui::End();
     }
 
@@ -300,6 +573,66 @@ void FluidApp::update_simulation_debug()
         if( m_boundryBounce )
             ImGui::SliderFloat("Damping Factor", &m_dampeningFactor, 0.f, 1.f);
 
+        const char* kernel_labels[4] =
+        {
+            "Spiky",
+            "Poly6",
+            "Cubic Spline",
+            "Wendland"
+        };
+        ImGui::Combo("Kernel", (int*)&m_kernel, kernel_labels, 4);
+        ImGui::Checkbox("Double Precision?", &m_doublePrecision);
+
+        const char* solver_labels[3] =
+        {
+            "SPH",
+            "Position Based",
+            "FLIP"
+        };
+        ImGui::Combo("Solver", (int*)&m_solver, solver_labels, 3);
+        if( m_solver == FluidSimSolver2D::PositionBased )
+        {
+            ImGui::DragInt("Constraint Iterations", (int*)&m_pbfIterations, 1.f, 1, 16);
+            ImGui::SliderFloat("Constraint Relaxation", &m_pbfRelaxation, 0.01f, 10.f);
+        }
+        else if( m_solver == FluidSimSolver2D::Flip )
+        {
+            ImGui::SliderFloat("FLIP Ratio", &m_flipRatio, 0.f, 1.f);
+            ImGui::DragInt("Pressure Iterations", (int*)&m_flipPressureIterations, 1.f, 1, 1000);
+            ImGui::SliderFloat("Pressure Tolerance", &m_flipPressureTolerance, 1e-5f, 1e-1f, "%.5f", ImGuiSliderFlags_Logarithmic);
+        }
+
+        ImGui::Checkbox("Multithreaded?", &m_multithreaded);
+        ImGui::Checkbox("SIMD Kernels?", &m_simdKernels);
+        ImGui::Checkbox("Neighbour Lists?", &m_neighbourLists);
+        if( m_neighbourLists )
+            ImGui::SliderFloat("Neighbour Skin", &m_neighbourSkin, 0.f, m_smoothingRadius);
+        else
+            ImGui::Checkbox("Symmetric Pressure?", &m_symmetricPressure);
+
+        const char* grid_labels[3] =
+        {
+            "Dense",
+            "Hashed",
+            "Tiled"
+        };
+        ImGui::Combo("Grid Mode", (int*)&m_gridMode, grid_labels, 3);
+        ImGui::DragInt("Reorder Interval", (int*)&m_reorderInterval, 1.f, 0, 120);
+        ImGui::Checkbox("Adaptive Time Step?", &m_adaptiveTimeStep);
+        if( m_adaptiveTimeStep )
+        {
+            ImGui::SliderFloat("CFL Factor", &m_cflFactor, 0.05f, 1.f);
+            ImGui::DragInt("Max Substeps", (int*)&m_maxSubsteps, 1.f, 1, 64);
+        }
+        ImGui::Checkbox("Sleeping?", &m_sleeping);
+        if( m_sleeping )
+        {
+            ImGui::SliderFloat("Sleep Energy", &m_sleepEnergy, 0.f, 1.f);
+            ImGui::DragInt("Sleep Steps", (int*)&m_sleepSteps, 1.f, 1, 600);
+        }
+        ImGui::SliderFloat("Mouse Force", &m_mouseForce, 0.f, 500.f);
+        ImGui::SliderFloat("Mouse Force Radius", &m_mouseForceRadius, 0.f, 10.f);
+
         distribute_nodes_debug();
         ImGui::End();
     }
@@ -315,9 +648,13 @@ void FluidApp::update_simulation_debug()
 
 void FluidApp::shutdown_simulation()
 {
+    m_runner.Wait();
+    set_recording_input(false);
+    m_renderFrame = nullptr;
     m_simulation.reset();
 
     gfx::driver::wait_idle();
+    shutdown_field();
     for( u32 idx = 0; idx < GFX_RI_FRAMES_IN_FLIGHT; idx++ )
     {
         m_nodeBuffers[idx]->unmap();
@@ -337,6 +674,50 @@ void FluidApp::shutdown_simulation()
     }
 }
 
+void FluidApp::save_snapshot()
+{
+    std::vector<u8> snapshot = m_simulation->SaveSnapshot();
+    SaveSnapshotFile(m_snapshotPath, snapshot);
+}
+
+void FluidApp::load_snapshot()
+{
+    std::vector<u8> snapshot = LoadSnapshotFile(m_snapshotPath);
+    const FluidSimSnapshotHeader2D* header = ReadSnapshotHeader(snapshot);
+    if( !header )
+        return;
+
+    // The node buffers are sized by the node count and the domain has to match, the other settings are kept.
+    m_nodeCount = header->node_count;
+    m_simWidth = header->options.extent.x;
+    m_simHeight = header->options.extent.y;
+    m_smoothingRadius = header->options.grid_extent.x;
+    m_gridMode = header->options.grid_mode;
+
+    m_simPaused = true;
+    shutdown_simulation();
+    initialise_simulation();
+    m_simulation->LoadSnapshot(snapshot);
+    m_stepper.Reset();
+}
+
+void FluidApp::set_recording_input(bool recording)
+{
+    if( recording == m_recordingInput )
+        return;
+
+    m_recordingInput = recording;
+    if( recording )
+    {
+        m_inputLog.Begin(*m_simulation, 1);
+        m_simulation->SetInputLog(&m_inputLog);
+        return;
+    }
+
+    m_simulation->SetInputLog(nullptr);
+    m_inputLog.Save(m_inputLogPath);
+}
+
 void FluidApp::render_simulation()
 {
     gfx::fw::render_interface::begin_frame();
@@ -351,6 +732,18 @@ void FluidApp::render_simulation()
     // make swapchain renderable
     RI_GraphicsContext.texture_layout_transition(texture, gfx::TEXTURE_LAYOUT_COLOR_ATTACHMENT);
 
+    if( m_fieldView )
+    {
+        // The field was shaded into this frame's staging buffer, copy it into the texture the pass samples.
+        gfx::texture* field_texture = &m_fieldTextures[frame_idx];
+        RI_GraphicsContext.texture_layout_transition(field_texture, gfx::TEXTURE_LAYOUT_TRANSFER_DST);
+        RI_GraphicsContext.copy_buffer(m_fieldStagingBuffers[frame_idx], field_texture);
+        RI_GraphicsContext.texture_layout_transition(field_texture, gfx::TEXTURE_LAYOUT_SHADER_READONLY);
+
+        // The sampler descriptor takes the texture's layout when written, so write it now it's readable.
+        m_fieldTable[frame_idx]->write();
+    }
+
     gfx::texture_attachment attachment
     {
         .view = texture_view,
@@ -359,14 +752,25 @@ void FluidApp::render_simulation()
     };
     RI_GraphicsContext.begin_rendering({ attachment }, nullptr);
 
-    RI_GraphicsContext.bind_program(m_visualiseProgram, 0);
-    RI_GraphicsContext.bind_descriptor_table(&m_visualiseProgram->get_pass(0), m_programTable[frame_idx], gfx::DESCRIPTOR_TABLE_PER_FRAME);
-
     RI_GraphicsContext.set_viewport(0.f, 0.f, f32_cast(get_window().get_extent().x), f32_cast(get_window().get_extent().y), 0.f, 1.f);
     RI_GraphicsContext.set_scissor(0, 0, u32_cast(get_window().get_extent().x), u32_cast(get_window().get_extent().y));
 
-    // We're drawing a square, 6 vertices per square.
-    RI_GraphicsContext.draw(6, m_simulation->GetNodeCount(), 0, 0);
+    if( m_fieldView )
+    {
+        // One full screen triangle, the cost only depends on the field and window resolution.
+        RI_GraphicsContext.bind_program(m_fieldProgram, 0);
+        RI_GraphicsContext.bind_descriptor_table(&m_fieldProgram->get_pass(0), m_fieldTable[frame_idx], gfx::DESCRIPTOR_TABLE_PER_FRAME);
+        RI_GraphicsContext.draw(3, 1, 0, 0);
+    }
+    else
+    {
+        RI_GraphicsContext.bind_program(m_visualiseProgram, 0);
+        RI_GraphicsContext.bind_descriptor_table(&m_visualiseProgram->get_pass(0), m_programTable[frame_idx], gfx::DESCRIPTOR_TABLE_PER_FRAME);
+
+        // We're drawing a square, 6 vertices per square.
+        u32 node_count = m_asyncSimulation ? u32_cast(m_renderFrame->positions.size()) : m_simulation->GetNodeCount();
+        RI_GraphicsContext.draw(6, node_count, 0, 0);
+    }
 
     // Render ImGui above what we've just done.
     render_simulation_debug();
@@ -388,12 +792,65 @@ void FluidApp::update_simulation_buffers()
     gfx::buffer* viewport_buffer = m_viewportBuffers[frame_idx];
     memcpy(viewport_buffer->get_mapped(), &m_viewport, sizeof(Viewport2D));
 
+    if( m_fieldView )
+    {
+        update_field_buffers();
+        return;
+    }
+
     gfx::buffer* positions_buffer = m_positionsBuffers[frame_idx];
-    memcpy(positions_buffer->get_mapped(), m_simulation->GetNodePositions().data(), m_simulation->GetNodeCount() * sizeof(glm::f32vec4));
+    gfx::buffer* node_buffer = m_nodeBuffers[frame_idx];
+    if( m_asyncSimulation )
+    {
+        // The published frame already has the interpolated positions in fixed step mode.
+        memcpy(positions_buffer->get_mapped(), m_renderFrame->positions.data(), m_renderFrame->positions.size() * sizeof(glm::f32vec4));
+        memcpy(node_buffer->get_mapped(), m_renderFrame->node_infos.data(), m_renderFrame->node_infos.size() * sizeof(FluidNodeInfo2D));
+        return;
+    }
+
+    if( m_fixedStep )
+        m_stepper.WriteInterpolatedPositions(*m_simulation, reinterpret_cast<glm::f32vec4*>(positions_buffer->get_mapped()));
+    else
+        memcpy(positions_buffer->get_mapped(), m_simulation->GetNodePositions().data(), m_simulation->GetNodeCount() * sizeof(glm::f32vec4));
 
     // Write our node buffer
-    gfx::buffer* node_buffer = m_nodeBuffers[frame_idx];
-    memcpy(node_buffer->get_mapped(), m_simulation->GetNodeInfos().data(), m_simulation->GetNodeCount() * sizeof(FluidNodeInfo2D));
+    m_simulation->WriteNodeInfos(reinterpret_cast<FluidNodeInfo2D*>(node_buffer->get_mapped()));
+}
+
+void FluidApp::update_field_buffers()
+{
+    u32 frame_idx = gfx::fw::render_interface::get_current_frame_index();
+
+    std::span<const glm::f32vec4> positions;
+    std::span<const FluidNodeInfo2D> infos;
+    if( m_asyncSimulation )
+    {
+        positions = m_renderFrame->positions;
+        infos = m_renderFrame->node_infos;
+    }
+    else
+    {
+        u32 node_count = m_simulation->GetNodeCount();
+        m_fieldInfos.resize(node_count);
+        m_simulation->WriteNodeInfos(m_fieldInfos.data());
+        infos = m_fieldInfos;
+
+        if( m_fixedStep )
+        {
+            m_fieldPositions.resize(node_count);
+            m_stepper.WriteInterpolatedPositions(*m_simulation, m_fieldPositions.data());
+            positions = m_fieldPositions;
+        }
+        else
+        {
+            positions = m_simulation->GetNodePositions();
+        }
+    }
+
+    m_field->Splat(positions, infos);
+
+    gfx::buffer* staging_buffer = m_fieldStagingBuffers[frame_idx];
+    m_field->Shade(get_field_shading(), std::span<u8>(static_cast<u8*>(staging_buffer->get_mapped()), u64_cast(m_field->GetTexelCount()) * 4));
 }
 
 void FluidApp::update_movement()
@@ -466,23 +923,20 @@ void FluidApp::update_movement()
 
 void FluidApp::distribute_nodes()
 {
-    switch( m_distributeTechnique )
+    FluidSimDistribution2D distribution
     {
-    case DistributionTechnique::Grid:
-        distribute_nodes_grid();
-        break;
-    case DistributionTechnique::Circular:
-        distribute_nodes_circular();
-        break;
-    case DistributionTechnique::Point:
-        distribute_nodes_point();
-        break;
-    case DistributionTechnique::Random:
-        distribute_nodes_random();
-        break;
-    }
+        .technique = m_distributeTechnique,
+        .node_count = m_nodeCount,
+        .node_radius = m_nodeRadius,
+        .node_color = m_nodeColor,
+        .grid_spacing = m_dngSpacing,
+        .circular_radius = m_dncRadius,
+        .circular_velocity_scale = m_dncVelocityScale,
+        .point_velocity_scale = m_dnpVelocityScale,
+        .seed = m_distributeSeed,
+    };
 
-    m_simulation->FinishInserting();
+    DistributeNodes(*m_simulation, distribution);
 }
 
 void FluidApp::distribute_nodes_debug()
@@ -497,130 +951,23 @@ void FluidApp::distribute_nodes_debug()
 
     ImGui::Combo("Technique", (int*)&m_distributeTechnique, labels, 4);
     ImGui::DragInt("Node Count", (int*)&m_nodeCount);
+    if( m_distributeTechnique != FluidSimDistributionTechnique2D::Grid )
+        ImGui::DragInt("Seed", (int*)&m_distributeSeed);
 
     switch( m_distributeTechnique )
     {
-    case DistributionTechnique::Grid:
+    case FluidSimDistributionTechnique2D::Grid:
         distribute_nodes_grid_debug();
         break;
-    case DistributionTechnique::Circular:
+    case FluidSimDistributionTechnique2D::Circular:
         distribute_nodes_circular_debug();
         break;
-    case DistributionTechnique::Point:
+    case FluidSimDistributionTechnique2D::Point:
         distribute_nodes_point_debug();
         break;
     }
 }
 
-void FluidApp::distribute_nodes_grid()
-{
-    glm::vec2 centre{ m_simWidth / 2.f, m_simHeight / 2.f };
-    u32 side_length = u32_cast(std::ceil(std::sqrt(m_nodeCount)));
-
-    glm::vec2 offset
-    {
-        side_length * m_dngSpacing / 2.f,
-        side_length * m_dngSpacing / 2.f
-    };
-
-    for( u32 y = 0; y < side_length; y++ )
-    {
-        for( u32 x = 0; x < side_length; x++ )
-        {
-            if( (y * side_length) + x >= m_nodeCount )
-                break;
-
-            glm::vec2 local_position
-            {
-                x * m_dngSpacing,
-                y * m_dngSpacing
-            };
-
-            glm::f32vec2 position = centre - offset + local_position;
-            FluidNodeInfo2D node
-            {
-                .velocity = { 0.f, 0.f },
-                .node_radius = m_nodeRadius,
-                .density = 0.f,
-                .mass = 1.f,
-                .color = m_nodeColor
-            };
-            m_simulation->InsertNode(node, position);
-        }
-    }
-}
-
-void FluidApp::distribute_nodes_circular()
-{
-    glm::vec2 centre{ m_simWidth / 2.f, m_simHeight / 2.f };
-
-    for( u32 idx = 0; idx < m_nodeCount; idx++ )
-    {
-        f32 rand_ang = (f32_cast(rand()) / RAND_MAX) * 3.14159f * 2;
-        glm::vec2 rand_vec{ f32_cast(cos(rand_ang)), f32_cast(sin(rand_ang)) };
-
-        glm::f32vec2 position = centre + (rand_vec * m_dncRadius);
-        FluidNodeInfo2D node
-        {
-            .velocity = rand_vec * m_dncVelocityScale,
-            .node_radius = m_nodeRadius,
-            .density = 0.f,
-            .mass = 1.f,
-            .color = m_nodeColor
-        };
-
-        m_simulation->InsertNode(node, position);
-    }
-}
-
-void FluidApp::distribute_nodes_point()
-{
-    glm::vec2 centre{ m_simWidth / 2.f, m_simHeight / 2.f };
-
-    for( u32 idx = 0; idx < m_nodeCount; idx++ )
-    {
-        f32 rand_ang = (f32_cast(rand()) / RAND_MAX) * 3.14159f * 2;
-        glm::vec2 rand_vec{ f32_cast(cos(rand_ang)), f32_cast(sin(rand_ang)) };
-
-        glm::f32vec2 position = centre;
-        FluidNodeInfo2D node
-        {
-            .velocity = rand_vec * m_dnpVelocityScale,
-            .node_radius = m_nodeRadius,
-            .density = 0.f,
-            .mass = 1.f,
-            .color = m_nodeColor
-        };
-
-        m_simulation->InsertNode(node, position);
-    }
-}
-
-void FluidApp::distribute_nodes_random()
-{
-    for( u32 idx = 0; idx < m_nodeCount; idx++ )
-    {
-        f32 rand0 = f32_cast(rand()) / RAND_MAX;
-        f32 rand1 = f32_cast(rand()) / RAND_MAX;
-
-        glm::f32vec2 position
-        {
-            m_simWidth * rand0,
-            m_simHeight * rand1
-        };
-        FluidNodeInfo2D node
-        {
-            .velocity = { 0.f, 0.f },
-            .node_radius = m_nodeRadius,
-            .density = 0.f,
-            .mass = 1.f,
-            .color = m_nodeColor
-        };
-
-        m_simulation->InsertNode(node, position);
-    }
-}
-
 void FluidApp::distribute_nodes_grid_debug()
 {
     ImGui::DragFloat("Spacing", &m_dngSpacing, 0.05f, m_nodeRadius * 2.f);
@@ -4,11 +4,17 @@
 #include "platform/events/WindowEvent.h"
 #include "implementations/ImGuiContext.h"
 #include "fluidsim/FluidSim2D.h"
+#include "fluidsim/FluidSimDistribution2D.h"
+#include "fluidsim/FluidSimField2D.h"
+#include "fluidsim/FluidSimStepper2D.h"
+#include "fluidsim/FluidSimRunner2D.h"
+#include "fluidsim/FluidSimInputLog2D.h"
 
 #include "Viewport2D.h"
 
 #include "gfx_fw/render_interface.h"
 #include "gfx_core/shader.h"
+#include "gfx_core/texture_sampler.h"
 
 class FluidApp : public fw::game
 {
@@ -37,24 +43,32 @@ private:
 
     void update_simulation_buffers();
 
+    // The field view splats the nodes into a fixed resolution texture, see FluidSimField2D, and draws it full screen.
+    bool load_field_program();
+    void initialise_field();
+    void shutdown_field();
+    void update_field_buffers();
+    FluidSimFieldOptions2D get_field_options() const;
+    FluidSimFieldShadingOptions2D get_field_shading() const;
+
     void update_movement();
 
-    enum class DistributionTechnique
-    {
-        Grid = 0,
-        Circular,
-        Point,
-        Random,
-    };
-    DistributionTechnique m_distributeTechnique{ DistributionTechnique::Grid };
+    // Snapshots restart a scene exactly as it was saved, see FluidSimSnapshot2D.h.
+    char m_snapshotPath[256]{ "fluidsim.snapshot" };
+    void save_snapshot();
+    void load_snapshot();
+
+    // Logs every step's forces and debug commands while recording, fluidbench -replay runs the log again without a window.
+    FluidSimInputLog2D m_inputLog;
+    bool m_recordingInput{ false };
+    char m_inputLogPath[256]{ "fluidsim.input" };
+    void set_recording_input(bool recording);
+
+    FluidSimDistributionTechnique2D m_distributeTechnique{ FluidSimDistributionTechnique2D::Grid };
+    u32 m_distributeSeed{ 1 };
     void distribute_nodes();
     void distribute_nodes_debug();
 
-    void distribute_nodes_grid();
-    void distribute_nodes_circular();
-    void distribute_nodes_point();
-    void distribute_nodes_random();
-
     u32 m_nodeCount{ 1024 };
     f32 m_nodeRadius{ 0.25f };
 
@@ -63,6 +77,27 @@ private:
     f32 m_dampeningFactor{ 0.8f };
     f32 m_targetDensity{ 8.f };
     f32 m_pressureMultiplier{ 5.f };
+    FluidSimKernel2D m_kernel{ FluidSimKernel2D::Spiky };
+    bool m_doublePrecision{ false };
+    FluidSimSolver2D m_solver{ FluidSimSolver2D::Sph };
+    u32 m_pbfIterations{ 4 };
+    f32 m_pbfRelaxation{ 1.f };
+    f32 m_flipRatio{ 0.95f };
+    u32 m_flipPressureIterations{ 200 };
+    f32 m_flipPressureTolerance{ 1e-3f };
+    bool m_multithreaded{ true };
+    bool m_simdKernels{ true };
+    bool m_neighbourLists{ false };
+    f32 m_neighbourSkin{ 0.1f };
+    FluidSimGridMode2D m_gridMode{ FluidSimGridMode2D::Dense };
+    u32 m_reorderInterval{ 8 };
+    bool m_symmetricPressure{ true };
+    bool m_adaptiveTimeStep{ false };
+    f32 m_cflFactor{ 0.4f };
+    u32 m_maxSubsteps{ 8 };
+    bool m_sleeping{ false };
+    f32 m_sleepEnergy{ 0.01f };
+    u32 m_sleepSteps{ 30 };
 
     f32 m_dngSpacing{ 0.30f };
     void distribute_nodes_grid_debug();
@@ -79,6 +114,11 @@ private:
 private:
     std::unique_ptr<mygui::Context> m_imGui;
     std::unique_ptr<FluidSim2D> m_simulation;
+    FluidSimStepper2D m_stepper{ { .step_time = 1.0 / 120.0, .max_steps = 4 } };
+    // Async mode steps the simulation on the runner's thread while the frame it published last is rendered.
+    FluidSimRunner2D m_runner;
+    bool m_asyncSimulation{ false };
+    const FluidSimFrame2D* m_renderFrame{ nullptr };
 
     // Settings
     bool m_simPaused{ true };
@@ -86,6 +126,11 @@ private:
     f32 m_simHeight{ 20.f };
 
     f32 m_gravityValue{ 0.f };
+
+    // Fixed step mode runs the simulation at m_stepRate steps per second, instead of once per frame with the frame time.
+    bool m_fixedStep{ true };
+    f32 m_stepRate{ 120.f };
+    u32 m_maxStepsPerFrame{ 4 };
     Viewport2D m_viewport;
 
     f32 m_moveSensitivity{ 1000.f };
@@ -102,6 +147,9 @@ private:
     glm::f32vec3 m_nodeColor{ 1.f, 1.f, 1.f };
     glm::f32vec3 m_paintColor{ 1.f, 0.f, 0.f };
     f32 m_paintRadius{ 1.5f };
+    // Holding the left (push) or right (pull) mouse button applies a point force at the cursor.
+    f32 m_mouseForce{ 50.f };
+    f32 m_mouseForceRadius{ 2.f };
     f32 m_minDensityDisplay{ 7.f };
     f32 m_maxDensityDisplay{ 9.f };
     glm::f32vec3 m_densityMinColor{ 0.f, 0.f, 1.f };
@@ -110,6 +158,10 @@ private:
     f32 m_maxVelocityDisplay{ 10.f };
     glm::f32vec3 m_velocityMinColor{ 0.f, 0.f, 1.f };
     glm::f32vec3 m_velocityMaxColor{ 1.f, 0.f, 0.f };
+    bool m_fieldView{ false };
+    u32 m_fieldResolution{ 512 };
+    f32 m_fieldRadius{ 1.f };
+    f32 m_fieldSurfaceDensity{ 4.f };
 
     glm::f32vec2 m_mouseWorldPosition{ };
 
@@ -121,4 +173,17 @@ private:
     gfx::buffer* m_viewportBuffers[GFX_RI_FRAMES_IN_FLIGHT];
     gfx::buffer* m_positionsBuffers[GFX_RI_FRAMES_IN_FLIGHT];
     gfx::buffer* m_nodeBuffers[GFX_RI_FRAMES_IN_FLIGHT];
+
+    std::unique_ptr<FluidSimField2D> m_field;
+    std::vector<glm::f32vec4> m_fieldPositions;
+    std::vector<FluidNodeInfo2D> m_fieldInfos;
+    gfx::program* m_fieldProgram{ nullptr };
+    bool m_fieldProgramMissing{ false };
+    gfx::descriptor_pool m_fieldDescriptorPool;
+    gfx::descriptor_table* m_fieldTable[GFX_RI_FRAMES_IN_FLIGHT];
+    gfx::buffer* m_fieldBuffers[GFX_RI_FRAMES_IN_FLIGHT];
+    gfx::buffer* m_fieldStagingBuffers[GFX_RI_FRAMES_IN_FLIGHT];
+    gfx::texture m_fieldTextures[GFX_RI_FRAMES_IN_FLIGHT];
+    gfx::texture_view m_fieldTextureViews[GFX_RI_FRAMES_IN_FLIGHT];
+    gfx::texture_sampler m_fieldSamplers[GFX_RI_FRAMES_IN_FLIGHT];
 };
\ No newline at end of file
@@ -45,6 +45,12 @@ const program* program_mgr::find_program(dt::hash_string32 name)
 }
 
 void program_mgr::load(const char* path)
+{
+    if( !try_load(path) )
+        GFX_ASSERT(false, "Unable to load program path {}", path);
+}
+
+bool program_mgr::try_load(const char* path)
 {
     // Actually load our program so that we can check the name vs what we've got loaded.
     // I don't want to rely on the name of the file to validate this so fuck it these are like
@@ -57,7 +63,7 @@ void program_mgr::load(const char* path)
     {
         program_def program_def{ };
         if( !shader_loader::load(fullPath.c_str(), &program_def) )
-            GFX_ASSERT(false, "Unable to load program path {}", path);
+            return false;
 
         prog = dt::make_unique<program>(convert_from(program_def));
     }
@@ -83,6 +89,8 @@ void program_mgr::load(const char* path)
         pass.set_layout_impl(GFX_CALL(create_shader_pass_layout_impl, &pass));
         pass.set_impl(GFX_CALL(create_shader_pass_impl, pProgram, passIdx));
     }
+
+    return true;
 }
 
 program* program_mgr::insert(dt::unique_ptr<program>&& prog)
@@ -43,6 +43,8 @@ public:
 
     static const program* find_program(dt::hash_string32 name);
     static void load(const char* path);
+    // Like load but returns false instead of asserting when the program file can't be read, for optional programs.
+    static bool try_load(const char* path);
 private:
     static program* insert(dt::unique_ptr<program>&& prog);
     static program convert_from(const program_def& program_def);
@@ -0,0 +1,28 @@
+#version 450
+
+// Region of the simulation the field texture covers, see FluidSimField2D.
+layout (std140, set = 0, binding = 1) readonly buffer Field
+{
+	vec2 origin;
+	vec2 extent;
+	vec4 background_color;
+} g_field;
+
+layout (set = 0, binding = 2) uniform sampler2D in_field;
+
+layout (location = 0) in vec2 fin_worldPosition;
+
+layout (location = 0) out vec4 out_fragColor;
+
+void main()
+{
+  vec2 uv = (fin_worldPosition - g_field.origin) / g_field.extent;
+  if(any(lessThan(uv, vec2(0.0))) || any(greaterThan(uv, vec2(1.0))))
+  {
+    out_fragColor = g_field.background_color;
+    return;
+  }
+
+  // The first row of the field is the top of the region.
+  out_fragColor = texture(in_field, vec2(uv.x, 1.0 - uv.y));
+}
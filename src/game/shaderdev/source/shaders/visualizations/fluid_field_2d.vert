@@ -0,0 +1,32 @@
+#version 450
+
+layout (std140, set = 0, binding = 0) readonly buffer Viewport
+{
+	vec2 screen_extent;
+	vec2 view_position;
+	vec2 view_extent;
+	vec2 padding;
+} g_viewport;
+
+layout (location = 0) out vec2 fin_worldPosition;
+
+// One triangle covering the screen, clip space from -1 to 3.
+const vec2 triangle_positions[3] = vec2[3](
+  vec2(-1.0, -1.0),
+  vec2(3.0, -1.0),
+  vec2(-1.0, 3.0)
+);
+
+// Inverse of transform_to_clip in fluid_viz_basic_2d.vert.
+vec2 transform_to_world(vec2 clipspace)
+{
+	vec2 local = ((clipspace * vec2(1.0, -1.0)) + vec2(1.0, 1.0)) * 0.5;
+	return (local * g_viewport.view_extent) - g_viewport.view_position;
+}
+
+void main()
+{
+  vec2 clip_position = triangle_positions[gl_VertexIndex];
+  gl_Position = vec4(clip_position, 0.0, 1.0);
+  fin_worldPosition = transform_to_world(clip_position);
+}